@@ -0,0 +1,614 @@
+/*
+    inflate - streaming gzip (RFC 1952) decoder over deflate (RFC 1951), see inflate.h
+
+    The decoder pulls its input through a 64-bit bit buffer that is refilled from the file as
+    needed, so decoding never has to stop for input. It only stops when the caller's buffer is
+    full, between two symbols or in the middle of a stored block or a match, and picks up there
+    on the next call. Huffman codes are decoded with one table lookup: each table has an entry
+    for every value of its longest code's bits.
+*/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "inflate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INFLATE_INPUT_SIZE (1 << 16)
+#define INFLATE_WINDOW_SIZE (1 << 15)
+#define INFLATE_MAX_BITS 15
+
+enum
+{
+	INFLATE_HEADER,
+	INFLATE_BLOCK,
+	INFLATE_STORED,
+	INFLATE_HUFFMAN,
+	INFLATE_TRAILER,
+	INFLATE_DONE,
+	INFLATE_ERROR
+};
+
+/* a decoded symbol that is not one, every caller range checks it */
+#define INFLATE_BAD_SYMBOL 0xffffu
+
+static const uint16_t lengthBase[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t lengthExtra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t distanceBase[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t distanceExtra[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static const uint8_t codeLengthOrder[19] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+struct inflate_file
+{
+	FILE* fp;
+	uint64_t fileRead;			/* bytes read from fp */
+
+	unsigned char input[INFLATE_INPUT_SIZE];
+	size_t inputPos;
+	size_t inputEnd;
+
+	/* bits not decoded yet, lowest first. Past the end of the file it is filled with zero bytes,
+	   counted in padding, so reading past the end shows as bitCount < 8 * padding. */
+	uint64_t bitBuffer;
+	unsigned bitCount;
+	unsigned padding;
+
+	int state;
+	int lastBlock;
+	const char* error;
+
+	/* the last 32 KiB of output, matches copy from here */
+	unsigned char window[INFLATE_WINDOW_SIZE];
+	uint32_t windowPos;
+
+	uint64_t memberSize;		/* bytes of output of the current member */
+	uint32_t crc;
+	uint32_t crcTable[256];
+
+	unsigned stored;			/* bytes left of the current stored block */
+	unsigned copyLength;		/* bytes left of the current match */
+	unsigned copyDistance;
+
+	/* symbol << 4 | code length, 0 where there is no code */
+	uint16_t literalTable[1 << INFLATE_MAX_BITS];
+	uint16_t distanceTable[1 << INFLATE_MAX_BITS];
+	unsigned literalBits;
+	unsigned distanceBits;
+};
+
+static void fail(inflate_file* f, const char* error)
+{
+	if (f->state != INFLATE_ERROR)
+		f->error = error;
+
+	f->state = INFLATE_ERROR;
+}
+
+static int pastEnd(const inflate_file* f)
+{
+	return f->bitCount < 8u * f->padding;
+}
+
+static void refill(inflate_file* f)
+{
+	while (f->bitCount <= 56)
+	{
+		if (f->inputPos == f->inputEnd)
+		{
+			f->inputPos = 0;
+			f->inputEnd = fread(f->input, 1, INFLATE_INPUT_SIZE, f->fp);
+			f->fileRead += f->inputEnd;
+
+			if (f->inputEnd == 0)
+			{
+				f->bitCount += 8;
+				f->padding++;
+				continue;
+			}
+		}
+
+		f->bitBuffer |= (uint64_t)f->input[f->inputPos++] << f->bitCount;
+		f->bitCount += 8;
+	}
+}
+
+/* n <= 32 */
+static uint32_t getBits(inflate_file* f, unsigned n)
+{
+	uint32_t bits;
+
+	if (f->bitCount < n)
+		refill(f);
+
+	bits = (uint32_t)(f->bitBuffer & ((1ull << n) - 1));
+	f->bitBuffer >>= n;
+	f->bitCount -= n;
+	return bits;
+}
+
+static void alignToByte(inflate_file* f)
+{
+	getBits(f, f->bitCount & 7);
+}
+
+static unsigned decode(inflate_file* f, const uint16_t* table, unsigned tableBits)
+{
+	unsigned entry;
+
+	if (f->bitCount < tableBits)
+		refill(f);
+
+	entry = table[f->bitBuffer & ((1u << tableBits) - 1)];
+
+	if ((entry & 15) == 0)
+		return INFLATE_BAD_SYMBOL;
+
+	f->bitBuffer >>= entry & 15;
+	f->bitCount -= entry & 15;
+	return entry >> 4;
+}
+
+/* canonical Huffman codes of the given lengths into a table, 0 if they are oversubscribed */
+static int buildTable(uint16_t* table, unsigned* tableBits, const uint8_t* lengths, unsigned count)
+{
+	unsigned lengthCount[INFLATE_MAX_BITS + 1] = { 0 };
+	unsigned nextCode[INFLATE_MAX_BITS + 1];
+	unsigned maxLength = 1;
+	unsigned code = 0;
+	int left = 1;
+	unsigned symbol, length, size;
+
+	for (symbol = 0; symbol < count; symbol++)
+	{
+		lengthCount[lengths[symbol]]++;
+
+		if (lengths[symbol] > maxLength)
+			maxLength = lengths[symbol];
+	}
+
+	lengthCount[0] = 0;
+
+	for (length = 1; length <= INFLATE_MAX_BITS; length++)
+	{
+		left = (left << 1) - (int)lengthCount[length];
+
+		if (left < 0)
+			return 0;
+
+		code = (code + lengthCount[length - 1]) << 1;
+		nextCode[length] = code;
+	}
+
+	size = 1u << maxLength;
+	memset(table, 0, size * sizeof(uint16_t));
+
+	for (symbol = 0; symbol < count; symbol++)
+	{
+		unsigned reversed = 0;
+		unsigned i;
+
+		length = lengths[symbol];
+
+		if (length == 0)
+			continue;
+
+		/* deflate sends codes from their top bit, the bit buffer is read from its lowest */
+		code = nextCode[length]++;
+
+		for (i = 0; i < length; i++)
+			reversed |= ((code >> i) & 1) << (length - 1 - i);
+
+		for (i = reversed; i < size; i += 1u << length)
+			table[i] = (uint16_t)(symbol << 4 | length);
+	}
+
+	*tableBits = maxLength;
+	return 1;
+}
+
+static void readHeader(inflate_file* f)
+{
+	unsigned flags;
+	unsigned i;
+
+	if (getBits(f, 8) != 0x1f || getBits(f, 8) != 0x8b)
+	{
+		fail(f, "not a gzip file");
+		return;
+	}
+
+	if (getBits(f, 8) != 8)
+	{
+		fail(f, "unknown compression method");
+		return;
+	}
+
+	flags = getBits(f, 8);
+	getBits(f, 32);		/* modification time */
+	getBits(f, 16);		/* extra flags, operating system */
+
+	if (flags & 4)
+	{
+		unsigned extra = getBits(f, 16);
+
+		for (i = 0; i < extra && !pastEnd(f); i++)
+			getBits(f, 8);
+	}
+
+	/* file name, comment */
+	if (flags & 8)
+		while (getBits(f, 8) != 0 && !pastEnd(f));
+	if (flags & 16)
+		while (getBits(f, 8) != 0 && !pastEnd(f));
+
+	/* header CRC */
+	if (flags & 2)
+		getBits(f, 16);
+
+	f->crc = 0xffffffffu;
+	f->memberSize = 0;
+	f->state = INFLATE_BLOCK;
+}
+
+static void readDynamicTables(inflate_file* f)
+{
+	uint8_t lengths[286 + 30];
+	unsigned literalCount = getBits(f, 5) + 257;
+	unsigned distanceCount = getBits(f, 5) + 1;
+	unsigned codeLengthCount = getBits(f, 4) + 4;
+	unsigned codeLengthBits;
+	unsigned n = 0;
+	unsigned i;
+
+	if (literalCount > 286 || distanceCount > 30)
+	{
+		fail(f, "too many length or distance codes");
+		return;
+	}
+
+	memset(lengths, 0, sizeof(lengths));
+
+	for (i = 0; i < codeLengthCount; i++)
+		lengths[codeLengthOrder[i]] = (uint8_t)getBits(f, 3);
+
+	/* the code length code is decoded from distanceTable, which is built last */
+	if (!buildTable(f->distanceTable, &codeLengthBits, lengths, 19))
+	{
+		fail(f, "invalid code length code");
+		return;
+	}
+
+	while (n < literalCount + distanceCount)
+	{
+		unsigned symbol = decode(f, f->distanceTable, codeLengthBits);
+		unsigned repeat;
+		uint8_t length = 0;
+
+		if (symbol < 16)
+		{
+			lengths[n++] = (uint8_t)symbol;
+			continue;
+		}
+
+		if (symbol == 16)
+		{
+			if (n == 0)
+			{
+				fail(f, "repeated code length without a first one");
+				return;
+			}
+
+			length = lengths[n - 1];
+			repeat = 3 + getBits(f, 2);
+		}
+		else if (symbol == 17)
+			repeat = 3 + getBits(f, 3);
+		else if (symbol == 18)
+			repeat = 11 + getBits(f, 7);
+		else
+		{
+			fail(f, "invalid code length");
+			return;
+		}
+
+		if (n + repeat > literalCount + distanceCount)
+		{
+			fail(f, "code lengths run past their count");
+			return;
+		}
+
+		while (repeat--)
+			lengths[n++] = length;
+	}
+
+	if (lengths[256] == 0)
+	{
+		fail(f, "no end of block code");
+		return;
+	}
+
+	if (!buildTable(f->literalTable, &f->literalBits, lengths, literalCount) ||
+		!buildTable(f->distanceTable, &f->distanceBits, lengths + literalCount, distanceCount))
+	{
+		fail(f, "invalid literal or distance code");
+		return;
+	}
+
+	f->state = INFLATE_HUFFMAN;
+}
+
+static void readBlockHeader(inflate_file* f)
+{
+	unsigned type;
+
+	f->lastBlock = (int)getBits(f, 1);
+	type = getBits(f, 2);
+
+	if (type == 0)
+	{
+		unsigned length, complement;
+
+		alignToByte(f);
+		length = getBits(f, 16);
+		complement = getBits(f, 16);
+
+		if (length != (~complement & 0xffffu))
+		{
+			fail(f, "stored block length does not match its complement");
+			return;
+		}
+
+		f->stored = length;
+		f->state = INFLATE_STORED;
+	}
+	else if (type == 1)
+	{
+		uint8_t lengths[288];
+		unsigned i;
+
+		for (i = 0; i < 144; i++)
+			lengths[i] = 8;
+		for (; i < 256; i++)
+			lengths[i] = 9;
+		for (; i < 280; i++)
+			lengths[i] = 7;
+		for (; i < 288; i++)
+			lengths[i] = 8;
+
+		buildTable(f->literalTable, &f->literalBits, lengths, 288);
+
+		for (i = 0; i < 30; i++)
+			lengths[i] = 5;
+
+		buildTable(f->distanceTable, &f->distanceBits, lengths, 30);
+		f->state = INFLATE_HUFFMAN;
+	}
+	else if (type == 2)
+		readDynamicTables(f);
+	else
+		fail(f, "invalid block type");
+}
+
+static void readTrailer(inflate_file* f)
+{
+	uint32_t crc, size;
+
+	alignToByte(f);
+	crc = getBits(f, 32);
+	size = getBits(f, 32);
+
+	if (pastEnd(f))
+		return;
+
+	if (crc != ~f->crc)
+	{
+		fail(f, "CRC mismatch");
+		return;
+	}
+
+	if (size != (uint32_t)f->memberSize)
+	{
+		fail(f, "length mismatch");
+		return;
+	}
+
+	/* another member follows, or whatever is left is not gzip and ends the data */
+	refill(f);
+	f->state = f->bitCount >= 8u * f->padding + 16 && (f->bitBuffer & 0xffff) == 0x8b1f ? INFLATE_HEADER : INFLATE_DONE;
+}
+
+static void put(inflate_file* f, unsigned char** out, unsigned char byte)
+{
+	*(*out)++ = byte;
+	f->window[f->windowPos++ & (INFLATE_WINDOW_SIZE - 1)] = byte;
+}
+
+static unsigned char* inflateHuffman(inflate_file* f, unsigned char* out, unsigned char* end)
+{
+	while (out < end)
+	{
+		unsigned symbol;
+
+		if (f->copyLength)
+		{
+			uint32_t from = f->windowPos - f->copyDistance;
+
+			while (f->copyLength && out < end)
+			{
+				put(f, &out, f->window[from++ & (INFLATE_WINDOW_SIZE - 1)]);
+				f->copyLength--;
+				f->memberSize++;
+			}
+
+			continue;
+		}
+
+		symbol = decode(f, f->literalTable, f->literalBits);
+
+		if (symbol < 256)
+		{
+			put(f, &out, (unsigned char)symbol);
+			f->memberSize++;
+		}
+		else if (symbol == 256)
+		{
+			f->state = f->lastBlock ? INFLATE_TRAILER : INFLATE_BLOCK;
+			break;
+		}
+		else if (symbol < 286)
+		{
+			unsigned length = lengthBase[symbol - 257] + getBits(f, lengthExtra[symbol - 257]);
+			unsigned distanceSymbol = decode(f, f->distanceTable, f->distanceBits);
+			unsigned distance;
+
+			if (distanceSymbol >= 30)
+			{
+				fail(f, "invalid distance code");
+				break;
+			}
+
+			distance = distanceBase[distanceSymbol] + getBits(f, distanceExtra[distanceSymbol]);
+
+			if (distance > f->memberSize)
+			{
+				fail(f, "distance too far back");
+				break;
+			}
+
+			f->copyLength = length;
+			f->copyDistance = distance;
+		}
+		else
+		{
+			fail(f, "invalid literal or length code");
+			break;
+		}
+
+		if (pastEnd(f))
+			break;
+	}
+
+	return out;
+}
+
+static uint32_t updateCrc(const inflate_file* f, uint32_t crc, const unsigned char* data, size_t size)
+{
+	while (size--)
+		crc = f->crcTable[(crc ^ *data++) & 0xff] ^ (crc >> 8);
+
+	return crc;
+}
+
+inflate_file* inflate_open(const char* path)
+{
+	inflate_file* f;
+	uint32_t i;
+
+	f = (inflate_file*)calloc(1, sizeof(inflate_file));
+
+	if (!f)
+		return NULL;
+
+	f->fp = fopen(path, "rb");
+
+	if (!f->fp)
+	{
+		free(f);
+		return NULL;
+	}
+
+	for (i = 0; i < 256; i++)
+	{
+		uint32_t c = i;
+		int k;
+
+		for (k = 0; k < 8; k++)
+			c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+
+		f->crcTable[i] = c;
+	}
+
+	f->state = INFLATE_HEADER;
+	return f;
+}
+
+ptrdiff_t inflate_read(inflate_file* f, void* dst, size_t size)
+{
+	unsigned char* out = (unsigned char*)dst;
+	unsigned char* end = out + size;
+	unsigned char* checked = out;	/* output before this is in f->crc */
+
+	while (out < end && f->state != INFLATE_DONE && f->state != INFLATE_ERROR)
+	{
+		switch (f->state)
+		{
+		case INFLATE_HEADER:
+			readHeader(f);
+			break;
+		case INFLATE_BLOCK:
+			readBlockHeader(f);
+			break;
+		case INFLATE_STORED:
+			while (f->stored && out < end)
+			{
+				put(f, &out, (unsigned char)getBits(f, 8));
+				f->stored--;
+				f->memberSize++;
+			}
+
+			if (!f->stored)
+				f->state = f->lastBlock ? INFLATE_TRAILER : INFLATE_BLOCK;
+			break;
+		case INFLATE_HUFFMAN:
+			out = inflateHuffman(f, out, end);
+			break;
+		case INFLATE_TRAILER:
+			f->crc = updateCrc(f, f->crc, checked, out - checked);
+			checked = out;
+			readTrailer(f);
+			break;
+		}
+
+		if (pastEnd(f))
+			fail(f, "unexpected end of file");
+	}
+
+	f->crc = updateCrc(f, f->crc, checked, out - checked);
+
+	if (f->state == INFLATE_ERROR)
+		return -1;
+
+	return out - (unsigned char*)dst;
+}
+
+uint64_t inflate_offset(const inflate_file* f)
+{
+	uint64_t bits = f->bitCount / 8 > f->padding ? f->bitCount / 8 - f->padding : 0;
+	uint64_t buffered = (f->inputEnd - f->inputPos) + bits;
+	return f->fileRead > buffered ? f->fileRead - buffered : 0;
+}
+
+const char* inflate_error(const inflate_file* f)
+{
+	return f->state == INFLATE_ERROR ? f->error : NULL;
+}
+
+void inflate_close(inflate_file* f)
+{
+	if (!f)
+		return;
+
+	fclose(f->fp);
+	free(f);
+}
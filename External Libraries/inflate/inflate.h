@@ -0,0 +1,42 @@
+/*
+    inflate - streaming gzip (RFC 1952) decoder over deflate (RFC 1951)
+
+    Reads the file in 64 KiB chunks and decodes on demand into the caller's buffer, so memory
+    use stays at a few hundred KiB whatever the size of the file. Concatenated gzip members
+    are decoded one after another, anything after the last member is ignored, as gzread does.
+    Every member's CRC-32 and length are checked against its trailer.
+
+    No dependencies beyond the C standard library. Compile inflate.c with the project.
+*/
+
+#ifndef INFLATE_H
+#define INFLATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct inflate_file inflate_file;
+
+/* NULL if the file can not be opened or memory runs out */
+inflate_file* inflate_open(const char* path);
+
+/* up to size decompressed bytes into dst; 0 at the end of the data, -1 if it is not valid gzip */
+ptrdiff_t inflate_read(inflate_file* file, void* dst, size_t size);
+
+/* bytes of the compressed file decoded so far */
+uint64_t inflate_offset(const inflate_file* file);
+
+/* why the last inflate_read failed, NULL if it did not */
+const char* inflate_error(const inflate_file* file);
+
+void inflate_close(inflate_file* file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -5,17 +5,33 @@
 #include <cstdint>
 #include <stdexcept>
 #include <iostream>
+#include <memory>
+#include <thread>
+#include <chrono>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-class OpenVRPart
+// The few IVRSystem/IVRCompositor calls the renderer needs. OpenVRBackend forwards them to the
+// runtime, MockVRBackend answers them itself so the stereo path runs without a headset.
+class VRBackend
 {
-	vr::IVRSystem* hmd;
-	uint32_t rtWidth, rtHeight;
+public:
+	virtual ~VRBackend() { }
+
+	virtual void GetRecommendedRenderTargetSize(uint32_t* width, uint32_t* height) = 0;
+	virtual vr::HmdMatrix34_t GetEyeToHeadTransform(vr::EVREye eye) = 0;
+	virtual vr::HmdMatrix44_t GetProjectionMatrix(vr::EVREye eye, float nearZ, float farZ) = 0;
+	virtual void WaitGetPoses(vr::TrackedDevicePose_t* poses, uint32_t count) = 0;
+	virtual void Submit(vr::EVREye eye, const vr::Texture_t* texture, const vr::VRTextureBounds_t* bounds, vr::EVRSubmitFlags flags) = 0;
+	virtual void PostPresentHandoff() = 0;
+};
 
-	OpenVRPart() : hmd(NULL), rtWidth(0), rtHeight(0)
+class OpenVRBackend : public VRBackend
+{
+public:
+	OpenVRBackend() : hmd(NULL)
 	{
 		if (!isHmdPresent())
 		{
@@ -33,10 +49,15 @@ class OpenVRPart
 		{
 			throw std::runtime_error("Unable to initialize VR compositor!\n");
 		}
+	}
 
-		hmd->GetRecommendedRenderTargetSize(&rtWidth, &rtHeight);
-
-		std::cout << "Initialized HMD with render target width : " << rtWidth << ", height: " << rtHeight << std::endl;
+	~OpenVRBackend()
+	{
+		if (hmd)
+		{
+			vr::VR_Shutdown();
+			hmd = NULL;
+		}
 	}
 
 	inline static bool isHmdPresent()
@@ -44,6 +65,39 @@ class OpenVRPart
 		return vr::VR_IsHmdPresent();
 	}
 
+	void GetRecommendedRenderTargetSize(uint32_t* width, uint32_t* height) override
+	{
+		hmd->GetRecommendedRenderTargetSize(width, height);
+	}
+
+	vr::HmdMatrix34_t GetEyeToHeadTransform(vr::EVREye eye) override
+	{
+		return hmd->GetEyeToHeadTransform(eye);
+	}
+
+	vr::HmdMatrix44_t GetProjectionMatrix(vr::EVREye eye, float nearZ, float farZ) override
+	{
+		return hmd->GetProjectionMatrix(eye, nearZ, farZ);
+	}
+
+	void WaitGetPoses(vr::TrackedDevicePose_t* poses, uint32_t count) override
+	{
+		vr::VRCompositor()->WaitGetPoses(poses, count, nullptr, 0);
+	}
+
+	void Submit(vr::EVREye eye, const vr::Texture_t* texture, const vr::VRTextureBounds_t* bounds, vr::EVRSubmitFlags flags) override
+	{
+		vr::VRCompositor()->Submit(eye, texture, bounds, flags);
+	}
+
+	void PostPresentHandoff() override
+	{
+		vr::VRCompositor()->PostPresentHandoff();
+	}
+
+private:
+	vr::IVRSystem* hmd;
+
 	void handleVRError(vr::EVRInitError err)
 	{
 		throw std::runtime_error(vr::VR_GetVRInitErrorAsEnglishDescription(err));
@@ -64,24 +118,6 @@ class OpenVRPart
 		std::cout << GetTrackedDeviceString(hmd, vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_SerialNumber_String) << std::endl;
 	}
 
-	void submitFramesToOpenVR(GLint leftEyeImg, GLint rightEyeImg, bool linear = false)
-	{
-		if (!hmd)
-			throw std::runtime_error("Error submitting frames, HMD is NULL");
-
-		vr::TrackedDevicePose_t trackedDevicePose[vr::k_unMaxTrackedDeviceCount];
-		vr::VRCompositor()->WaitGetPoses(trackedDevicePose, vr::k_unMaxTrackedDeviceCount, nullptr, 0);
-
-
-		vr::Texture_t leftEyeImage = { (void*)leftEyeImg, vr::TextureType_OpenGL, vr::ColorSpace_Gamma };
-		vr::Texture_t rightEyeImage = { (void*)rightEyeImg, vr::TextureType_OpenGL, vr::ColorSpace_Gamma };
-
-		vr::VRCompositor()->Submit(vr::Eye_Left, &leftEyeImage);
-		vr::VRCompositor()->Submit(vr::Eye_Right, &rightEyeImage);
-
-		vr::VRCompositor()->PostPresentHandoff();
-	}
-
 	std::string GetTrackedDeviceString(vr::IVRSystem* pHmd, vr::TrackedDeviceIndex_t unDevice, vr::TrackedDeviceProperty prop, vr::TrackedPropertyError* peError = NULL)
 	{
 		uint32_t unRequiredBufferLen = pHmd->GetStringTrackedDeviceProperty(unDevice, prop, NULL, 0, peError);
@@ -95,13 +131,177 @@ class OpenVRPart
 		delete[] pchBuffer;
 		return sResult;
 	}
+};
+
+// Behaves like a headset with a symmetric 100 degree field of view per eye. Submissions are only
+// counted, WaitGetPoses returns immediately unless a refresh rate is set.
+class MockVRBackend : public VRBackend
+{
+public:
+	uint32_t width = 1852;
+	uint32_t height = 2056;
+	float ipd = 0.064f;
+	float fovDegrees = 100.0f;
+	double refreshRate = 0.0;	// 0 = never block in WaitGetPoses
+
+	unsigned long long submittedFrames = 0;
+	unsigned long long submittedImages = 0;
+
+	void GetRecommendedRenderTargetSize(uint32_t* w, uint32_t* h) override
+	{
+		*w = width;
+		*h = height;
+	}
+
+	vr::HmdMatrix34_t GetEyeToHeadTransform(vr::EVREye eye) override
+	{
+		vr::HmdMatrix34_t m = {};
+		m.m[0][0] = 1.0f;
+		m.m[1][1] = 1.0f;
+		m.m[2][2] = 1.0f;
+		m.m[0][3] = (eye == vr::Eye_Left ? -0.5f : 0.5f) * ipd;
+
+		return m;
+	}
+
+	vr::HmdMatrix44_t GetProjectionMatrix(vr::EVREye, float nearZ, float farZ) override
+	{
+		glm::mat4 p = glm::perspective(glm::radians(fovDegrees), (float)width / (float)height, nearZ, farZ);
+
+		vr::HmdMatrix44_t m;
+
+		for (int row = 0; row < 4; row++)
+			for (int col = 0; col < 4; col++)
+				m.m[row][col] = p[col][row];
+
+		return m;
+	}
+
+	void WaitGetPoses(vr::TrackedDevicePose_t* poses, uint32_t count) override
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			poses[i] = {};
+			poses[i].bPoseIsValid = (i == vr::k_unTrackedDeviceIndex_Hmd);
+			poses[i].mDeviceToAbsoluteTracking.m[0][0] = 1.0f;
+			poses[i].mDeviceToAbsoluteTracking.m[1][1] = 1.0f;
+			poses[i].mDeviceToAbsoluteTracking.m[2][2] = 1.0f;
+		}
+
+		if (refreshRate > 0.0)
+		{
+			double next = lastVSync + 1.0 / refreshRate;
+
+			// sleep through most of the interval, the scheduler is only good to about a millisecond
+			double remaining = next - glfwGetTime();
+
+			if (remaining > 0.002)
+				std::this_thread::sleep_for(std::chrono::duration<double>(remaining - 0.001));
+
+			while (glfwGetTime() < next) { }
+
+			lastVSync = glfwGetTime();
+		}
+	}
+
+	void Submit(vr::EVREye, const vr::Texture_t*, const vr::VRTextureBounds_t*, vr::EVRSubmitFlags) override
+	{
+		submittedImages++;
+	}
+
+	void PostPresentHandoff() override
+	{
+		submittedFrames++;
+	}
+
+private:
+	double lastVSync = 0.0;
+};
+
+class OpenVRPart
+{
+public:
+	uint32_t rtWidth, rtHeight;
+
+	OpenVRPart(bool useMock = false) : rtWidth(0), rtHeight(0)
+	{
+		if (useMock)
+			backend.reset(new MockVRBackend());
+		else
+			backend.reset(new OpenVRBackend());
+
+		backend->GetRecommendedRenderTargetSize(&rtWidth, &rtHeight);
+
+		std::cout << "Initialized " << (useMock ? "mock " : "") << "HMD with render target width : " << rtWidth << ", height: " << rtHeight << std::endl;
+	}
+
+	VRBackend* GetBackend()
+	{
+		return backend.get();
+	}
+
+	void submitFramesToOpenVR(GLint leftEyeImg, GLint rightEyeImg, bool linear = false)
+	{
+		waitGetPoses();
+
+		vr::EColorSpace colorSpace = linear ? vr::ColorSpace_Linear : vr::ColorSpace_Gamma;
+
+		vr::Texture_t leftEyeImage = { (void*)(uintptr_t)leftEyeImg, vr::TextureType_OpenGL, colorSpace };
+		vr::Texture_t rightEyeImage = { (void*)(uintptr_t)rightEyeImg, vr::TextureType_OpenGL, colorSpace };
+
+		backend->Submit(vr::Eye_Left, &leftEyeImage, NULL, vr::Submit_Default);
+		backend->Submit(vr::Eye_Right, &rightEyeImage, NULL, vr::Submit_Default);
+
+		backend->PostPresentHandoff();
+	}
+
+	// both eyes side by side in one texture, left eye in the left half
+	void submitSideBySide(GLint image, bool linear = false)
+	{
+		waitGetPoses();
+
+		vr::Texture_t eyeImage = { (void*)(uintptr_t)image, vr::TextureType_OpenGL, linear ? vr::ColorSpace_Linear : vr::ColorSpace_Gamma };
+		vr::VRTextureBounds_t leftBounds = { 0.0f, 0.0f, 0.5f, 1.0f };
+		vr::VRTextureBounds_t rightBounds = { 0.5f, 0.0f, 1.0f, 1.0f };
+
+		backend->Submit(vr::Eye_Left, &eyeImage, &leftBounds, vr::Submit_Default);
+		backend->Submit(vr::Eye_Right, &eyeImage, &rightBounds, vr::Submit_Default);
+
+		backend->PostPresentHandoff();
+	}
+
+	// both eyes as layers 0 and 1 of a GL_TEXTURE_2D_ARRAY, the eye index selects the layer
+	void submitLayered(GLint arrayImage, bool linear = false)
+	{
+		waitGetPoses();
+
+		vr::Texture_t eyeImage = { (void*)(uintptr_t)arrayImage, vr::TextureType_OpenGL, linear ? vr::ColorSpace_Linear : vr::ColorSpace_Gamma };
+
+		backend->Submit(vr::Eye_Left, &eyeImage, NULL, vr::Submit_GlArrayTexture);
+		backend->Submit(vr::Eye_Right, &eyeImage, NULL, vr::Submit_GlArrayTexture);
+
+		backend->PostPresentHandoff();
+	}
 
 	glm::mat4 GetEyeMatrix(vr::EVREye eye)
 	{
-		glm::mat4 result = ToGLM(hmd->GetEyeToHeadTransform(eye));
+		glm::mat4 result = ToGLM(backend->GetEyeToHeadTransform(eye));
 		return result;
 	}
 
+	glm::mat4 GetEyeProjection(vr::EVREye eye, float nearZ, float farZ)
+	{
+		vr::HmdMatrix44_t m = backend->GetProjectionMatrix(eye, nearZ, farZ);
+
+		return glm::transpose(glm::make_mat4(&m.m[0][0]));
+	}
+
+	// view matrix of one eye for a head (camera) view matrix
+	glm::mat4 GetEyeView(vr::EVREye eye, const glm::mat4& headView)
+	{
+		return glm::inverse(GetEyeMatrix(eye)) * headView;
+	}
+
 	glm::mat4 ToGLM(const vr::HmdMatrix34_t& m)
 	{
 		glm::mat4 result = glm::mat4(
@@ -112,4 +312,13 @@ class OpenVRPart
 
 		return result;
 	}
+
+private:
+	std::unique_ptr<VRBackend> backend;
+
+	void waitGetPoses()
+	{
+		vr::TrackedDevicePose_t trackedDevicePose[vr::k_unMaxTrackedDeviceCount];
+		backend->WaitGetPoses(trackedDevicePose, vr::k_unMaxTrackedDeviceCount);
+	}
 };
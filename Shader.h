@@ -3,6 +3,9 @@
 
 #include <glad/glad.h>
 
+#include "gl_extensions.h"
+#include "gl_state.h"
+
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -15,6 +18,9 @@ class Shader
 public:
 	unsigned int ID;
 
+	// empty, for programs built elsewhere (ShaderCache)
+	Shader() : ID(0) {}
+
 	Shader(const char* vertexPath, const char* fragmentPath)
 	{
 		std::string vertexCode;
@@ -72,9 +78,47 @@ public:
 		glDeleteShader(fragment);
 	}
 
+	// compute-only program, needs GL_ARB_compute_shader
+	Shader(const char* computePath)
+	{
+		std::string computeCode;
+		std::ifstream cShaderFile;
+
+		cShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+		try
+		{
+			cShaderFile.open(computePath);
+			std::stringstream cShaderStream;
+
+			cShaderStream << cShaderFile.rdbuf();
+			cShaderFile.close();
+
+			computeCode = cShaderStream.str();
+		}
+		catch (std::ifstream::failure e)
+		{
+			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+		}
+
+		const char* cShaderCode = computeCode.c_str();
+
+		unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+		glShaderSource(compute, 1, &cShaderCode, NULL);
+		glCompileShader(compute);
+		checkCompileErrors(compute, "COMPUTE");
+
+		ID = glCreateProgram();
+		glAttachShader(ID, compute);
+		glLinkProgram(ID);
+
+		checkCompileErrors(ID, "PROGRAM");
+
+		glDeleteShader(compute);
+	}
+
 	void use()
 	{
-		glUseProgram(ID);
+		glState.UseProgram(ID);
 	}
 
 	void setBool(const std::string &name, bool value) const
@@ -126,8 +170,28 @@ public:
 		glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
 	}
 
-private:
-	void checkCompileErrors(GLuint shader, std::string type)
+	static std::string ReadSource(const char* path)
+	{
+		std::ifstream file;
+		file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+
+		try
+		{
+			file.open(path);
+			std::stringstream stream;
+			stream << file.rdbuf();
+			return stream.str();
+		}
+		catch (std::ifstream::failure e)
+		{
+			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ " << path << std::endl;
+		}
+
+		return std::string();
+	}
+
+	// true if the shader compiled / the program linked, prints the log otherwise
+	static bool checkCompileErrors(GLuint shader, std::string type)
 	{
 		GLint success;
 		GLchar infoLog[1024];
@@ -151,9 +215,10 @@ private:
 				glGetProgramInfoLog(shader, 1024, NULL, infoLog);
 				std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- ----------------------- -- " << std::endl;
 			}
+		}
+
+		return success != 0;
 	}
-	
- }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,115 @@
+#ifndef BLOOM_H
+#define BLOOM_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "gl_state.h"
+#include "render_targets.h"
+#include "gpu_timer.h"
+
+#include <algorithm>
+
+const int BLOOM_MAX_LEVELS = 6;		// half size down to 1/64
+const int BLOOM_MIN_SIZE = 8;		// pixels, smaller levels are skipped
+
+// Dual filter bloom (Bjørge, "Bandwidth-Efficient Rendering", SIGGRAPH 2015). The HDR scene is
+// downsampled into a chain of half, quarter, ... size targets with a 5 tap filter, the first
+// step keeping only what is brighter than threshold; the way back up adds an 8 tap tent of
+// each level onto the next larger one. Every tap is a bilinear fetch between texels, so the
+// wide blur costs a handful of reads per pixel of half resolution and below, and never touches
+// a full size target except for the one read of the scene. The result is level 0, for the
+// screen pass to add before tone mapping.
+class Bloom
+{
+public:
+	float threshold = 0.6f;		// scene values above this bloom
+	float knee = 0.3f;			// soft transition below threshold
+	float intensity = 0.6f;		// of the bloom added to the scene
+
+	Bloom(RenderTargetPool& pool, Shader downShader, Shader upShader) : pool(pool), downShader(downShader), upShader(upShader)
+	{
+		RenderTargetDesc desc;
+		desc.colorFormat = GL_R11F_G11F_B10F;
+		desc.depthFormat = 0;
+
+		for (int i = 0; i < BLOOM_MAX_LEVELS; i++)
+		{
+			desc.divisor = 2u << i;
+			levels[i] = pool.Create("bloom", desc);
+		}
+	}
+
+	Bloom(const Bloom&) = delete;
+	Bloom& operator=(const Bloom&) = delete;
+
+	// returns the bloom texture, half the size of source; leaves the last level bound
+	unsigned int Apply(int sourceTarget, unsigned int quadVAO)
+	{
+		timer.Begin();
+
+		glState.Disable(GL_DEPTH_TEST);
+		glState.Disable(GL_BLEND);
+		glState.BindVertexArray(quadVAO);
+
+		int levelCount = 1;
+		while (levelCount < BLOOM_MAX_LEVELS && std::min(pool.GetWidth(), pool.GetHeight()) / (2 << levelCount) >= BLOOM_MIN_SIZE)
+			levelCount++;
+
+		const RenderTargetPool::Target& source = pool.Get(sourceTarget);
+		unsigned int sourceTexture = source.colorTexture;
+		glm::vec2 sourceSize = glm::vec2((float)source.width, (float)source.height);
+
+		downShader.use();
+		downShader.setFloat("threshold", threshold);
+		downShader.setFloat("knee", knee);
+
+		for (int i = 0; i < levelCount; i++)
+		{
+			pool.Bind(levels[i]);
+			downShader.setVec2("texelSize", 1.0f / sourceSize);
+			downShader.setInt("prefilter", i == 0);
+			glState.BindTexture(0, GL_TEXTURE_2D, sourceTexture);
+			glDrawArrays(GL_TRIANGLES, 0, 6);
+
+			const RenderTargetPool::Target& level = pool.Get(levels[i]);
+			sourceTexture = level.colorTexture;
+			sourceSize = glm::vec2((float)level.width, (float)level.height);
+		}
+
+		// each level gets the blurred smaller one added on top
+		upShader.use();
+		glState.Enable(GL_BLEND);
+		glBlendFunc(GL_ONE, GL_ONE);
+
+		for (int i = levelCount - 2; i >= 0; i--)
+		{
+			const RenderTargetPool::Target& smaller = pool.Get(levels[i + 1]);
+
+			pool.Bind(levels[i]);
+			upShader.setVec2("texelSize", glm::vec2(1.0f / smaller.width, 1.0f / smaller.height));
+			glState.BindTexture(0, GL_TEXTURE_2D, smaller.colorTexture);
+			glDrawArrays(GL_TRIANGLES, 0, 6);
+		}
+
+		glState.Disable(GL_BLEND);
+
+		timer.End();
+
+		return pool.Get(levels[0]).colorTexture;
+	}
+
+	// GPU time of the last Apply() that has finished
+	float GetMilliseconds() { return timer.GetMilliseconds(); }
+
+private:
+	RenderTargetPool& pool;
+	Shader downShader;
+	Shader upShader;
+	int levels[BLOOM_MAX_LEVELS];
+	GpuTimer timer;
+};
+
+#endif
@@ -0,0 +1,38 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D source;
+uniform vec2 texelSize;		// of source
+uniform int prefilter;		// first step: keep only what is above threshold
+uniform float threshold;
+uniform float knee;
+
+// soft threshold: a quadratic ramp over [threshold - knee, threshold + knee], linear above
+vec3 bright(vec3 color)
+{
+	float brightness = max(color.r, max(color.g, color.b));
+	float soft = clamp(brightness - threshold + knee, 0.0, 2.0 * knee);
+	soft = soft * soft / (4.0 * knee + 1e-5);
+
+	return color * max(soft, brightness - threshold) / max(brightness, 1e-5);
+}
+
+vec3 tap(vec2 uv)
+{
+	vec3 color = texture(source, uv).rgb;
+	return prefilter != 0 ? bright(color) : color;
+}
+
+void main()
+{
+	// centre between four source texels, four more one texel out diagonally
+	vec3 sum = tap(TexCoords) * 4.0;
+	sum += tap(TexCoords - texelSize);
+	sum += tap(TexCoords + texelSize);
+	sum += tap(TexCoords + vec2(texelSize.x, -texelSize.y));
+	sum += tap(TexCoords - vec2(texelSize.x, -texelSize.y));
+
+	FragColor = vec4(sum / 8.0, 1.0);
+}
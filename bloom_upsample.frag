@@ -0,0 +1,23 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D source;
+uniform vec2 texelSize;		// of source, the smaller level
+
+void main()
+{
+	// tent over a diamond of eight taps, the diagonal ones between texels count twice
+	vec2 h = texelSize * 0.5;
+	vec3 sum = texture(source, TexCoords + vec2(-h.x * 2.0, 0.0)).rgb;
+	sum += texture(source, TexCoords + vec2(-h.x, h.y)).rgb * 2.0;
+	sum += texture(source, TexCoords + vec2(0.0, h.y * 2.0)).rgb;
+	sum += texture(source, TexCoords + vec2(h.x, h.y)).rgb * 2.0;
+	sum += texture(source, TexCoords + vec2(h.x * 2.0, 0.0)).rgb;
+	sum += texture(source, TexCoords + vec2(h.x, -h.y)).rgb * 2.0;
+	sum += texture(source, TexCoords + vec2(0.0, -h.y * 2.0)).rgb;
+	sum += texture(source, TexCoords + vec2(-h.x, -h.y)).rgb * 2.0;
+
+	FragColor = vec4(sum / 12.0, 1.0);
+}
@@ -25,14 +25,31 @@ const float PITCH		= 0.0f;
 const float SPEED		= 5.0f;
 const float SENSITIVITY = 0.1f;
 const float ZOOM		= 45.0f;
+const float NEAR_PLANE	= 0.01f;
 const bool SPRINTING	= false;
 const bool JOGGING		= false;
 const bool CRAWLING		= false;
 
+// Projection with the far plane at infinity and depth reversed (near = 1, infinity = 0). Works on
+// any perspective matrix, so off-center HMD projections can be converted as well. Needs
+// glDepthFunc(GL_GREATER), glClearDepth(0.0) and ideally glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE).
+inline glm::mat4 reversedInfiniteZ(glm::mat4 projection, float nearPlane)
+{
+	projection[2][2] = 0.0f;
+	projection[2][3] = -1.0f;
+	projection[3][2] = nearPlane;
+	projection[3][3] = 0.0f;
+
+	return projection;
+}
+
+// Position is kept in double precision so the camera can sit anywhere in the galaxy. Rendering
+// happens relative to the camera: GetViewMatrix() only rotates, positions are turned into
+// camera-relative float offsets with GetRelativePosition() every frame.
 class Camera
 {
 public:
-	glm::vec3 Position;
+	glm::dvec3 Position;
 	glm::vec3 Front;
 	glm::vec3 Up;
 	glm::vec3 Right;
@@ -48,7 +65,7 @@ public:
 	bool Jogging;
 	bool Crawling;
 
-	Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM), Sprinting(SPRINTING), Jogging(JOGGING), Crawling(CRAWLING)
+	Camera(glm::dvec3 position = glm::dvec3(0.0, 0.0, 0.0), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM), Sprinting(SPRINTING), Jogging(JOGGING), Crawling(CRAWLING)
 	{
 		Position = position;
 		WorldUp = up;
@@ -59,7 +76,7 @@ public:
 
 	Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM), Sprinting(SPRINTING), Jogging(JOGGING), Crawling(CRAWLING)
 	{
-		Position = glm::vec3(posX, posY, posZ);
+		Position = glm::dvec3(posX, posY, posZ);
 		WorldUp = glm::vec3(upX, upY, upZ);
 		Yaw = yaw;
 		Pitch = pitch;
@@ -68,13 +85,23 @@ public:
 
 	glm::mat4 GetViewMatrix()
 	{
-		return glm::lookAt(Position, Position + Front, Up);
+		return glm::lookAt(glm::vec3(0.0f), Front, Up);
+	}
+
+	glm::vec3 GetRelativePosition(const glm::dvec3& worldPosition)
+	{
+		return glm::vec3(worldPosition - Position);
+	}
+
+	glm::mat4 GetProjectionMatrix(float aspect)
+	{
+		return reversedInfiniteZ(glm::perspective(glm::radians(Zoom), aspect, NEAR_PLANE, 1.0f), NEAR_PLANE);
 	}
 
 	void ProcessKeyboard(Camera_Input input, float deltaTime)
 	{
 		
-		glm::vec3 oldPos = Position;
+		glm::dvec3 oldPos = Position;
 
 		if (input == SPRINT)
 		{
@@ -104,7 +131,7 @@ public:
 			Crawling = true;
 		}
 
-		float velocity;
+		double velocity;
 		if (Sprinting)
 			velocity = MovementSpeed * deltaTime * 50.0f;
 		else if (Jogging)
@@ -113,21 +140,23 @@ public:
 			velocity = MovementSpeed * deltaTime * 0.1f;
 		else
 			velocity = MovementSpeed * deltaTime;
+		glm::dvec3 forward = glm::normalize(glm::dvec3(Front.x, 0.0, Front.z));
+
 		if (input == FORWARD)
-			Position += glm::normalize(glm::vec3(Front.x, 0.0f, Front.z)) * velocity;
+			Position += forward * velocity;
 		if (input == BACKWARD)
-			Position -= glm::normalize(glm::vec3(Front.x, 0.0f, Front.z)) * velocity;
+			Position -= forward * velocity;
 		if (input == LEFT)
-			Position -= Right * velocity;
+			Position -= glm::dvec3(Right) * velocity;
 		if (input == RIGHT)
-			Position += Right * velocity;
+			Position += glm::dvec3(Right) * velocity;
 		
 		Position.y = oldPos.y;
 
 		if (input == UP)
-			Position += WorldUp * velocity;
+			Position += glm::dvec3(WorldUp) * velocity;
 		if (input == DOWN)
-			Position -= WorldUp * velocity;
+			Position -= glm::dvec3(WorldUp) * velocity;
 	}
 
 	void ProcessMouseMovement(float xoffset, float yoffset, GLboolean constrainPitch = true)
@@ -0,0 +1,325 @@
+#ifndef CLUSTERED_LIGHTS_H
+#define CLUSTERED_LIGHTS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "gl_state.h"
+#include "gl_resources.h"
+#include "shader.h"
+#include "camera.h"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// the grid is the same for every viewport: tiles in x / y, exponential slices in depth
+const int CLUSTER_X = 16;
+const int CLUSTER_Y = 9;
+const int CLUSTER_Z = 24;
+const int CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+const float CLUSTER_FAR = 1000.0f;				// render units, the last slice ends here
+const size_t MAX_CLUSTER_LIGHTS = 1024;			// nearest lights binned per frame
+const size_t MAX_CLUSTER_INDICES = 1 << 22;		// unless GL_MAX_TEXTURE_BUFFER_SIZE is lower
+const unsigned int CLUSTER_TEXTURE_UNIT = 8;	// lights, ranges on +1, indices on +2
+
+struct ClusterLight {
+	glm::vec3 position;	// camera-relative render units
+	float radius;		// no contribution beyond
+	glm::vec3 color;	// times intensity
+};
+
+// Where a program declaring clusteredLight() keeps the cluster uniforms, looked up once per
+// program.
+struct ClusterUniforms {
+	GLuint program = 0;
+	GLint lights, ranges, indices;	// samplers
+	GLint lighting, grid, viewport, depth;
+
+	void Locate(GLuint id)
+	{
+		if (id == program)
+			return;
+
+		program = id;
+		lights = glGetUniformLocation(id, "clusterLights");
+		ranges = glGetUniformLocation(id, "clusterRanges");
+		indices = glGetUniformLocation(id, "clusterIndices");
+		lighting = glGetUniformLocation(id, "clusterLighting");
+		grid = glGetUniformLocation(id, "clusterGrid");
+		viewport = glGetUniformLocation(id, "clusterViewport");
+		depth = glGetUniformLocation(id, "clusterDepth");
+	}
+};
+
+// Point lights for forward shading, binned into a froxel grid on the CPU every frame.
+//
+// Update() keeps the lights nearest to the camera, finds the clusters each light's sphere can
+// touch and writes three texture buffers: the lights (position and radius, color), per cluster
+// the first index and count, and the light indices of all clusters back to back. The fragment
+// shader finds its cluster from gl_FragCoord and view depth and loops over that list only (see
+// clusteredLight() in star_batch.frag and colors.frag), so a frame with thousands of lights
+// costs about what the few that overlap each pixel cost. Texture buffers are core in 3.3, no
+// SSBO or compute needed.
+class ClusteredLights
+{
+public:
+	ClusteredLights() : lightCount(0), indexCount(0), depthScale(0.0f), depthBias(0.0f)
+	{
+		GLint texels = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &texels);
+		maxIndices = (uint32_t)std::min((size_t)std::max(texels, 65536), MAX_CLUSTER_INDICES);
+
+		for (int i = 0; i < TARGETS; i++)
+		{
+			targets[i].buffer = 0;
+			targets[i].texture = 0;
+			targets[i].capacity = 0;
+		}
+	}
+
+	~ClusteredLights()
+	{
+		for (int i = 0; i < TARGETS; i++)
+		{
+			glDeleteTextures(1, &targets[i].texture);
+			glDeleteBuffers(1, &targets[i].buffer);
+		}
+	}
+
+	ClusteredLights(const ClusteredLights&) = delete;
+	ClusteredLights& operator=(const ClusteredLights&) = delete;
+
+	// lights is reordered; view / projection as used for drawing
+	void Update(std::vector<ClusterLight>& lights, const glm::mat4& view, const glm::mat4& projection)
+	{
+		// drop lights entirely behind the camera or past the grid, then keep the nearest
+		size_t kept = 0;
+
+		for (size_t i = 0; i < lights.size(); i++)
+		{
+			float depth = -(view * glm::vec4(lights[i].position, 1.0f)).z;
+
+			if (depth + lights[i].radius > NEAR_PLANE && depth - lights[i].radius < CLUSTER_FAR)
+				lights[kept++] = lights[i];
+		}
+
+		lights.resize(kept);
+
+		if (lights.size() > MAX_CLUSTER_LIGHTS)
+		{
+			std::nth_element(lights.begin(), lights.begin() + MAX_CLUSTER_LIGHTS, lights.end(), [](const ClusterLight& a, const ClusterLight& b) {
+				return glm::dot(a.position, a.position) < glm::dot(b.position, b.position);
+			});
+			lights.resize(MAX_CLUSTER_LIGHTS);
+		}
+
+		lightCount = (unsigned int)lights.size();
+
+		depthScale = CLUSTER_Z / std::log(CLUSTER_FAR / NEAR_PLANE);
+		depthBias = -std::log(NEAR_PLANE) * depthScale;
+
+		// cluster range of every light, then counting sort into the index list
+		bounds.resize(lights.size());
+		std::fill(counts.begin(), counts.end(), 0);
+		counts.resize(CLUSTER_COUNT, 0);
+
+		for (size_t i = 0; i < lights.size(); i++)
+		{
+			bounds[i] = clusterBounds(lights[i], view, projection);
+
+			for (int z = bounds[i].min.z; z <= bounds[i].max.z; z++)
+				for (int y = bounds[i].min.y; y <= bounds[i].max.y; y++)
+					for (int x = bounds[i].min.x; x <= bounds[i].max.x; x++)
+						counts[index(x, y, z)]++;
+		}
+
+		ranges.resize(CLUSTER_COUNT * 2);
+		uint32_t offset = 0;
+
+		for (int c = 0; c < CLUSTER_COUNT; c++)
+		{
+			// past maxIndices the far clusters lose lights, the grid stays consistent
+			uint32_t count = std::min(counts[c], maxIndices - offset);
+			ranges[c * 2] = offset;
+			ranges[c * 2 + 1] = count;
+			counts[c] = offset;	// becomes the write cursor
+			offset += count;
+		}
+
+		indexCount = offset;
+		indices.resize(std::max(indexCount, 1u));
+
+		for (size_t i = 0; i < lights.size(); i++)
+		{
+			for (int z = bounds[i].min.z; z <= bounds[i].max.z; z++)
+			{
+				for (int y = bounds[i].min.y; y <= bounds[i].max.y; y++)
+				{
+					for (int x = bounds[i].min.x; x <= bounds[i].max.x; x++)
+					{
+						int c = index(x, y, z);
+
+						if (counts[c] < ranges[c * 2] + ranges[c * 2 + 1])
+							indices[counts[c]++] = (uint32_t)i;
+					}
+				}
+			}
+		}
+
+		packed.resize(std::max(lights.size(), (size_t)1) * 2);
+
+		for (size_t i = 0; i < lights.size(); i++)
+		{
+			packed[i * 2] = glm::vec4(lights[i].position, lights[i].radius);
+			packed[i * 2 + 1] = glm::vec4(lights[i].color, 0.0f);
+		}
+
+		upload(targets[LIGHTS], GL_RGBA32F, packed.data(), packed.size() * sizeof(glm::vec4));
+		upload(targets[RANGES], GL_RG32UI, ranges.data(), ranges.size() * sizeof(uint32_t));
+		upload(targets[INDICES], GL_R32UI, indices.data(), indices.size() * sizeof(uint32_t));
+	}
+
+	// binds the buffers and sets the cluster uniforms of a shader that declares clusteredLight()
+	void Bind(Shader& shader, int viewportWidth, int viewportHeight)
+	{
+		shader.use();
+
+		for (int i = 0; i < TARGETS; i++)
+			glState.BindTexture(CLUSTER_TEXTURE_UNIT + i, GL_TEXTURE_BUFFER, targets[i].texture);
+
+		const ClusterUniforms& uniforms = locate(shader.ID);
+
+		SetTextureUnits(uniforms);
+		glUniform1i(uniforms.lighting, lightCount > 0);
+		glUniform3i(uniforms.grid, CLUSTER_X, CLUSTER_Y, CLUSTER_Z);
+		glUniform2f(uniforms.viewport, (float)viewportWidth, (float)viewportHeight);
+		glUniform2f(uniforms.depth, depthScale, depthBias);
+	}
+
+	// Samplers left at unit 0 would clash with the shader's own textures and fail the draw, so
+	// shaders declaring clusteredLight() call this even when no lights are bound. Expects the
+	// program to be current.
+	static void SetTextureUnits(const ClusterUniforms& uniforms)
+	{
+		glState.Uniform1i(uniforms.program, uniforms.lights, CLUSTER_TEXTURE_UNIT + LIGHTS);
+		glState.Uniform1i(uniforms.program, uniforms.ranges, CLUSTER_TEXTURE_UNIT + RANGES);
+		glState.Uniform1i(uniforms.program, uniforms.indices, CLUSTER_TEXTURE_UNIT + INDICES);
+	}
+
+	unsigned int GetLightCount() const { return lightCount; }
+	unsigned int GetIndexCount() const { return indexCount; }
+
+private:
+	enum { LIGHTS, RANGES, INDICES, TARGETS };
+
+	struct Target {
+		GLuint buffer;
+		GLuint texture;
+		size_t capacity;
+	};
+
+	struct Bounds {
+		glm::ivec3 min;
+		glm::ivec3 max;
+	};
+
+	Target targets[TARGETS];
+	unsigned int lightCount;
+	unsigned int indexCount;
+	uint32_t maxIndices;
+	float depthScale;
+	float depthBias;
+
+	std::vector<Bounds> bounds;
+	std::vector<uint32_t> counts;
+	std::vector<uint32_t> ranges;	// first index, count
+	std::vector<uint32_t> indices;
+	std::vector<glm::vec4> packed;
+	std::vector<ClusterUniforms> programs;	// one per program Bind() has seen
+
+	const ClusterUniforms& locate(GLuint program)
+	{
+		for (const ClusterUniforms& uniforms : programs)
+			if (uniforms.program == program)
+				return uniforms;
+
+		programs.push_back(ClusterUniforms());
+		programs.back().Locate(program);
+		return programs.back();
+	}
+
+	static int index(int x, int y, int z)
+	{
+		return x + y * CLUSTER_X + z * CLUSTER_X * CLUSTER_Y;
+	}
+
+	int slice(float depth) const
+	{
+		return glm::clamp((int)std::floor(std::log(std::max(depth, NEAR_PLANE)) * depthScale + depthBias), 0, CLUSTER_Z - 1);
+	}
+
+	// Conservative: depth slices of the sphere's extent, tiles of its view-space box projected to
+	// the screen. A sphere reaching the near plane covers every tile of its slices.
+	Bounds clusterBounds(const ClusterLight& light, const glm::mat4& view, const glm::mat4& projection) const
+	{
+		glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+		float nearDepth = -center.z - light.radius;
+		float farDepth = -center.z + light.radius;
+
+		Bounds result;
+		result.min = glm::ivec3(0, 0, slice(nearDepth));
+		result.max = glm::ivec3(CLUSTER_X - 1, CLUSTER_Y - 1, slice(farDepth));
+
+		if (nearDepth <= NEAR_PLANE)
+			return result;
+
+		glm::vec2 low = glm::vec2(1.0f);
+		glm::vec2 high = glm::vec2(-1.0f);
+
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec3 offset = glm::vec3(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f) * light.radius;
+			glm::vec4 clip = projection * glm::vec4(center + offset, 1.0f);
+			glm::vec2 ndc = glm::vec2(clip) / clip.w;
+
+			low = glm::min(low, ndc);
+			high = glm::max(high, ndc);
+		}
+
+		result.min.x = glm::clamp((int)std::floor((low.x * 0.5f + 0.5f) * CLUSTER_X), 0, CLUSTER_X - 1);
+		result.min.y = glm::clamp((int)std::floor((low.y * 0.5f + 0.5f) * CLUSTER_Y), 0, CLUSTER_Y - 1);
+		result.max.x = glm::clamp((int)std::floor((high.x * 0.5f + 0.5f) * CLUSTER_X), 0, CLUSTER_X - 1);
+		result.max.y = glm::clamp((int)std::floor((high.y * 0.5f + 0.5f) * CLUSTER_Y), 0, CLUSTER_Y - 1);
+
+		// entirely off screen: an empty range
+		if (high.x < -1.0f || low.x > 1.0f || high.y < -1.0f || low.y > 1.0f)
+			result.max.x = result.min.x - 1;
+
+		return result;
+	}
+
+	// new storage when the data outgrows it, the texture is re-attached
+	void upload(Target& target, GLenum format, const void* data, size_t bytes)
+	{
+		if (bytes > target.capacity)
+		{
+			glDeleteBuffers(1, &target.buffer);
+			target.capacity = bytes * 2;
+			target.buffer = CreateBuffer(target.capacity, NULL, GL_DYNAMIC_STORAGE_BIT);
+
+			if (target.texture == 0)
+				glGenTextures(1, &target.texture);
+
+			glBindTexture(GL_TEXTURE_BUFFER, target.texture);
+			glTexBuffer(GL_TEXTURE_BUFFER, format, target.buffer);
+			glBindTexture(GL_TEXTURE_BUFFER, 0);
+		}
+
+		UpdateBuffer(target.buffer, 0, bytes, data);
+	}
+};
+
+#endif
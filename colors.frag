@@ -1,11 +1,10 @@
 #version 330 core
 out vec4 FragColor;
 
-struct Material {
-	sampler2D diffuse;
-	sampler2D specular;
-	float shininess;
-};
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+in float ViewDepth;
 
 struct DirLight {
 	vec3 direction;
@@ -15,18 +14,6 @@ struct DirLight {
 	vec3 specular;
 };
 
-struct PointLight {
-	vec3 position;
-	
-	float constant;
-	float linear;
-	float quadratic;
-
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-};
-
 struct SpotLight {
 	vec3 position;
 	vec3 direction;
@@ -42,91 +29,104 @@ struct SpotLight {
 	float quadratic;
 };
 
-#define NR_POINT_LIGHTS 4
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-
-in vec3 FragPos;
-in vec3 Normal;
-in vec2 TexCoords;
+uniform sampler2D texture_diffuse1;
 
+// left unset they are black and add nothing
 uniform vec3 viewPos;
-uniform Material material;
+uniform float shininess;
 uniform DirLight dirLight;
 uniform SpotLight spotLight;
 
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+uniform int clusterLighting;			// 0 until ClusteredLights::Bind
+uniform samplerBuffer clusterLights;	// per light: position, radius / color
+uniform usamplerBuffer clusterRanges;	// per cluster: first index, light count
+uniform usamplerBuffer clusterIndices;
+uniform ivec3 clusterGrid;
+uniform vec2 clusterViewport;
+uniform vec2 clusterDepth;				// slice = log(depth) * x + y
 
-void main()
+// diffuse light of the lights binned into this fragment's cluster
+vec3 clusteredLight(vec3 position, vec3 normal, float viewDepth)
 {
-	vec3 norm = normalize(Normal);
-	vec3 viewDir = normalize(viewPos - FragPos);
-
-	vec3 result = CalcDirLight(dirLight, norm, viewDir);
+	vec3 result = vec3(0.0);
 
-	for (int i = 0; i < NR_POINT_LIGHTS; i++)
-		result += max(CalcPointLight(pointLights[i], norm, FragPos, viewDir), vec3(0.0));
+	if (clusterLighting == 0)
+		return result;
 
-	result += max(CalcSpotLight(spotLight, norm, FragPos, viewDir), vec3(0.0));
+	ivec2 tile = clamp(ivec2(gl_FragCoord.xy / clusterViewport * vec2(clusterGrid.xy)), ivec2(0), clusterGrid.xy - 1);
+	int slice = clamp(int(floor(log(max(viewDepth, 1e-6)) * clusterDepth.x + clusterDepth.y)), 0, clusterGrid.z - 1);
+	uvec2 range = texelFetch(clusterRanges, tile.x + tile.y * clusterGrid.x + slice * clusterGrid.x * clusterGrid.y).xy;
 
-	FragColor = vec4(result, 1.0);
-}
+	for (uint i = 0u; i < range.y; i++)
+	{
+		int light = int(texelFetch(clusterIndices, int(range.x + i)).x);
+		vec4 positionRadius = texelFetch(clusterLights, light * 2);
+		vec3 color = texelFetch(clusterLights, light * 2 + 1).rgb;
 
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
-{
-	vec3 lightDir = normalize(-light.direction);
-	
-	float diff = max(dot(normal, lightDir), 0.0);
+		vec3 toLight = positionRadius.xyz - position;
+		float distance2 = max(dot(toLight, toLight), 1e-8);
 
-	vec3 reflectDir = reflect(-lightDir, normal);
-	float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+		// inverse square, windowed to reach 0 at the radius
+		float window = clamp(1.0 - pow(distance2 / (positionRadius.w * positionRadius.w), 2.0), 0.0, 1.0);
+		float attenuation = window * window / (distance2 + 1.0);
 
-	vec3 ambient  = light.ambient * vec3(texture(material.diffuse, TexCoords));
-	vec3 diffuse  = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-	vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+		result += color * max(dot(normal, toLight * inversesqrt(distance2)), 0.0) * attenuation;
+	}
 
-	return (ambient + diffuse + specular);
+	return result;
 }
 
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+vec3 CalcDirLight(DirLight light, vec3 albedo, vec3 normal, vec3 viewDir)
 {
-	vec3 lightDir = normalize(light.position - fragPos);
+	vec3 lightDir = -light.direction * inversesqrt(max(dot(light.direction, light.direction), 1e-8));
 
 	float diff = max(dot(normal, lightDir), 0.0);
 
 	vec3 reflectDir = reflect(-lightDir, normal);
-	float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+	float spec = pow(max(dot(viewDir, reflectDir), 0.0), max(shininess, 1.0));
 
-	float distance = length(light.position - fragPos);
-	float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * pow(distance, 2));
+	vec3 ambient  = light.ambient * albedo;
+	vec3 diffuse  = light.diffuse * diff * albedo;
+	vec3 specular = light.specular * spec;
 
-	vec3 ambient  = light.ambient * vec3(texture(material.diffuse, TexCoords));
-	vec3 diffuse  = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-	vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
-	
-	return ((ambient + diffuse + specular) * attenuation);
+	return (ambient + diffuse + specular);
 }
 
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir) 
+vec3 CalcSpotLight(SpotLight light, vec3 albedo, vec3 normal, vec3 fragPos, vec3 viewDir)
 {
 	vec3 lightDir = normalize(light.position - fragPos);
 
 	float diff = max(dot(normal, lightDir), 0.0);
 
 	vec3 reflectDir = reflect(-lightDir, normal);
-	float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+	float spec = pow(max(dot(viewDir, reflectDir), 0.0), max(shininess, 1.0));
 
-	float theta = dot(lightDir, normalize(-light.direction));
-	float epsilon = (light.cutOff - light.outerCutOff);
+	float theta = dot(lightDir, -light.direction * inversesqrt(max(dot(light.direction, light.direction), 1e-8)));
+	float epsilon = max(light.cutOff - light.outerCutOff, 1e-4);
 	float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
-	
-	vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
-	vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-	vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+
+	vec3 ambient  = light.ambient * albedo;
+	vec3 diffuse  = light.diffuse * diff * albedo;
+	vec3 specular = light.specular * spec;
 
 	float distance = length(light.position - fragPos);
-	float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * pow(distance, 2));
+	float attenuation = 1.0 / max(light.constant + light.linear * distance + light.quadratic * pow(distance, 2), 1e-4);
 
 	return (((diffuse + specular) * intensity + ambient) * attenuation);
 }
+
+// model_loading.frag plus the directional and spot light and the light of neighbouring stars,
+// binned by ClusteredLights
+void main()
+{
+	vec4 albedo = texture(texture_diffuse1, TexCoords);
+	vec3 norm = normalize(Normal);
+	vec3 viewDir = normalize(viewPos - FragPos);
+
+	vec3 result = albedo.rgb * (1.0 + clusteredLight(FragPos, norm, ViewDepth));
+
+	result += max(CalcDirLight(dirLight, albedo.rgb, norm, viewDir), vec3(0.0));
+	result += max(CalcSpotLight(spotLight, albedo.rgb, norm, FragPos, viewDir), vec3(0.0));
+
+	FragColor = vec4(result, albedo.a);
+}
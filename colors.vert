@@ -6,16 +6,20 @@ layout (location = 2) in vec2 aTexCoords;
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
+out float ViewDepth;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform mat4 meshDequantize;	// compact vertex positions back to model space
 
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
-    TexCoords = aTexCoords;
+	FragPos = vec3(model * meshDequantize * vec4(aPos, 1.0));
+	Normal = mat3(transpose(inverse(model))) * aNormal;
+	TexCoords = aTexCoords;
 
-    gl_Position = projection * view * vec4(FragPos, 1.0);
-}
\ No newline at end of file
+	vec4 viewPosition = view * vec4(FragPos, 1.0);
+	ViewDepth = -viewPosition.z;
+	gl_Position = projection * viewPosition;
+}
@@ -0,0 +1,861 @@
+#ifndef EVENT_STORE_H
+#define EVENT_STORE_H
+
+#include "External Libraries/rapidjson/document.h"
+
+#include "jump_history.h"
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <cstring>
+#include <cstdint>
+
+const uint32_t EVENT_NONE = 0xFFFFFFFFu;	// no system, type or string
+const int64_t EVENT_SECONDS_PER_DAY = 86400;
+const int64_t EVENT_EPOCH = 1388534400;	// 2014-01-01, before the game wrote its first journal; times fit 32 bits until 2150
+const size_t EVENT_MAX_TYPES = 65536;		// event names coded at most, the events of any more are dropped
+
+enum EventGroupBy {
+	EVENT_GROUP_NONE,	// one group, key 0
+	EVENT_GROUP_DAY,	// days since 1970
+	EVENT_GROUP_TYPE,	// EventStore::GetTypeName()
+	EVENT_GROUP_SYSTEM,	// EventStore::GetSystemName()
+	EVENT_GROUP_FIELD	// a string field, EventStore::GetString()
+};
+
+struct EventGroup {
+	int64_t key;
+	size_t count;	// events in the group, with the aggregated field if there is one
+	double sum;
+	double min;
+	double max;
+
+	double Mean() const { return count ? sum / count : 0.0; }
+};
+
+// values of one field of one event type, only for the events that have it; rows ascending
+struct EventNumberColumn {
+	std::vector<uint32_t> rows;
+	std::vector<double> values;
+};
+
+struct EventStringColumn {
+	std::vector<uint32_t> rows;
+	std::vector<uint32_t> codes;	// into the store's string dictionary
+};
+
+// bits value of at most 32 bits at width bits from bit on, words long enough
+inline uint32_t ReadEventBits(const std::vector<uint64_t>& words, size_t bit, int width)
+{
+	if (width == 0)
+		return 0;
+
+	size_t word = bit >> 6;
+	int shift = (int)(bit & 63);
+	uint64_t value = words[word] >> shift;
+
+	if (shift + width > 64)
+		value |= words[word + 1] << (64 - shift);
+
+	return (uint32_t)(value & ((1ull << width) - 1));
+}
+
+inline void WriteEventBits(std::vector<uint64_t>& words, size_t bit, int width, uint32_t value)
+{
+	if (width == 0)
+		return;
+
+	size_t word = bit >> 6;
+	int shift = (int)(bit & 63);
+	words[word] |= (uint64_t)value << shift;
+
+	if (shift + width > 64)
+		words[word + 1] |= (uint64_t)value >> (64 - shift);
+}
+
+inline int EventBitWidth(uint32_t value)
+{
+	int width = 0;
+
+	while (width < 32 && (value >> width) != 0)
+		width++;
+
+	return width;
+}
+
+// Unsigned integers at the bits the largest one so far needs. A larger one repacks the column
+// at its width, which happens at most 32 times.
+class EventPackedColumn
+{
+public:
+	EventPackedColumn() : width(0), count(0)
+	{
+	}
+
+	void Push(uint32_t value)
+	{
+		if (EventBitWidth(value) > width)
+			widen(EventBitWidth(value));
+
+		words.resize((count + 1) * width / 64 + 1, 0);
+		WriteEventBits(words, count * width, width, value);
+		count++;
+	}
+
+	uint32_t operator[](size_t i) const { return ReadEventBits(words, i * width, width); }
+	size_t Size() const { return count; }
+	size_t GetBytes() const { return words.size() * sizeof(uint64_t); }
+
+private:
+	std::vector<uint64_t> words;
+	int width;
+	size_t count;
+
+	void widen(int newWidth)
+	{
+		std::vector<uint64_t> wider(count * newWidth / 64 + 1, 0);
+
+		for (size_t i = 0; i < count; i++)
+			WriteEventBits(wider, i * newWidth, newWidth, (*this)[i]);
+
+		words.swap(wider);
+		width = newWidth;
+	}
+};
+
+const size_t EVENT_TIME_BLOCK = 64;	// rows of a time block
+
+// Times in blocks of EVENT_TIME_BLOCK rows, each row as its delta from the smallest time of its
+// block at the bits the block's largest delta needs. A play session fills a block within
+// minutes, so most deltas take 10 to 16 bits. The block being filled is kept as is.
+class EventTimeColumn
+{
+public:
+	void Push(uint32_t time)
+	{
+		open.push_back(time);
+
+		if (open.size() == EVENT_TIME_BLOCK)
+			close();
+	}
+
+	uint32_t operator[](size_t row) const
+	{
+		size_t block = row / EVENT_TIME_BLOCK;
+
+		if (block == blocks.size())
+			return open[row % EVENT_TIME_BLOCK];
+
+		const Block& b = blocks[block];
+		return b.base + ReadEventBits(words, (size_t)b.firstWord * 64 + (row % EVENT_TIME_BLOCK) * b.width, b.width);
+	}
+
+	size_t Size() const { return blocks.size() * EVENT_TIME_BLOCK + open.size(); }
+	bool Empty() const { return blocks.empty() && open.empty(); }
+	uint32_t Back() const { return (*this)[Size() - 1]; }
+	size_t GetBytes() const { return blocks.size() * sizeof(Block) + words.size() * sizeof(uint64_t) + open.size() * sizeof(uint32_t); }
+
+	// first row with a time of at least time, the times ascending
+	size_t LowerBound(uint32_t time) const
+	{
+		size_t low = 0, high = Size();
+
+		while (low < high)
+		{
+			size_t middle = low + (high - low) / 2;
+
+			if ((*this)[middle] < time)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+
+		return low;
+	}
+
+private:
+	struct Block {
+		uint32_t base;		// smallest time
+		uint32_t firstWord;	// EVENT_TIME_BLOCK deltas of width bits take width words
+		uint32_t width;
+	};
+
+	std::vector<Block> blocks;
+	std::vector<uint64_t> words;
+	std::vector<uint32_t> open;
+
+	void close()
+	{
+		Block b;
+		b.base = *std::min_element(open.begin(), open.end());
+		b.width = (uint32_t)EventBitWidth(*std::max_element(open.begin(), open.end()) - b.base);
+		b.firstWord = (uint32_t)words.size();
+
+		words.resize(words.size() + b.width, 0);
+
+		for (size_t i = 0; i < open.size(); i++)
+			WriteEventBits(words, (size_t)b.firstWord * 64 + i * b.width, b.width, open[i] - b.base);
+
+		blocks.push_back(b);
+		open.clear();
+	}
+};
+
+class EventQuery;
+
+// Every journal event, ingested once, in columns. Each event is a row of three dense columns:
+// seconds since EVENT_EPOCH, delta coded per block (EventTimeColumn), and the codes of the
+// event type and of the system the ship was in, bit packed (EventPackedColumn). Everything else
+// the event carries at its top level goes into sparse columns, one per event type and field
+// name, that only hold the rows having the field: numbers and booleans as doubles, strings as
+// codes into one dictionary. Nested objects and arrays are left out.
+//
+// Rows are appended in time order, so a time range is a row range found by binary search, and
+// every event type keeps the list of its rows. Queries (see EventQuery) start from those and
+// narrow the rows down with tight loops over the typed columns, never touching JSON again.
+class EventStore
+{
+public:
+	EventStore() : system(EVENT_NONE), sorted(true), dropped(0)
+	{
+		// the events that move the ship, coded up front
+		locationType = code(typeIndex, typeNames, "Location");
+		fsdJumpType = code(typeIndex, typeNames, "FSDJump");
+		carrierJumpType = code(typeIndex, typeNames, "CarrierJump");
+		typeRows.resize(typeNames.size());
+	}
+
+	// one parsed journal line
+	void Ingest(const rapidjson::Value& event)
+	{
+		if (!event.IsObject() || !event.HasMember("event") || !event["event"].IsString() || !event.HasMember("timestamp") || !event["timestamp"].IsString())
+			return;
+
+		int64_t timestamp = ParseTimestamp(event["timestamp"].GetString());
+
+		if (timestamp < 0)
+			return;
+
+		if (timestamp < EVENT_EPOCH || timestamp - EVENT_EPOCH >= (int64_t)UINT32_MAX)
+		{
+			std::cout << "ERROR::EVENT_STORE::OUT_OF_RANGE: " << event["event"].GetString() << " at " << timestamp << " dropped" << std::endl;
+			dropped++;
+			return;
+		}
+
+		uint32_t row = (uint32_t)times.Size();
+		uint32_t type = find(typeIndex, event["event"].GetString());
+
+		if (type == EVENT_NONE)
+		{
+			if (typeNames.size() >= EVENT_MAX_TYPES)
+			{
+				dropped++;
+				return;
+			}
+
+			type = code(typeIndex, typeNames, event["event"].GetString());
+		}
+
+		// the system every event after these happens in
+		if (event.HasMember("StarSystem") && event["StarSystem"].IsString() && (type == locationType || type == fsdJumpType || type == carrierJumpType))
+			system = code(systemIndex, systemNames, event["StarSystem"].GetString());
+
+		append(timestamp, type, system);
+
+		for (rapidjson::Value::ConstMemberIterator it = event.MemberBegin(); it != event.MemberEnd(); ++it)
+		{
+			const char* name = it->name.GetString();
+
+			if (strcmp(name, "timestamp") == 0 || strcmp(name, "event") == 0)
+				continue;
+
+			if (!it->value.IsNumber() && !it->value.IsBool() && !it->value.IsString())
+				continue;
+
+			uint64_t key = columnKey(type, code(fieldIndex, fieldNames, std::string(name, it->name.GetStringLength())));
+
+			if (it->value.IsNumber() || it->value.IsBool())
+			{
+				EventNumberColumn& column = numbers[key];
+				column.rows.push_back(row);
+				column.values.push_back(it->value.IsBool() ? (it->value.GetBool() ? 1.0 : 0.0) : it->value.GetDouble());
+			}
+			else if (it->value.IsString())
+			{
+				EventStringColumn& column = strings[key];
+				column.rows.push_back(row);
+				column.codes.push_back(code(stringIndex, stringValues, std::string(it->value.GetString(), it->value.GetStringLength())));
+			}
+		}
+	}
+
+	void Ingest(const char* line)
+	{
+		rapidjson::Document event;
+		event.Parse(line);
+
+		if (!event.HasParseError())
+			Ingest(event);
+	}
+
+	EventQuery Query() const;
+
+	size_t Size() const { return times.Size(); }
+	int64_t GetTime(size_t row) const { return EVENT_EPOCH + times[row]; }
+	uint32_t GetType(size_t row) const { return types[row]; }
+	// stored one up, EVENT_NONE as 0
+	uint32_t GetSystem(size_t row) const { return systems[row] - 1; }
+
+	uint32_t FindType(const std::string& name) const { return find(typeIndex, name); }
+	uint32_t FindSystem(const std::string& name) const { return find(systemIndex, name); }
+	uint32_t FindString(const std::string& value) const { return find(stringIndex, value); }
+	const std::string& GetTypeName(uint32_t type) const { return typeNames[type]; }
+	const std::string& GetSystemName(uint32_t system) const { return systemNames[system]; }
+	const std::string& GetString(uint32_t code) const { return stringValues[code]; }
+	size_t GetTypeCount() const { return typeNames.size(); }
+	size_t GetSystemCount() const { return systemNames.size(); }
+
+	uint32_t FindField(const std::string& name) const { return find(fieldIndex, name); }
+
+	// NULL if no event of the type has the field
+	const EventNumberColumn* GetNumbers(uint32_t type, uint32_t field) const
+	{
+		auto it = numbers.find(columnKey(type, field));
+		return it == numbers.end() ? NULL : &it->second;
+	}
+
+	const EventStringColumn* GetStrings(uint32_t type, uint32_t field) const
+	{
+		auto it = strings.find(columnKey(type, field));
+		return it == strings.end() ? NULL : &it->second;
+	}
+
+	// rows of one type, ascending
+	const std::vector<uint32_t>& GetTypeRows(uint32_t type) const { return typeRows[type]; }
+
+	// rows [first, end) are the events in [from, to), seconds since 1970
+	void FindTimeRange(int64_t from, int64_t to, size_t& first, size_t& end) const
+	{
+		if (!sorted)
+		{
+			first = 0;
+			end = times.Size();
+			return;
+		}
+
+		first = times.LowerBound(offset(from));
+		end = times.LowerBound(offset(to));
+	}
+
+	// false if events arrived out of order, time ranges then take a scan
+	bool IsSorted() const { return sorted; }
+	// events dropped for a time before EVENT_EPOCH or past what 32 bits hold, or for a type past
+	// EVENT_MAX_TYPES
+	size_t GetDroppedCount() const { return dropped; }
+
+	// bytes held by the columns, not counting the dictionaries
+	size_t GetColumnBytes() const
+	{
+		// and the row in its type's list
+		size_t bytes = times.GetBytes() + types.GetBytes() + systems.GetBytes() + times.Size() * sizeof(uint32_t);
+
+		for (const auto& column : numbers)
+			bytes += column.second.rows.size() * (sizeof(uint32_t) + sizeof(double));
+		for (const auto& column : strings)
+			bytes += column.second.rows.size() * sizeof(uint32_t) * 2;
+
+		return bytes;
+	}
+
+	// journal timestamps, "2023-01-31T18:04:55Z", in seconds since 1970; -1 if it is none
+	static int64_t ParseTimestamp(const char* text)
+	{
+		return JumpHistory::ParseTimestamp(text);
+	}
+
+private:
+	uint32_t system;	// where the ship is
+	bool sorted;
+	size_t dropped;		// events outside the times a row can hold
+
+	EventTimeColumn times;		// seconds since EVENT_EPOCH
+	EventPackedColumn types;
+	EventPackedColumn systems;	// one up, 0 for none
+	std::vector<std::vector<uint32_t>> typeRows;
+
+	std::unordered_map<uint64_t, EventNumberColumn> numbers;	// by columnKey()
+	std::unordered_map<uint64_t, EventStringColumn> strings;
+
+	std::vector<std::string> typeNames;
+	std::vector<std::string> systemNames;
+	std::vector<std::string> fieldNames;
+	std::vector<std::string> stringValues;
+	std::unordered_map<std::string, uint32_t> typeIndex;
+	std::unordered_map<std::string, uint32_t> systemIndex;
+	std::unordered_map<std::string, uint32_t> fieldIndex;
+	std::unordered_map<std::string, uint32_t> stringIndex;
+
+	uint32_t locationType;
+	uint32_t fsdJumpType;
+	uint32_t carrierJumpType;
+
+	void append(int64_t timestamp, uint32_t type, uint32_t system)
+	{
+		uint32_t time = offset(timestamp);
+		sorted = sorted && (times.Empty() || time >= times.Back());
+
+		times.Push(time);
+		types.Push(type);
+		systems.Push(system + 1);
+
+		if (typeRows.size() <= type)
+			typeRows.resize(type + 1);
+
+		typeRows[type].push_back((uint32_t)(times.Size() - 1));
+	}
+
+	static uint64_t columnKey(uint32_t type, uint32_t field)
+	{
+		return ((uint64_t)type << 32) | field;
+	}
+
+	// clamped, for query bounds; Ingest() drops rows that would be
+	static uint32_t offset(int64_t timestamp)
+	{
+		if (timestamp <= EVENT_EPOCH)
+			return 0;
+
+		return (uint32_t)std::min(timestamp - EVENT_EPOCH, (int64_t)UINT32_MAX);
+	}
+
+	static uint32_t code(std::unordered_map<std::string, uint32_t>& index, std::vector<std::string>& values, const std::string& value)
+	{
+		auto it = index.find(value);
+
+		if (it != index.end())
+			return it->second;
+
+		uint32_t code = (uint32_t)values.size();
+		index[value] = code;
+		values.push_back(value);
+		return code;
+	}
+
+	static uint32_t find(const std::unordered_map<std::string, uint32_t>& index, const std::string& value)
+	{
+		auto it = index.find(value);
+		return it == index.end() ? EVENT_NONE : it->second;
+	}
+
+	friend class EventQuery;
+};
+
+// Filters rows of an EventStore and aggregates them. Filters narrow a list of rows, ascending,
+// that starts out as the time range (or the rows of one type within it); a field's sparse
+// columns are matched against it by merging, since both are sorted, one cursor per event type.
+//
+//	std::vector<EventGroup> earnings = events.Query().Type("MarketSell").GroupBy(EVENT_GROUP_DAY).Aggregate("TotalSale");
+class EventQuery
+{
+public:
+	EventQuery(const EventStore& store) : store(store), type(EVENT_NONE), anyType(true), system(EVENT_NONE), anySystem(true),
+		from(std::numeric_limits<int64_t>::min()), to(std::numeric_limits<int64_t>::max()), groupBy(EVENT_GROUP_NONE), groupField(EVENT_NONE)
+	{
+	}
+
+	EventQuery& Type(const std::string& name)
+	{
+		type = store.FindType(name);
+		anyType = false;
+		return *this;
+	}
+
+	// seconds since 1970, [from, to)
+	EventQuery& Between(int64_t from, int64_t to)
+	{
+		this->from = from;
+		this->to = to;
+		return *this;
+	}
+
+	EventQuery& System(const std::string& name)
+	{
+		system = store.FindSystem(name);
+		anySystem = false;
+		return *this;
+	}
+
+	// events with a number field in [min, max]
+	EventQuery& Where(const std::string& field, double min, double max)
+	{
+		NumberFilter filter;
+		filter.field = store.FindField(field);
+		filter.min = min;
+		filter.max = max;
+		numberFilters.push_back(filter);
+		return *this;
+	}
+
+	// events with a string field equal to value
+	EventQuery& Where(const std::string& field, const std::string& value)
+	{
+		StringFilter filter;
+		filter.field = store.FindField(field);
+		filter.code = store.FindString(value);
+		stringFilters.push_back(filter);
+		return *this;
+	}
+
+	// field only for EVENT_GROUP_FIELD, a string field
+	EventQuery& GroupBy(EventGroupBy by, const std::string& field = "")
+	{
+		groupBy = by;
+		groupField = by == EVENT_GROUP_FIELD ? store.FindField(field) : EVENT_NONE;
+		return *this;
+	}
+
+	std::vector<uint32_t> Rows() const
+	{
+		std::vector<uint32_t> rows;
+		size_t first, end;
+		store.FindTimeRange(from, to, first, end);
+
+		if ((!anyType && type == EVENT_NONE) || (!anySystem && system == EVENT_NONE))
+			return rows;
+
+		if (!anyType)
+		{
+			const std::vector<uint32_t>& typeRows = store.GetTypeRows(type);
+			auto begin = std::lower_bound(typeRows.begin(), typeRows.end(), (uint32_t)first);
+			auto stop = std::lower_bound(begin, typeRows.end(), (uint32_t)end);
+			rows.assign(begin, stop);
+		}
+		else
+		{
+			rows.resize(end - first);
+
+			for (size_t i = 0; i < rows.size(); i++)
+				rows[i] = (uint32_t)(first + i);
+		}
+
+		// unsorted stores only get a row range of everything, the times are checked here
+		if (!store.IsSorted())
+		{
+			uint32_t low = store.offset(from), high = store.offset(to);
+			keep(rows, [&](uint32_t row) { return store.times[row] >= low && store.times[row] < high; });
+		}
+
+		if (!anySystem)
+			keep(rows, [&](uint32_t row) { return store.GetSystem(row) == system; });
+
+		for (const NumberFilter& filter : numberFilters)
+		{
+			FieldColumns<EventNumberColumn> columns = numberColumns(filter.field);
+
+			if (!columns.any)
+			{
+				rows.clear();
+				break;
+			}
+
+			double min = filter.min, max = filter.max;
+			keep(rows, [&](uint32_t row) {
+				size_t i;
+				const EventNumberColumn* column = columns.Find(row, typeOf(row), i);
+				return column && column->values[i] >= min && column->values[i] <= max;
+			});
+		}
+
+		for (const StringFilter& filter : stringFilters)
+		{
+			FieldColumns<EventStringColumn> columns = stringColumns(filter.field);
+
+			if (!columns.any || filter.code == EVENT_NONE)
+			{
+				rows.clear();
+				break;
+			}
+
+			uint32_t code = filter.code;
+			keep(rows, [&](uint32_t row) {
+				size_t i;
+				const EventStringColumn* column = columns.Find(row, typeOf(row), i);
+				return column && column->codes[i] == code;
+			});
+		}
+
+		return rows;
+	}
+
+	size_t Count() const
+	{
+		return Rows().size();
+	}
+
+	// Count, sum, min and max of a number field per group, sorted by key. Rows without the field
+	// are left out; with no field every row counts and the values are its count.
+	std::vector<EventGroup> Aggregate(const std::string& field = "") const
+	{
+		std::vector<EventGroup> groups;
+		std::vector<uint32_t> rows = Rows();
+		FieldColumns<EventNumberColumn> fieldValues = numberColumns(field.empty() ? EVENT_NONE : store.FindField(field));
+		FieldColumns<EventNumberColumn>* values = field.empty() ? NULL : &fieldValues;
+
+		if (rows.empty() || (values && !values->any))
+			return groups;
+
+		// string codes can run into the millions, the other keys get a slot each
+		if (groupBy == EVENT_GROUP_FIELD)
+		{
+			FieldColumns<EventStringColumn> keys = stringColumns(groupField);
+			std::unordered_map<int64_t, EventGroup> found;
+
+			if (!keys.any)
+				return groups;
+
+			scan(rows, values, [&](uint32_t row) {
+				size_t i;
+				const EventStringColumn* column = keys.Find(row, typeOf(row), i);
+				return column ? (int64_t)column->codes[i] : -1;
+			}, [&](int64_t key, double value) {
+				auto it = found.find(key);
+
+				if (it == found.end())
+					it = found.insert(std::make_pair(key, emptyGroup(key))).first;
+
+				add(it->second, value);
+			});
+
+			for (const auto& group : found)
+				groups.push_back(group.second);
+
+			std::sort(groups.begin(), groups.end(), [](const EventGroup& a, const EventGroup& b) { return a.key < b.key; });
+			return groups;
+		}
+
+		int64_t low = 0, high = 0;
+
+		if (groupBy == EVENT_GROUP_DAY)
+		{
+			uint32_t first = store.times[rows.front()], last = store.times[rows.back()];
+
+			if (!store.IsSorted())
+			{
+				first = last = store.times[rows.front()];
+
+				for (uint32_t row : rows)
+				{
+					first = std::min(first, store.times[row]);
+					last = std::max(last, store.times[row]);
+				}
+			}
+
+			low = day(first);
+			high = day(last);
+		}
+		else if (groupBy == EVENT_GROUP_TYPE)
+		{
+			high = (int64_t)store.GetTypeCount() - 1;
+		}
+		else if (groupBy == EVENT_GROUP_SYSTEM)
+		{
+			low = -1;
+			high = (int64_t)store.GetSystemCount() - 1;
+		}
+
+		std::vector<EventGroup> slots;
+		slots.reserve((size_t)(high - low + 1));
+
+		for (int64_t key = low; key <= high; key++)
+			slots.push_back(emptyGroup(key));
+
+		auto accumulate = [&](int64_t key, double value) { add(slots[(size_t)(key - low)], value); };
+
+		switch (groupBy)
+		{
+		case EVENT_GROUP_DAY:
+			scan(rows, values, [&](uint32_t row) { return day(store.times[row]); }, accumulate);
+			break;
+		case EVENT_GROUP_TYPE:
+			scan(rows, values, [&](uint32_t row) { return (int64_t)store.types[row]; }, accumulate);
+			break;
+		case EVENT_GROUP_SYSTEM:
+			scan(rows, values, [&](uint32_t row) { return (int64_t)store.systems[row] - 1; }, accumulate);
+			break;
+		default:
+			scan(rows, values, [](uint32_t) { return (int64_t)0; }, accumulate);
+			break;
+		}
+
+		for (const EventGroup& group : slots)
+			if (group.count > 0)
+				groups.push_back(group);
+
+		return groups;
+	}
+
+private:
+	struct NumberFilter {
+		uint32_t field;
+		double min;
+		double max;
+	};
+
+	struct StringFilter {
+		uint32_t field;
+		uint32_t code;
+	};
+
+	// The columns of one field per event type, NULL for the types that never had it, each with a
+	// cursor that walks it along ascending rows. Only the queried type's column if there is one.
+	template <typename C>
+	struct FieldColumns {
+		std::vector<const C*> columns;
+		std::vector<size_t> next;
+		bool any = false;
+
+		// the column of row's type with index set to row's place in it, NULL if row lacks the field
+		const C* Find(uint32_t row, uint32_t type, size_t& index)
+		{
+			const C* column = columns[type];
+
+			if (!column)
+				return NULL;
+
+			index = next[type] = advance(column->rows, next[type], row);
+			return index < column->rows.size() && column->rows[index] == row ? column : NULL;
+		}
+	};
+
+	const EventStore& store;
+	uint32_t type;
+	bool anyType;
+	uint32_t system;
+	bool anySystem;
+	int64_t from;
+	int64_t to;
+	std::vector<NumberFilter> numberFilters;
+	std::vector<StringFilter> stringFilters;
+	EventGroupBy groupBy;
+	uint32_t groupField;
+
+	uint32_t typeOf(uint32_t row) const
+	{
+		return anyType ? store.types[row] : type;
+	}
+
+	template <typename C, typename G>
+	FieldColumns<C> columnsOf(uint32_t field, G get) const
+	{
+		FieldColumns<C> result;
+		result.columns.assign(store.GetTypeCount(), NULL);
+		result.next.assign(store.GetTypeCount(), 0);
+
+		for (uint32_t t = 0; t < store.GetTypeCount() && field != EVENT_NONE; t++)
+		{
+			if (anyType || t == type)
+			{
+				result.columns[t] = get(t, field);
+				result.any = result.any || result.columns[t];
+			}
+		}
+
+		return result;
+	}
+
+	FieldColumns<EventNumberColumn> numberColumns(uint32_t field) const
+	{
+		return columnsOf<EventNumberColumn>(field, [&](uint32_t t, uint32_t f) { return store.GetNumbers(t, f); });
+	}
+
+	FieldColumns<EventStringColumn> stringColumns(uint32_t field) const
+	{
+		return columnsOf<EventStringColumn>(field, [&](uint32_t t, uint32_t f) { return store.GetStrings(t, f); });
+	}
+
+	template <typename F>
+	static void keep(std::vector<uint32_t>& rows, F predicate)
+	{
+		size_t kept = 0;
+
+		for (size_t i = 0; i < rows.size(); i++)
+		{
+			rows[kept] = rows[i];
+			kept += predicate(rows[i]) ? 1 : 0;
+		}
+
+		rows.resize(kept);
+	}
+
+	// first index from j on with columnRows[index] >= row; a step at a time when the column is
+	// about as dense as the rows, by binary search when it is far denser
+	static size_t advance(const std::vector<uint32_t>& columnRows, size_t j, uint32_t row)
+	{
+		for (int step = 0; step < 8; step++, j++)
+			if (j == columnRows.size() || columnRows[j] >= row)
+				return j;
+
+		return std::lower_bound(columnRows.begin() + j, columnRows.end(), row) - columnRows.begin();
+	}
+
+	// add(key(row), value) for every row with a value, 1 each without values
+	template <typename K, typename A>
+	void scan(const std::vector<uint32_t>& rows, FieldColumns<EventNumberColumn>* values, K key, A add) const
+	{
+		for (uint32_t row : rows)
+		{
+			if (!values)
+			{
+				add(key(row), 1.0);
+				continue;
+			}
+
+			size_t i;
+			const EventNumberColumn* column = values->Find(row, typeOf(row), i);
+
+			if (column)
+				add(key(row), column->values[i]);
+		}
+	}
+
+	static EventGroup emptyGroup(int64_t key)
+	{
+		EventGroup group;
+		group.key = key;
+		group.count = 0;
+		group.sum = 0.0;
+		group.min = std::numeric_limits<double>::max();
+		group.max = -std::numeric_limits<double>::max();
+		return group;
+	}
+
+	static void add(EventGroup& group, double value)
+	{
+		group.count++;
+		group.sum += value;
+		group.min = std::min(group.min, value);
+		group.max = std::max(group.max, value);
+	}
+
+	int64_t day(uint32_t time) const
+	{
+		return floorDiv(EVENT_EPOCH + time, EVENT_SECONDS_PER_DAY);
+	}
+
+	static int64_t floorDiv(int64_t a, int64_t b)
+	{
+		return a / b - (a % b != 0 && (a < 0) != (b < 0));
+	}
+};
+
+inline EventQuery EventStore::Query() const
+{
+	return EventQuery(*this);
+}
+
+#endif
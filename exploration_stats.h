@@ -0,0 +1,479 @@
+#ifndef EXPLORATION_STATS_H
+#define EXPLORATION_STATS_H
+
+#include <glm/glm.hpp>
+
+#include "External Libraries/rapidjson/prettywriter.h"
+#include "External Libraries/rapidjson/stringbuffer.h"
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "journal_reader.h"
+#include "jump_history.h"
+#include "star_store.h"
+
+const int STATS_CLASS_COUNT = StarClass::GENERIC + 1;
+const char* const STATS_CLASS_NAMES[STATS_CLASS_COUNT] = { "O", "B", "A", "F", "G", "K", "L", "M", "T", "Y", "D", "Other" };
+const size_t STATS_NONE = (size_t)-1;
+
+// Below this many items per thread a reduction runs on the calling thread alone; a few new jumps
+// are not worth starting threads for.
+const size_t STATS_PARALLEL_MIN = 1 << 16;
+
+// jumps, their distance and how they fall on days
+struct JumpTotals {
+	uint64_t jumps = 0;
+	double distance = 0.0;		// light years
+	size_t longestJump = STATS_NONE;
+	float longest = 0.0f;
+	int64_t firstDay = 0;		// days since 1970 of perDay[0]
+	std::vector<uint32_t> perDay;
+
+	void Add(size_t jump, int64_t day, float jumpDistance)
+	{
+		if (perDay.empty())
+			firstDay = day;
+
+		// jumps are in time order, days only grow
+		if (day - firstDay >= (int64_t)perDay.size())
+			perDay.resize((size_t)(day - firstDay + 1), 0);
+
+		perDay[(size_t)(day - firstDay)]++;
+		jumps++;
+		distance += jumpDistance;
+
+		if (jumpDistance > longest || longestJump == STATS_NONE)
+		{
+			longest = jumpDistance;
+			longestJump = jump;
+		}
+	}
+
+	// other covers later jumps
+	void Merge(const JumpTotals& other)
+	{
+		if (other.jumps == 0)
+			return;
+
+		if (perDay.empty())
+			firstDay = other.firstDay;
+
+		size_t offset = (size_t)(other.firstDay - firstDay);
+
+		if (offset + other.perDay.size() > perDay.size())
+			perDay.resize(offset + other.perDay.size(), 0);
+
+		for (size_t day = 0; day < other.perDay.size(); day++)
+			perDay[offset + day] += other.perDay[day];
+
+		jumps += other.jumps;
+		distance += other.distance;
+
+		if (other.longest > longest || longestJump == STATS_NONE)
+		{
+			longest = other.longest;
+			longestJump = other.longestJump;
+		}
+	}
+};
+
+// the point farthest from Sol, earliest on a tie
+struct FarthestTotals {
+	size_t index = STATS_NONE;
+	double distance2 = -1.0;	// light years squared
+
+	void Add(size_t i, const glm::dvec3& position)
+	{
+		double d2 = glm::dot(position, position);
+
+		if (d2 > distance2)
+		{
+			distance2 = d2;
+			index = i;
+		}
+	}
+
+	void Merge(const FarthestTotals& other)
+	{
+		if (other.distance2 > distance2)
+		{
+			distance2 = other.distance2;
+			index = other.index;
+		}
+	}
+};
+
+struct ClassTotals {
+	uint64_t counts[STATS_CLASS_COUNT] = {};
+
+	void Add(int starClass)
+	{
+		counts[starClass >= 0 && starClass < STATS_CLASS_COUNT ? starClass : StarClass::GENERIC]++;
+	}
+
+	void Merge(const ClassTotals& other)
+	{
+		for (int c = 0; c < STATS_CLASS_COUNT; c++)
+			counts[c] += other.counts[c];
+	}
+};
+
+// Exploration statistics over the jump history, the visited systems and optionally a galaxy
+// StarStore. All three only ever grow at the end, so each Update() folds in just what was added
+// since the last one. Large folds are split into contiguous chunks reduced on threadCount threads
+// and merged in chunk order, sums come out the same for the same thread count.
+class ExplorationStats
+{
+public:
+	unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	ExplorationStats() : syncedJumps(0), syncedSystems(0), syncedVisited(0), syncedStars(0), history(NULL), farthestKnownPosition(0.0)
+	{
+	}
+
+	// true if anything changed
+	bool Update(const JumpHistory& history, const std::vector<Coordinate>& visited)
+	{
+		bool changed = false;
+		size_t end = history.GetJumpCount();
+
+		if (end > syncedJumps)
+		{
+			jumps.Merge(reduce<JumpTotals>(syncedJumps, end, [&history](JumpTotals& totals, size_t first, size_t last) {
+				for (size_t j = first; j < last; j++)
+					totals.Add(j, floorDiv(history.GetTime(j), 86400), history.GetJump(j).distance);
+			}));
+
+			syncedJumps = end;
+			changed = true;
+		}
+
+		end = history.GetSystemCount();
+
+		if (end > syncedSystems)
+		{
+			farthestSystem.Merge(reduce<FarthestTotals>(syncedSystems, end, [&history](FarthestTotals& totals, size_t first, size_t last) {
+				for (size_t s = first; s < last; s++)
+					totals.Add(s, history.GetPosition((uint32_t)s));
+			}));
+
+			syncedSystems = end;
+			changed = true;
+		}
+
+		if (visited.size() > syncedVisited)
+		{
+			visitedClasses.Merge(reduce<ClassTotals>(syncedVisited, visited.size(), [&visited](ClassTotals& totals, size_t first, size_t last) {
+				for (size_t i = first; i < last; i++)
+					totals.Add(visited[i].starClass);
+			}));
+
+			syncedVisited = visited.size();
+			changed = true;
+		}
+
+		this->history = &history;
+		return changed;
+	}
+
+	// Systems known to the map per class and the farthest of them, e.g. over GALAXY_SNAPSHOT. The
+	// store may go away afterwards, the farthest system's name is kept.
+	bool Update(const StarStore& stars)
+	{
+		if (stars.Size() <= syncedStars)
+			return false;
+
+		KnownTotals totals = reduce<KnownTotals>(syncedStars, stars.Size(), [&stars](KnownTotals& partial, size_t first, size_t last) {
+			for (size_t i = first; i < last; i++)
+			{
+				partial.classes.Add(stars.stars[i].starClass);
+				partial.farthest.Add(i, stars.GetPosition(i));
+				partial.neutrons += stars.IsNeutron(i);
+			}
+		});
+
+		size_t farthest = known.farthest.index;
+		known.Merge(totals);
+		syncedStars = stars.Size();
+
+		if (known.farthest.index != farthest)
+		{
+			farthestKnownName = stars.GetName(known.farthest.index);
+			farthestKnownPosition = stars.GetPosition(known.farthest.index);
+		}
+
+		return true;
+	}
+
+	uint64_t GetJumpCount() const { return jumps.jumps; }
+	double GetDistance() const { return jumps.distance; }
+	size_t GetLongestJump() const { return jumps.longestJump; }
+	size_t GetSystemCount() const { return syncedSystems; }
+
+	// jumps per day from GetFirstDay() (days since 1970) on, days without jumps included
+	const std::vector<uint32_t>& GetJumpsPerDay() const { return jumps.perDay; }
+	int64_t GetFirstDay() const { return jumps.firstDay; }
+
+	size_t GetActiveDays() const
+	{
+		return jumps.perDay.size() - std::count(jumps.perDay.begin(), jumps.perDay.end(), 0u);
+	}
+
+	// days since 1970 with the most jumps, the first of them on a tie
+	int64_t GetBusiestDay() const
+	{
+		return jumps.firstDay + (std::max_element(jumps.perDay.begin(), jumps.perDay.end()) - jumps.perDay.begin());
+	}
+
+	// history system index, STATS_NONE without jumps
+	size_t GetFarthestSystem() const { return farthestSystem.index; }
+	double GetFarthestDistance() const { return std::sqrt(std::max(farthestSystem.distance2, 0.0)); }
+
+	uint64_t GetVisitedCount(StarClass starClass) const { return visitedClasses.counts[starClass]; }
+
+	uint64_t GetKnownCount() const { return syncedStars; }
+	uint64_t GetKnownCount(StarClass starClass) const { return known.classes.counts[starClass]; }
+	uint64_t GetKnownNeutrons() const { return known.neutrons; }
+	const std::string& GetFarthestKnownName() const { return farthestKnownName; }
+	const glm::dvec3& GetFarthestKnownPosition() const { return farthestKnownPosition; }
+	double GetFarthestKnownDistance() const { return std::sqrt(std::max(known.farthest.distance2, 0.0)); }
+
+	// one line for the window title
+	std::string Summary() const
+	{
+		char text[256];
+		snprintf(text, sizeof(text), "%llu jumps, %.0f ly, %zu systems, farthest %.0f ly from Sol", (unsigned long long)jumps.jumps, jumps.distance, syncedSystems, GetFarthestDistance());
+		return text;
+	}
+
+	// a few lines for a TextOverlay
+	std::string Report() const
+	{
+		char line[256];
+		std::string text = Summary();
+
+		if (history && jumps.longestJump != STATS_NONE)
+		{
+			snprintf(line, sizeof(line), "\nlongest jump %.2f ly to %s", jumps.longest, history->GetName(history->GetJump(jumps.longestJump).to).c_str());
+			text += line;
+		}
+
+		if (history && farthestSystem.index != STATS_NONE)
+			text += "\nfarthest system " + history->GetName((uint32_t)farthestSystem.index);
+
+		if (!jumps.perDay.empty())
+		{
+			snprintf(line, sizeof(line), "\n%zu active days, busiest %s with %u jumps", GetActiveDays(), formatDay(GetBusiestDay()).c_str(), *std::max_element(jumps.perDay.begin(), jumps.perDay.end()));
+			text += line;
+		}
+
+		text += "\nvisited";
+
+		for (int c = 0; c < STATS_CLASS_COUNT; c++)
+			if (visitedClasses.counts[c] > 0)
+				text += std::string(" ") + STATS_CLASS_NAMES[c] + " " + std::to_string(visitedClasses.counts[c]);
+
+		if (syncedStars > 0)
+		{
+			snprintf(line, sizeof(line), "\n%llu known systems, %llu neutron stars, farthest %s at %.0f ly", (unsigned long long)syncedStars, (unsigned long long)known.neutrons, farthestKnownName.c_str(), GetFarthestKnownDistance());
+			text += line;
+		}
+
+		return text;
+	}
+
+	bool WriteJson(const std::string& path) const
+	{
+		rapidjson::StringBuffer buffer;
+		rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+
+		writer.StartObject();
+		writer.Key("jumps");
+		writer.Uint64(jumps.jumps);
+		writer.Key("distance");
+		writer.Double(jumps.distance);
+		writer.Key("systems");
+		writer.Uint64(syncedSystems);
+
+		if (history && jumps.longestJump != STATS_NONE)
+		{
+			const JumpRecord& jump = history->GetJump(jumps.longestJump);
+
+			writer.Key("longestJump");
+			writer.StartObject();
+			writer.Key("timestamp");
+			writer.String(JumpHistory::FormatTimestamp(history->GetTime(jumps.longestJump)).c_str());
+			writer.Key("to");
+			writer.String(history->GetName(jump.to).c_str());
+			writer.Key("distance");
+			writer.Double(jump.distance);
+			writer.EndObject();
+		}
+
+		if (history && farthestSystem.index != STATS_NONE)
+		{
+			writer.Key("farthest");
+			writer.StartObject();
+			writer.Key("system");
+			writer.String(history->GetName((uint32_t)farthestSystem.index).c_str());
+			writer.Key("distance");
+			writer.Double(GetFarthestDistance());
+			writer.EndObject();
+		}
+
+		if (!jumps.perDay.empty())
+		{
+			writer.Key("activeDays");
+			writer.Uint64(GetActiveDays());
+			writer.Key("busiestDay");
+			writer.String(formatDay(GetBusiestDay()).c_str());
+
+			// days without jumps left out
+			writer.Key("jumpsPerDay");
+			writer.StartObject();
+
+			for (size_t day = 0; day < jumps.perDay.size(); day++)
+			{
+				if (jumps.perDay[day] == 0)
+					continue;
+
+				writer.Key(formatDay(jumps.firstDay + day).c_str());
+				writer.Uint(jumps.perDay[day]);
+			}
+
+			writer.EndObject();
+		}
+
+		writer.Key("visitedClasses");
+		writeClasses(writer, visitedClasses);
+
+		if (syncedStars > 0)
+		{
+			writer.Key("known");
+			writer.Uint64(syncedStars);
+			writer.Key("knownNeutrons");
+			writer.Uint64(known.neutrons);
+			writer.Key("knownClasses");
+			writeClasses(writer, known.classes);
+
+			if (known.farthest.index != STATS_NONE)
+			{
+				writer.Key("farthestKnown");
+				writer.StartObject();
+				writer.Key("system");
+				writer.String(farthestKnownName.c_str());
+				writer.Key("distance");
+				writer.Double(GetFarthestKnownDistance());
+				writer.EndObject();
+			}
+		}
+
+		writer.EndObject();
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+		if (!file || !file.write(buffer.GetString(), buffer.GetSize()))
+		{
+			std::cout << "ERROR::EXPLORATION_STATS::FILE_NOT_WRITTEN: " << path << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+private:
+	struct KnownTotals {
+		ClassTotals classes;
+		FarthestTotals farthest;
+		uint64_t neutrons = 0;
+
+		void Merge(const KnownTotals& other)
+		{
+			classes.Merge(other.classes);
+			farthest.Merge(other.farthest);
+			neutrons += other.neutrons;
+		}
+	};
+
+	JumpTotals jumps;
+	FarthestTotals farthestSystem;
+	ClassTotals visitedClasses;
+	KnownTotals known;
+
+	// how far each source has been folded in
+	size_t syncedJumps;
+	size_t syncedSystems;
+	size_t syncedVisited;
+	size_t syncedStars;
+
+	const JumpHistory* history;	// for names in WriteJson()
+	std::string farthestKnownName;
+	glm::dvec3 farthestKnownPosition;	// light years
+
+	// fold(partial, first, last) over [first, end) in contiguous chunks, the first of them on the
+	// calling thread
+	template <typename Partial, typename Fold>
+	Partial reduce(size_t first, size_t end, Fold fold) const
+	{
+		size_t count = end - first;
+		size_t threads = std::max((size_t)1, std::min((size_t)threadCount, count / STATS_PARALLEL_MIN));
+		std::vector<Partial> partials(threads);
+
+		if (threads == 1)
+		{
+			fold(partials[0], first, end);
+			return partials[0];
+		}
+
+		std::vector<std::thread> workers;
+
+		for (size_t t = 1; t < threads; t++)
+		{
+			size_t chunkFirst = first + count * t / threads;
+			size_t chunkEnd = first + count * (t + 1) / threads;
+			workers.emplace_back([&partials, &fold, t, chunkFirst, chunkEnd]() { fold(partials[t], chunkFirst, chunkEnd); });
+		}
+
+		fold(partials[0], first, first + count / threads);
+
+		for (std::thread& w : workers)
+			w.join();
+
+		for (size_t t = 1; t < threads; t++)
+			partials[0].Merge(partials[t]);
+
+		return partials[0];
+	}
+
+	static void writeClasses(rapidjson::PrettyWriter<rapidjson::StringBuffer>& writer, const ClassTotals& classes)
+	{
+		writer.StartObject();
+
+		for (int c = 0; c < STATS_CLASS_COUNT; c++)
+		{
+			writer.Key(STATS_CLASS_NAMES[c]);
+			writer.Uint64(classes.counts[c]);
+		}
+
+		writer.EndObject();
+	}
+
+	static std::string formatDay(int64_t day)
+	{
+		return JumpHistory::FormatTimestamp(day * 86400).substr(0, 10);
+	}
+
+	static int64_t floorDiv(int64_t a, int64_t b)
+	{
+		return a >= 0 ? a / b : -((-a + b - 1) / b);
+	}
+};
+
+#endif
@@ -0,0 +1,547 @@
+#ifndef GALAXY_IMPORTER_H
+#define GALAXY_IMPORTER_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+
+#include "External Libraries/rapidjson/document.h"
+
+#include <inflate.h>
+
+#include "journal_reader.h"
+#include "star_store.h"
+
+// Sequential block reader over a plain or gzip compressed file.
+class DumpReader
+{
+public:
+	~DumpReader()
+	{
+		Close();
+	}
+
+	bool Open(const std::string& path)
+	{
+		std::ifstream probe(path, std::ios::in | std::ios::binary | std::ios::ate);
+
+		if (!probe.is_open())
+		{
+			std::cout << "ERROR::IMPORT:: Could not open " << path << std::endl;
+			return false;
+		}
+
+		fileSize = (uint64_t)probe.tellg();
+		probe.close();
+
+		this->path = path;
+
+		if (path.size() > 3 && path.compare(path.size() - 3, 3, ".gz") == 0)
+		{
+			gz = inflate_open(path.c_str());
+			return gz != NULL;
+		}
+
+		plain.open(path, std::ios::in | std::ios::binary);
+		return plain.is_open();
+	}
+
+	size_t Read(char* dst, size_t size)
+	{
+		if (gz)
+		{
+			ptrdiff_t n = inflate_read(gz, dst, size);
+
+			if (n < 0)
+				std::cout << "ERROR::IMPORT:: " << path << ": " << inflate_error(gz) << std::endl;
+
+			return n > 0 ? (size_t)n : 0;
+		}
+
+		plain.read(dst, size);
+		return (size_t)plain.gcount();
+	}
+
+	// position in the file on disk, used for progress on compressed input as well
+	uint64_t GetPosition()
+	{
+		if (gz)
+			return inflate_offset(gz);
+
+		return plain ? (uint64_t)plain.tellg() : fileSize;
+	}
+
+	uint64_t GetFileSize() const { return fileSize; }
+
+	void Close()
+	{
+		inflate_close(gz);
+		gz = NULL;
+
+		if (plain.is_open())
+			plain.close();
+	}
+
+private:
+	std::ifstream plain;
+	std::string path;
+	uint64_t fileSize = 0;
+	inflate_file* gz = NULL;
+};
+
+// Fixed capacity queue, Push blocks while full so the reader can never run ahead of the parsers.
+template <typename T>
+class BoundedQueue
+{
+public:
+	BoundedQueue(size_t capacity) : capacity(capacity), closed(false) { }
+
+	void Push(T item)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		notFull.wait(lock, [&] { return items.size() < capacity; });
+		items.push_back(std::move(item));
+		notEmpty.notify_one();
+	}
+
+	// false once the queue is closed and drained
+	bool Pop(T& item)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		notEmpty.wait(lock, [&] { return !items.empty() || closed; });
+
+		if (items.empty())
+			return false;
+
+		item = std::move(items.front());
+		items.pop_front();
+		notFull.notify_one();
+
+		return true;
+	}
+
+	void Close()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closed = true;
+		notEmpty.notify_all();
+	}
+
+private:
+	std::deque<T> items;
+	size_t capacity;
+	bool closed;
+	std::mutex mutex;
+	std::condition_variable notEmpty;
+	std::condition_variable notFull;
+};
+
+// Streams a community galaxy dump (one JSON object per line, optionally wrapped in [ ], or CSV
+// with a header row; plain or .gz) into a star snapshot. Decompression runs on the calling
+// thread, parsing on worker threads; memory stays at roughly (queue depth + threads) * chunkSize.
+class GalaxyImporter
+{
+public:
+	// one core left for decompression; hardware_concurrency() is 0 when it is not known
+	unsigned int threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	size_t chunkSize = 8 << 20;
+	unsigned int queueDepth = 8;
+
+	uint64_t importedCount = 0;
+	uint64_t skippedLines = 0;
+	uint64_t visitedMatched = 0;
+
+	bool Import(const std::string& dumpPath, const std::string& snapshotPath, const std::vector<Coordinate>& visited)
+	{
+		DumpReader reader;
+		if (!reader.Open(dumpPath))
+			return false;
+
+		StarSnapshotWriter writer;
+		if (!writer.Open(snapshotPath))
+			return false;
+
+		visitedIndex.clear();
+		for (size_t i = 0; i < visited.size(); i++)
+			visitedIndex[visited[i].name] = i;
+		std::vector<bool> matched(visited.size(), false);
+
+		parsedCount = 0;
+		skippedCount = 0;
+		csv = false;
+
+		BoundedQueue<std::string> chunks(queueDepth);
+		std::mutex writerMutex;
+		std::vector<std::thread> workers;
+
+		for (unsigned int t = 0; t < threadCount; t++)
+		{
+			workers.emplace_back([&]()
+			{
+				std::string chunk;
+				std::vector<ParsedSystem> systems;
+
+				while (chunks.Pop(chunk))
+				{
+					systems.clear();
+					parseChunk(chunk, systems);
+
+					std::lock_guard<std::mutex> lock(writerMutex);
+
+					for (const ParsedSystem& s : systems)
+					{
+						uint8_t flags = s.flags;
+						auto it = visitedIndex.find(s.name);
+
+						if (it != visitedIndex.end())
+						{
+							flags |= STAR_VISITED;
+							matched[it->second] = true;
+						}
+
+						writer.Append(s.position, s.name.c_str(), s.name.size(), s.starClass, flags);
+					}
+				}
+			});
+		}
+
+		double start = now();
+		double lastReport = start;
+		std::string carry;
+		std::vector<char> block(chunkSize);
+		bool first = true;
+
+		while (true)
+		{
+			size_t n = reader.Read(block.data(), block.size());
+
+			if (n == 0)
+				break;
+
+			std::string chunk;
+			chunk.swap(carry);
+			chunk.append(block.data(), n);
+
+			size_t lastNewline = chunk.find_last_of('\n');
+
+			if (lastNewline == std::string::npos)
+			{
+				carry.swap(chunk);
+				continue;
+			}
+
+			carry.assign(chunk, lastNewline + 1, std::string::npos);
+			chunk.resize(lastNewline + 1);
+
+			if (first)
+			{
+				chunk.erase(0, detectFormat(chunk));
+				first = false;
+			}
+
+			chunks.Push(std::move(chunk));
+
+			double t = now();
+
+			if (t - lastReport >= 1.0)
+			{
+				reportProgress(reader, t - start);
+				lastReport = t;
+			}
+		}
+
+		if (!carry.empty())
+		{
+			if (first)
+				carry.erase(0, detectFormat(carry));
+			chunks.Push(std::move(carry));
+		}
+
+		chunks.Close();
+
+		for (std::thread& w : workers)
+			w.join();
+
+		// journal systems missing from the dump are still part of the map
+		visitedMatched = 0;
+		for (size_t i = 0; i < visited.size(); i++)
+		{
+			if (matched[i])
+			{
+				visitedMatched++;
+				continue;
+			}
+
+			writer.Append(visited[i].coords, visited[i].name.c_str(), visited[i].name.size(), visited[i].starClass, STAR_VISITED);
+		}
+
+		importedCount = writer.GetCount();
+		skippedLines = skippedCount;
+		writer.Close();
+
+		double seconds = now() - start;
+		std::cout << "Import finished: " << importedCount << " systems in " << seconds << " s (" << (uint64_t)(importedCount / std::max(seconds, 0.001)) << " systems/s), "
+			<< visitedMatched << " of " << visited.size() << " visited systems matched, " << skippedLines << " lines skipped" << std::endl;
+
+		return true;
+	}
+
+	// maps "G (White-Yellow) Star", "White Dwarf (DA) Star", "Neutron Star", "K" ... onto StarClass
+	static StarClass StarClassFromDescription(const std::string& description)
+	{
+		if (description.empty())
+			return StarClass::GENERIC;
+
+		if (description.compare(0, 11, "White Dwarf") == 0)
+		{
+			size_t open = description.find('(');
+			size_t close = description.find(')');
+
+			if (open != std::string::npos && close != std::string::npos && close > open)
+				return JournalReader::EvaluateStarClass(description.substr(open + 1, close - open - 1));
+
+			return StarClass::D;
+		}
+
+		if (description.compare(0, 7, "T Tauri") == 0)
+			return JournalReader::EvaluateStarClass("TTS");
+		if (description.compare(0, 7, "Neutron") == 0)
+			return JournalReader::EvaluateStarClass("N");
+		if (description.find("Black Hole") != std::string::npos)
+			return JournalReader::EvaluateStarClass("H");
+
+		size_t space = description.find(' ');
+		return JournalReader::EvaluateStarClass(space == std::string::npos ? description : description.substr(0, space));
+	}
+
+	// StarFlags that follow from the primary star, same descriptions as StarClassFromDescription
+	static uint8_t StarFlagsFromDescription(const std::string& description)
+	{
+		if (description.compare(0, 7, "Neutron") == 0 || description == "N")
+			return STAR_NEUTRON;
+
+		return 0;
+	}
+
+private:
+	struct ParsedSystem
+	{
+		std::string name;
+		glm::dvec3 position;
+		StarClass starClass;
+		uint8_t flags;
+	};
+
+	std::unordered_map<std::string, size_t> visitedIndex;
+	std::atomic<uint64_t> parsedCount;
+	std::atomic<uint64_t> skippedCount;
+
+	bool csv = false;
+	int csvName = -1, csvX = -1, csvY = -1, csvZ = -1, csvClass = -1;
+
+	static double now()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void reportProgress(DumpReader& reader, double seconds)
+	{
+		uint64_t parsed = parsedCount;
+		double percent = 100.0 * (double)reader.GetPosition() / (double)std::max<uint64_t>(reader.GetFileSize(), 1);
+
+		std::cout << "Import: " << (int)percent << "%, " << parsed << " systems, " << (uint64_t)(parsed / std::max(seconds, 0.001)) << " systems/s" << std::endl;
+	}
+
+	// returns the length of the CSV header line, 0 for JSON
+	size_t detectFormat(const std::string& chunk)
+	{
+		size_t begin = chunk.find_first_not_of(" \t\r\n");
+
+		if (begin == std::string::npos || chunk[begin] == '[' || chunk[begin] == '{')
+			return 0;
+
+		// CSV: the header is the first line, remember the columns and drop it
+		csv = true;
+
+		size_t end = chunk.find('\n', begin);
+		std::vector<std::string> columns;
+		splitCsv(chunk.c_str() + begin, (end == std::string::npos ? chunk.size() : end) - begin, columns);
+
+		for (int i = 0; i < (int)columns.size(); i++)
+		{
+			std::string c = columns[i];
+			for (char& ch : c)
+				ch = (char)std::tolower((unsigned char)ch);
+
+			if (c == "name" || c == "system" || c == "systemname" || c == "starsystem")
+				csvName = i;
+			else if (c == "x" || c == "coords_x" || c == "starpos_x")
+				csvX = i;
+			else if (c == "y" || c == "coords_y" || c == "starpos_y")
+				csvY = i;
+			else if (c == "z" || c == "coords_z" || c == "starpos_z")
+				csvZ = i;
+			else if (c == "primary_star" || c == "primarystar" || c == "mainstar" || c == "main_star" || c == "star_class" || c == "starclass" || c == "type")
+				csvClass = i;
+		}
+
+		if (csvName < 0 || csvX < 0 || csvY < 0 || csvZ < 0)
+			std::cout << "ERROR::IMPORT:: CSV header lacks name/x/y/z columns" << std::endl;
+
+		return end == std::string::npos ? chunk.size() : end + 1;
+	}
+
+	void parseChunk(const std::string& chunk, std::vector<ParsedSystem>& systems)
+	{
+		const char* p = chunk.c_str();
+		const char* end = p + chunk.size();
+
+		std::vector<std::string> fields;
+		rapidjson::Document doc;
+
+		while (p < end)
+		{
+			const char* lineEnd = (const char*)std::memchr(p, '\n', end - p);
+			if (!lineEnd)
+				lineEnd = end;
+
+			ParsedSystem s;
+			bool ok = csv ? parseCsvLine(p, lineEnd - p, fields, s) : parseJsonLine(p, lineEnd - p, doc, s);
+
+			if (ok)
+				systems.push_back(std::move(s));
+
+			p = lineEnd + 1;
+		}
+
+		parsedCount += systems.size();
+	}
+
+	bool parseJsonLine(const char* line, size_t length, rapidjson::Document& doc, ParsedSystem& s)
+	{
+		while (length > 0 && (std::isspace((unsigned char)line[length - 1]) || line[length - 1] == ','))
+			length--;
+		while (length > 0 && std::isspace((unsigned char)*line))
+		{
+			line++;
+			length--;
+		}
+
+		if (length == 0 || line[0] == '[' || line[0] == ']')
+			return false;
+
+		doc.Parse(line, length);
+
+		if (doc.HasParseError() || !doc.IsObject() || !doc.HasMember("name") || !doc["name"].IsString() || !doc.HasMember("coords"))
+		{
+			skippedCount++;
+			return false;
+		}
+
+		const rapidjson::Value& coords = doc["coords"];
+
+		if (!coords.IsObject() || !coords.HasMember("x") || !coords.HasMember("y") || !coords.HasMember("z")
+			|| !coords["x"].IsNumber() || !coords["y"].IsNumber() || !coords["z"].IsNumber())
+		{
+			skippedCount++;
+			return false;
+		}
+
+		s.name = doc["name"].GetString();
+		s.position = glm::dvec3(coords["x"].GetDouble(), coords["y"].GetDouble(), coords["z"].GetDouble());
+		s.starClass = StarClass::GENERIC;
+		s.flags = 0;
+
+		if (doc.HasMember("primaryStar") && doc["primaryStar"].IsObject() && doc["primaryStar"].HasMember("type") && doc["primaryStar"]["type"].IsString())
+		{
+			s.starClass = StarClassFromDescription(doc["primaryStar"]["type"].GetString());
+			s.flags = StarFlagsFromDescription(doc["primaryStar"]["type"].GetString());
+		}
+		else if (doc.HasMember("mainStar") && doc["mainStar"].IsString())
+		{
+			s.starClass = StarClassFromDescription(doc["mainStar"].GetString());
+			s.flags = StarFlagsFromDescription(doc["mainStar"].GetString());
+		}
+		else if (doc.HasMember("StarClass") && doc["StarClass"].IsString())
+		{
+			s.starClass = JournalReader::EvaluateStarClass(doc["StarClass"].GetString());
+			s.flags = StarFlagsFromDescription(doc["StarClass"].GetString());
+		}
+
+		return true;
+	}
+
+	bool parseCsvLine(const char* line, size_t length, std::vector<std::string>& fields, ParsedSystem& s)
+	{
+		if (length > 0 && line[length - 1] == '\r')
+			length--;
+		if (length == 0)
+			return false;
+
+		splitCsv(line, length, fields);
+
+		int needed = std::max(std::max(csvName, csvX), std::max(csvY, csvZ));
+
+		if (csvName < 0 || (int)fields.size() <= needed)
+		{
+			skippedCount++;
+			return false;
+		}
+
+		s.name = fields[csvName];
+		s.position = glm::dvec3(std::strtod(fields[csvX].c_str(), NULL), std::strtod(fields[csvY].c_str(), NULL), std::strtod(fields[csvZ].c_str(), NULL));
+		s.starClass = (csvClass >= 0 && csvClass < (int)fields.size()) ? StarClassFromDescription(fields[csvClass]) : StarClass::GENERIC;
+		s.flags = (csvClass >= 0 && csvClass < (int)fields.size()) ? StarFlagsFromDescription(fields[csvClass]) : 0;
+
+		return true;
+	}
+
+	static void splitCsv(const char* line, size_t length, std::vector<std::string>& fields)
+	{
+		fields.clear();
+		fields.emplace_back();
+
+		bool quoted = false;
+
+		for (size_t i = 0; i < length; i++)
+		{
+			char c = line[i];
+
+			if (quoted)
+			{
+				if (c == '"' && i + 1 < length && line[i + 1] == '"')
+				{
+					fields.back().push_back('"');
+					i++;
+				}
+				else if (c == '"')
+					quoted = false;
+				else
+					fields.back().push_back(c);
+			}
+			else if (c == '"')
+				quoted = true;
+			else if (c == ',')
+				fields.emplace_back();
+			else if (c != '\r')
+				fields.back().push_back(c);
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,789 @@
+#ifndef GALAXY_OCTREE_H
+#define GALAXY_OCTREE_H
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <deque>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+
+#include "star_store.h"
+#include "shader.h"
+
+// On-disk layout of a .octree file:
+//   OctreeHeader | pages (4 KB aligned) | OctreeNode table
+// Each page holds the QuantizedStars of one node. Leaves keep all their systems, inner nodes keep
+// a sample of their subtree as representatives, so any cut through the tree is a complete
+// (if coarser) picture of the galaxy.
+
+struct QuantizedStar {
+	uint16_t x, y, z;	// position inside the node cube, 0 .. 65535
+	uint8_t starClass;
+	uint8_t flags;
+};
+
+static_assert(sizeof(QuantizedStar) == 8, "QuantizedStar is uploaded to the GPU as is");
+
+struct OctreeNode {
+	double center[3];
+	double halfSize;
+	uint64_t pageOffset;
+	uint64_t subtreeCount;	// systems in this node and below
+	uint32_t pointCount;	// systems stored in this node's page
+	uint32_t firstChild;	// index of the first child, existing children are stored contiguously
+	uint8_t childMask;		// bit i set = octant i exists
+	uint8_t depth;
+	uint8_t reserved[6];
+};
+
+static_assert(sizeof(OctreeNode) == 64, "OctreeNode is written to disk as is");
+
+struct OctreeHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t nodeCount;
+	uint64_t nodeTableOffset;
+	uint64_t systemCount;
+};
+
+const char OCTREE_MAGIC[4] = { 'S', 'O', 'C', 'T' };
+const uint32_t OCTREE_VERSION = 1;
+const uint64_t OCTREE_PAGE_ALIGN = 4096;
+
+inline int octantOf(const glm::dvec3& p, const glm::dvec3& center)
+{
+	return (p.x >= center.x ? 1 : 0) | (p.y >= center.y ? 2 : 0) | (p.z >= center.z ? 4 : 0);
+}
+
+inline glm::dvec3 octantCenter(const glm::dvec3& center, double halfSize, int octant)
+{
+	double q = halfSize * 0.5;
+	return center + glm::dvec3((octant & 1) ? q : -q, (octant & 2) ? q : -q, (octant & 4) ? q : -q);
+}
+
+inline unsigned int childIndex(const OctreeNode& node, int octant)
+{
+	unsigned int below = node.childMask & ((1u << octant) - 1u);
+	unsigned int rank = 0;
+
+	for (; below; below &= below - 1)
+		rank++;
+
+	return node.firstChild + rank;
+}
+
+// Builds an octree file from a star snapshot. Subtrees larger than inMemoryLimit are partitioned
+// through temporary files, so the snapshot can be far larger than RAM.
+class OctreeBuilder
+{
+public:
+	uint32_t leafCapacity = 32768;
+	uint32_t representatives = 8192;
+	uint64_t inMemoryLimit = 4000000;
+	unsigned int maxDepth = 20;
+
+	bool Build(const std::string& snapshotPath, const std::string& octreePath)
+	{
+		std::ifstream in(snapshotPath, std::ios::in | std::ios::binary);
+		StarSnapshotHeader snapshot;
+
+		if (!in.read((char*)&snapshot, sizeof(snapshot)) || std::memcmp(snapshot.magic, STAR_SNAPSHOT_MAGIC, 4) != 0)
+		{
+			std::cout << "ERROR::OCTREE:: " << snapshotPath << " is not a star snapshot" << std::endl;
+			return false;
+		}
+
+		// bounds: one streaming pass over the records
+		glm::dvec3 lo(1e30), hi(-1e30);
+		std::vector<StarRecord> block(65536);
+		uint64_t left = snapshot.count;
+
+		while (left > 0)
+		{
+			size_t n = (size_t)std::min<uint64_t>(left, block.size());
+			in.read((char*)block.data(), n * sizeof(StarRecord));
+
+			for (size_t i = 0; i < n; i++)
+			{
+				glm::dvec3 p(block[i].x, block[i].y, block[i].z);
+				lo = glm::min(lo, p);
+				hi = glm::max(hi, p);
+			}
+
+			left -= n;
+		}
+
+		if (snapshot.count == 0)
+			lo = hi = glm::dvec3(0.0);
+
+		glm::dvec3 center = (lo + hi) * 0.5;
+		double halfSize = std::max(std::max(hi.x - lo.x, hi.y - lo.y), hi.z - lo.z) * 0.5 + 1.0;
+
+		out.open(octreePath, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!out.is_open())
+		{
+			std::cout << "ERROR::OCTREE:: Could not open " << octreePath << " for writing" << std::endl;
+			return false;
+		}
+
+		OctreeHeader header = {};
+		std::memcpy(header.magic, OCTREE_MAGIC, 4);
+		header.version = OCTREE_VERSION;
+		out.write((const char*)&header, sizeof(header));
+
+		tempPath = octreePath + ".tmp";
+		tempCounter = 0;
+		nodes.clear();
+		nodes.push_back(OctreeNode());
+
+		in.clear();
+		in.seekg(sizeof(StarSnapshotHeader));
+
+		if (snapshot.count <= inMemoryLimit)
+		{
+			std::vector<StarRecord> records(snapshot.count);
+			in.read((char*)records.data(), snapshot.count * sizeof(StarRecord));
+			buildInMemory(0, records, center, halfSize, 0);
+		}
+		else
+		{
+			buildFromStream(0, in, snapshot.count, center, halfSize, 0);
+		}
+
+		alignPage();
+		header.nodeCount = nodes.size();
+		header.nodeTableOffset = (uint64_t)out.tellp();
+		header.systemCount = snapshot.count;
+		out.write((const char*)nodes.data(), nodes.size() * sizeof(OctreeNode));
+		out.seekp(0);
+		out.write((const char*)&header, sizeof(header));
+		out.close();
+
+		std::cout << "Octree: " << snapshot.count << " systems in " << nodes.size() << " nodes" << std::endl;
+
+		return true;
+	}
+
+private:
+	std::ofstream out;
+	std::vector<OctreeNode> nodes;
+	std::string tempPath;
+	unsigned int tempCounter;
+
+	void alignPage()
+	{
+		uint64_t pos = (uint64_t)out.tellp();
+		uint64_t pad = (OCTREE_PAGE_ALIGN - pos % OCTREE_PAGE_ALIGN) % OCTREE_PAGE_ALIGN;
+		static const char zeros[OCTREE_PAGE_ALIGN] = {};
+		out.write(zeros, pad);
+	}
+
+	void writePage(OctreeNode& node, const StarRecord* records, size_t count)
+	{
+		alignPage();
+		node.pageOffset = (uint64_t)out.tellp();
+		node.pointCount = (uint32_t)count;
+
+		glm::dvec3 lo = glm::dvec3(node.center[0], node.center[1], node.center[2]) - node.halfSize;
+		double scale = 65535.0 / (node.halfSize * 2.0);
+
+		std::vector<QuantizedStar> page(count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			page[i].x = (uint16_t)glm::clamp((records[i].x - lo.x) * scale + 0.5, 0.0, 65535.0);
+			page[i].y = (uint16_t)glm::clamp((records[i].y - lo.y) * scale + 0.5, 0.0, 65535.0);
+			page[i].z = (uint16_t)glm::clamp((records[i].z - lo.z) * scale + 0.5, 0.0, 65535.0);
+			page[i].starClass = records[i].starClass;
+			page[i].flags = records[i].flags;
+		}
+
+		out.write((const char*)page.data(), count * sizeof(QuantizedStar));
+	}
+
+	void initNode(unsigned int index, const glm::dvec3& center, double halfSize, unsigned int depth, uint64_t count)
+	{
+		OctreeNode& node = nodes[index];
+		node = OctreeNode();
+		node.center[0] = center.x;
+		node.center[1] = center.y;
+		node.center[2] = center.z;
+		node.halfSize = halfSize;
+		node.depth = (uint8_t)depth;
+		node.subtreeCount = count;
+	}
+
+	// allocates contiguous slots for the non-empty octants
+	void allocateChildren(unsigned int index, const uint64_t counts[8])
+	{
+		unsigned int first = (unsigned int)nodes.size();
+		uint8_t mask = 0;
+
+		for (int o = 0; o < 8; o++)
+		{
+			if (counts[o] > 0)
+			{
+				mask |= (uint8_t)(1 << o);
+				nodes.push_back(OctreeNode());
+			}
+		}
+
+		nodes[index].firstChild = first;
+		nodes[index].childMask = mask;
+	}
+
+	void buildInMemory(unsigned int index, std::vector<StarRecord>& records, const glm::dvec3& center, double halfSize, unsigned int depth)
+	{
+		initNode(index, center, halfSize, depth, records.size());
+
+		if (records.size() <= leafCapacity || depth >= maxDepth)
+		{
+			writePage(nodes[index], records.data(), records.size());
+			return;
+		}
+
+		// evenly strided sample as representatives
+		std::vector<StarRecord> sample;
+		sample.reserve(representatives);
+		double stride = (double)records.size() / representatives;
+		for (uint32_t i = 0; i < representatives; i++)
+			sample.push_back(records[(size_t)(i * stride)]);
+		writePage(nodes[index], sample.data(), sample.size());
+
+		std::vector<StarRecord> parts[8];
+		uint64_t counts[8] = {};
+
+		for (const StarRecord& r : records)
+			counts[octantOf(glm::dvec3(r.x, r.y, r.z), center)]++;
+		for (int o = 0; o < 8; o++)
+			parts[o].reserve(counts[o]);
+		for (const StarRecord& r : records)
+			parts[octantOf(glm::dvec3(r.x, r.y, r.z), center)].push_back(r);
+
+		records.clear();
+		records.shrink_to_fit();
+
+		allocateChildren(index, counts);
+
+		for (int o = 0; o < 8; o++)
+		{
+			if (counts[o] == 0)
+				continue;
+
+			buildInMemory(childIndex(nodes[index], o), parts[o], octantCenter(center, halfSize, o), halfSize * 0.5, depth + 1);
+			parts[o].clear();
+			parts[o].shrink_to_fit();
+		}
+	}
+
+	void buildFromStream(unsigned int index, std::istream& in, uint64_t count, const glm::dvec3& center, double halfSize, unsigned int depth)
+	{
+		if (count <= inMemoryLimit || depth >= maxDepth)
+		{
+			std::vector<StarRecord> records(count);
+			in.read((char*)records.data(), count * sizeof(StarRecord));
+			buildInMemory(index, records, center, halfSize, depth);
+			return;
+		}
+
+		initNode(index, center, halfSize, depth, count);
+
+		// split into eight temporary files, reservoir-sampling representatives on the way
+		std::string names[8];
+		std::ofstream parts[8];
+		uint64_t counts[8] = {};
+
+		for (int o = 0; o < 8; o++)
+		{
+			names[o] = tempPath + std::to_string(tempCounter++);
+			parts[o].open(names[o], std::ios::out | std::ios::binary | std::ios::trunc);
+		}
+
+		std::vector<StarRecord> sample;
+		sample.reserve(representatives);
+		std::mt19937_64 random(index);
+		std::vector<StarRecord> block(65536);
+		uint64_t seen = 0;
+		uint64_t left = count;
+
+		while (left > 0)
+		{
+			size_t n = (size_t)std::min<uint64_t>(left, block.size());
+			in.read((char*)block.data(), n * sizeof(StarRecord));
+
+			for (size_t i = 0; i < n; i++)
+			{
+				const StarRecord& r = block[i];
+				int o = octantOf(glm::dvec3(r.x, r.y, r.z), center);
+				parts[o].write((const char*)&r, sizeof(r));
+				counts[o]++;
+
+				if (sample.size() < representatives)
+					sample.push_back(r);
+				else
+				{
+					uint64_t j = random() % (seen + 1);
+					if (j < representatives)
+						sample[(size_t)j] = r;
+				}
+
+				seen++;
+			}
+
+			left -= n;
+		}
+
+		writePage(nodes[index], sample.data(), sample.size());
+
+		for (int o = 0; o < 8; o++)
+			parts[o].close();
+
+		allocateChildren(index, counts);
+
+		for (int o = 0; o < 8; o++)
+		{
+			if (counts[o] > 0)
+			{
+				std::ifstream part(names[o], std::ios::in | std::ios::binary);
+				buildFromStream(childIndex(nodes[index], o), part, counts[o], octantCenter(center, halfSize, o), halfSize * 0.5, depth + 1);
+			}
+
+			std::remove(names[o].c_str());
+		}
+	}
+};
+
+// Read-only memory mapping of a whole file.
+class MappedFile
+{
+public:
+	~MappedFile()
+	{
+		Close();
+	}
+
+	bool Open(const std::string& path)
+	{
+#ifdef _WIN32
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER fileSize;
+		GetFileSizeEx(file, &fileSize);
+		size = (uint64_t)fileSize.QuadPart;
+
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (!mapping)
+			return false;
+
+		data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+		fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		struct stat st;
+		fstat(fd, &st);
+		size = (uint64_t)st.st_size;
+
+		void* p = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+		data = (p == MAP_FAILED) ? NULL : (const uint8_t*)p;
+#endif
+		return data != NULL;
+	}
+
+	void Close()
+	{
+#ifdef _WIN32
+		if (data)
+			UnmapViewOfFile(data);
+		if (mapping)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+		mapping = NULL;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if (data)
+			munmap((void*)data, size);
+		if (fd >= 0)
+			close(fd);
+		fd = -1;
+#endif
+		data = NULL;
+		size = 0;
+	}
+
+	const uint8_t* data = NULL;
+	uint64_t size = 0;
+
+private:
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = NULL;
+#else
+	int fd = -1;
+#endif
+};
+
+class GalaxyOctree
+{
+public:
+	bool Open(const std::string& path)
+	{
+		if (!file.Open(path) || file.size < sizeof(OctreeHeader))
+		{
+			std::cout << "ERROR::OCTREE:: Could not map " << path << std::endl;
+			return false;
+		}
+
+		std::memcpy(&header, file.data, sizeof(header));
+
+		if (std::memcmp(header.magic, OCTREE_MAGIC, 4) != 0 || header.version != OCTREE_VERSION
+			|| header.nodeTableOffset + header.nodeCount * sizeof(OctreeNode) > file.size)
+		{
+			std::cout << "ERROR::OCTREE:: " << path << " is not a valid octree" << std::endl;
+			file.Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	size_t GetNodeCount() const { return (size_t)header.nodeCount; }
+	uint64_t GetSystemCount() const { return header.systemCount; }
+
+	const OctreeNode& GetNode(unsigned int index) const
+	{
+		return ((const OctreeNode*)(file.data + header.nodeTableOffset))[index];
+	}
+
+	const QuantizedStar* GetPage(const OctreeNode& node) const
+	{
+		return (const QuantizedStar*)(file.data + node.pageOffset);
+	}
+
+	size_t GetPageBytes(const OctreeNode& node) const
+	{
+		return node.pointCount * sizeof(QuantizedStar);
+	}
+
+	// rough projected size: node radius over distance, refine while above the threshold
+	static double ProjectedSize(const OctreeNode& node, const glm::dvec3& eye)
+	{
+		glm::dvec3 center(node.center[0], node.center[1], node.center[2]);
+		double distance = std::max(glm::length(center - eye) - node.halfSize * 1.7320508, node.halfSize * 0.01);
+
+		return node.halfSize / distance;
+	}
+
+private:
+	MappedFile file;
+	OctreeHeader header = {};
+};
+
+// Keeps the nodes around the camera resident within a fixed budget. A background thread picks
+// the wanted node set and reads their pages out of the mapping; the render thread uploads and
+// frees GPU buffers in ProcessUploads() and draws the current cut with Draw().
+class OctreeStreamer
+{
+public:
+	size_t budgetBytes;
+	double refineThreshold = 0.5;
+	unsigned int uploadsPerFrame = 16;
+
+	OctreeStreamer(GalaxyOctree& octree, size_t budgetBytes) : budgetBytes(budgetBytes), octree(octree), running(true), hasCamera(false)
+	{
+		worker = std::thread([this]() { run(); });
+	}
+
+	~OctreeStreamer()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			running = false;
+		}
+		wake.notify_all();
+		worker.join();
+
+		for (auto& it : gpuTiles)
+		{
+			glDeleteVertexArrays(1, &it.second.VAO);
+			glDeleteBuffers(1, &it.second.VBO);
+		}
+	}
+
+	// camera position in light years
+	void Update(const glm::dvec3& eye)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			cameraPosition = eye;
+			hasCamera = true;
+		}
+		wake.notify_one();
+	}
+
+	// render thread only
+	void ProcessUploads()
+	{
+		for (unsigned int i = 0; i < uploadsPerFrame; i++)
+		{
+			TileEvent e;
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (events.empty())
+					break;
+				e = std::move(events.front());
+				events.pop_front();
+			}
+
+			if (e.evict)
+			{
+				auto it = gpuTiles.find(e.node);
+				if (it != gpuTiles.end())
+				{
+					glDeleteVertexArrays(1, &it->second.VAO);
+					glDeleteBuffers(1, &it->second.VBO);
+					gpuBytes -= it->second.bytes;
+					gpuTiles.erase(it);
+				}
+				continue;
+			}
+
+			GpuTile tile;
+			tile.count = (unsigned int)(e.data.size() / sizeof(QuantizedStar));
+			tile.bytes = e.data.size();
+
+			glGenVertexArrays(1, &tile.VAO);
+			glGenBuffers(1, &tile.VBO);
+			glBindVertexArray(tile.VAO);
+			glBindBuffer(GL_ARRAY_BUFFER, tile.VBO);
+			glBufferData(GL_ARRAY_BUFFER, e.data.size(), e.data.data(), GL_STATIC_DRAW);
+
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(QuantizedStar), (void*)0);
+			glEnableVertexAttribArray(1);
+			glVertexAttribIPointer(1, 1, GL_UNSIGNED_BYTE, sizeof(QuantizedStar), (void*)offsetof(QuantizedStar, starClass));
+
+			glBindVertexArray(0);
+
+			gpuTiles[e.node] = tile;
+			gpuBytes += tile.bytes;
+		}
+	}
+
+	// eye in light years, scale in render units per light year
+	void Draw(Shader& shader, const glm::dvec3& eye, double scale)
+	{
+		if (gpuTiles.find(0) == gpuTiles.end())
+			return;
+
+		shader.use();
+		glState.Enable(GL_PROGRAM_POINT_SIZE);
+		drawNode(shader, 0, eye, scale);
+		glState.Disable(GL_PROGRAM_POINT_SIZE);
+	}
+
+	size_t GetGpuBytes() const { return gpuBytes; }
+	size_t GetResidentCount() const { return gpuTiles.size(); }
+
+private:
+	struct TileEvent
+	{
+		unsigned int node = 0;
+		bool evict = false;
+		std::vector<uint8_t> data;
+	};
+
+	struct GpuTile
+	{
+		unsigned int VAO = 0;
+		unsigned int VBO = 0;
+		unsigned int count = 0;
+		size_t bytes = 0;
+	};
+
+	GalaxyOctree& octree;
+	std::thread worker;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool running;
+	bool hasCamera;
+	glm::dvec3 cameraPosition;
+	std::deque<TileEvent> events;
+
+	// worker thread state
+	std::unordered_set<unsigned int> resident;
+
+	// render thread state
+	std::unordered_map<unsigned int, GpuTile> gpuTiles;
+	size_t gpuBytes = 0;
+
+	void drawNode(Shader& shader, unsigned int index, const glm::dvec3& eye, double scale)
+	{
+		const OctreeNode& node = octree.GetNode(index);
+		const GpuTile& tile = gpuTiles.at(index);
+
+		bool refine = node.childMask != 0 && GalaxyOctree::ProjectedSize(node, eye) > refineThreshold;
+
+		// children replace the representatives only once all of them are on the GPU
+		if (refine)
+		{
+			for (int o = 0; o < 8; o++)
+				if ((node.childMask & (1 << o)) && gpuTiles.find(childIndex(node, o)) == gpuTiles.end())
+					refine = false;
+		}
+
+		if (refine)
+		{
+			for (int o = 0; o < 8; o++)
+				if (node.childMask & (1 << o))
+					drawNode(shader, childIndex(node, o), eye, scale);
+			return;
+		}
+
+		glm::dvec3 lo = glm::dvec3(node.center[0], node.center[1], node.center[2]) - node.halfSize;
+		shader.setVec3("tileOrigin", glm::vec3((lo - eye) * scale));
+		shader.setFloat("tileSize", (float)(node.halfSize * 2.0 * scale));
+
+		glState.BindVertexArray(tile.VAO);
+		glDrawArrays(GL_POINTS, 0, tile.count);
+	}
+
+	void run()
+	{
+		while (true)
+		{
+			glm::dvec3 eye;
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait_for(lock, std::chrono::milliseconds(100), [&] { return !running || hasCamera; });
+
+				if (!running)
+					return;
+				if (!hasCamera)
+					continue;
+
+				eye = cameraPosition;
+				hasCamera = false;
+			}
+
+			std::vector<unsigned int> wanted = selectNodes(eye);
+			std::unordered_set<unsigned int> wantedSet(wanted.begin(), wanted.end());
+
+			std::vector<TileEvent> batch;
+
+			for (auto it = resident.begin(); it != resident.end();)
+			{
+				if (wantedSet.count(*it) == 0)
+				{
+					TileEvent e;
+					e.node = *it;
+					e.evict = true;
+					batch.push_back(std::move(e));
+					it = resident.erase(it);
+				}
+				else
+					++it;
+			}
+
+			// wanted is in priority order, so parents arrive before their children
+			for (unsigned int index : wanted)
+			{
+				if (resident.count(index))
+					continue;
+
+				const OctreeNode& node = octree.GetNode(index);
+				const uint8_t* page = (const uint8_t*)octree.GetPage(node);
+
+				TileEvent e;
+				e.node = index;
+				e.data.assign(page, page + octree.GetPageBytes(node));
+				batch.push_back(std::move(e));
+				resident.insert(index);
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			for (TileEvent& e : batch)
+				events.push_back(std::move(e));
+		}
+	}
+
+	// best-first descent: nodes with the largest projected size win until the budget is spent
+	std::vector<unsigned int> selectNodes(const glm::dvec3& eye)
+	{
+		std::vector<unsigned int> selected;
+
+		if (octree.GetNodeCount() == 0)
+			return selected;
+
+		typedef std::pair<double, unsigned int> Entry;
+		std::priority_queue<Entry> open;
+		open.push(Entry(GalaxyOctree::ProjectedSize(octree.GetNode(0), eye), 0));
+
+		size_t used = 0;
+
+		while (!open.empty())
+		{
+			Entry e = open.top();
+			open.pop();
+
+			const OctreeNode& node = octree.GetNode(e.second);
+			size_t bytes = octree.GetPageBytes(node);
+
+			if (used + bytes > budgetBytes)
+				break;
+
+			used += bytes;
+			selected.push_back(e.second);
+
+			if (node.childMask == 0 || e.first <= refineThreshold)
+				continue;
+
+			for (int o = 0; o < 8; o++)
+			{
+				if (node.childMask & (1 << o))
+				{
+					unsigned int child = childIndex(node, o);
+					open.push(Entry(GalaxyOctree::ProjectedSize(octree.GetNode(child), eye), child));
+				}
+			}
+		}
+
+		return selected;
+	}
+};
+
+#endif
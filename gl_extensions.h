@@ -0,0 +1,335 @@
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+// glad.c was generated for plain GL 3.3 core. Everything newer is declared here the way glad
+// would declare it and loaded by loadGLExtensions() right after gladLoadGLLoader(). Each block
+// is skipped if glad is ever regenerated with the extension included. Callers check the
+// GLAD_GL_* flag and keep a 3.3 path around.
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+inline bool hasGLExtension(const char* name)
+{
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+	for (GLint i = 0; i < count; i++)
+	{
+		const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+
+		if (ext && std::strcmp(ext, name) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+inline bool hasGLVersion(int major, int minor)
+{
+	return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+// GL_OVR_multiview / GL_OVR_multiview2
+#ifndef GL_OVR_multiview2
+#define GL_OVR_multiview2 1
+#define GL_FRAMEBUFFER_ATTACHMENT_TEXTURE_NUM_VIEWS_OVR 0x9630
+#define GL_FRAMEBUFFER_ATTACHMENT_TEXTURE_BASE_VIEW_INDEX_OVR 0x9632
+#define GL_MAX_VIEWS_OVR 0x9631
+#define GL_FRAMEBUFFER_INCOMPLETE_VIEW_TARGETS_OVR 0x9633
+typedef void (APIENTRYP PFNGLFRAMEBUFFERTEXTUREMULTIVIEWOVRPROC)(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint baseViewIndex, GLsizei numViews);
+inline int GLAD_GL_OVR_multiview2 = 0;
+inline PFNGLFRAMEBUFFERTEXTUREMULTIVIEWOVRPROC glad_glFramebufferTextureMultiviewOVR = NULL;
+#define glFramebufferTextureMultiviewOVR glad_glFramebufferTextureMultiviewOVR
+#endif
+
+// GL_ARB_clip_control (core in 4.5)
+#ifndef GL_ARB_clip_control
+#define GL_ARB_clip_control 1
+#define GL_CLIP_ORIGIN 0x935C
+#define GL_CLIP_DEPTH_MODE 0x935D
+#define GL_NEGATIVE_ONE_TO_ONE 0x935E
+#define GL_ZERO_TO_ONE 0x935F
+typedef void (APIENTRYP PFNGLCLIPCONTROLPROC)(GLenum origin, GLenum depth);
+inline int GLAD_GL_ARB_clip_control = 0;
+inline PFNGLCLIPCONTROLPROC glad_glClipControl = NULL;
+#define glClipControl glad_glClipControl
+#endif
+
+// GL_ARB_compute_shader (core in 4.3)
+#ifndef GL_ARB_compute_shader
+#define GL_ARB_compute_shader 1
+#define GL_COMPUTE_SHADER 0x91B9
+#define GL_MAX_COMPUTE_WORK_GROUP_COUNT 0x91BE
+#define GL_MAX_COMPUTE_WORK_GROUP_SIZE 0x91BF
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+inline int GLAD_GL_ARB_compute_shader = 0;
+inline PFNGLDISPATCHCOMPUTEPROC glad_glDispatchCompute = NULL;
+#define glDispatchCompute glad_glDispatchCompute
+#endif
+
+// GL_ARB_shader_storage_buffer_object (core in 4.3)
+#ifndef GL_ARB_shader_storage_buffer_object
+#define GL_ARB_shader_storage_buffer_object 1
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+inline int GLAD_GL_ARB_shader_storage_buffer_object = 0;
+#endif
+
+// GL_ARB_shader_image_load_store (core in 4.2), only glMemoryBarrier is used
+#ifndef GL_ARB_shader_image_load_store
+#define GL_ARB_shader_image_load_store 1
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#define GL_ELEMENT_ARRAY_BARRIER_BIT 0x00000002
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#define GL_ALL_BARRIER_BITS 0xFFFFFFFF
+typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+inline int GLAD_GL_ARB_shader_image_load_store = 0;
+inline PFNGLMEMORYBARRIERPROC glad_glMemoryBarrier = NULL;
+#define glMemoryBarrier glad_glMemoryBarrier
+#endif
+
+// GL_ARB_draw_indirect (core in 4.0)
+#ifndef GL_ARB_draw_indirect
+#define GL_ARB_draw_indirect 1
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#define GL_DRAW_INDIRECT_BUFFER_BINDING 0x8F43
+inline int GLAD_GL_ARB_draw_indirect = 0;
+#endif
+
+// GL_ARB_base_instance (core in 4.2), needed for baseInstance in indirect commands
+#ifndef GL_ARB_base_instance
+#define GL_ARB_base_instance 1
+inline int GLAD_GL_ARB_base_instance = 0;
+#endif
+
+// GL_ARB_multi_draw_indirect (core in 4.3)
+#ifndef GL_ARB_multi_draw_indirect
+#define GL_ARB_multi_draw_indirect 1
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+inline int GLAD_GL_ARB_multi_draw_indirect = 0;
+inline PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect = NULL;
+#define glMultiDrawElementsIndirect glad_glMultiDrawElementsIndirect
+#endif
+
+// GL_ARB_get_program_binary (core in 4.1)
+#ifndef GL_ARB_get_program_binary
+#define GL_ARB_get_program_binary 1
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_PROGRAM_BINARY_FORMATS 0x87FF
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+inline int GLAD_GL_ARB_get_program_binary = 0;
+inline PFNGLGETPROGRAMBINARYPROC glad_glGetProgramBinary = NULL;
+inline PFNGLPROGRAMBINARYPROC glad_glProgramBinary = NULL;
+inline PFNGLPROGRAMPARAMETERIPROC glad_glProgramParameteri = NULL;
+#define glGetProgramBinary glad_glGetProgramBinary
+#define glProgramBinary glad_glProgramBinary
+#define glProgramParameteri glad_glProgramParameteri
+#endif
+
+// GL_KHR_parallel_shader_compile
+#ifndef GL_KHR_parallel_shader_compile
+#define GL_KHR_parallel_shader_compile 1
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+inline int GLAD_GL_KHR_parallel_shader_compile = 0;
+inline PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glad_glMaxShaderCompilerThreadsKHR = NULL;
+#define glMaxShaderCompilerThreadsKHR glad_glMaxShaderCompilerThreadsKHR
+#endif
+
+// GL_ARB_buffer_storage (core in 4.4)
+#ifndef GL_ARB_buffer_storage
+#define GL_ARB_buffer_storage 1
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#define GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT 0x00004000
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+inline int GLAD_GL_ARB_buffer_storage = 0;
+inline PFNGLBUFFERSTORAGEPROC glad_glBufferStorage = NULL;
+#define glBufferStorage glad_glBufferStorage
+#endif
+
+// GL_ARB_direct_state_access (core in 4.5), the subset the 4.5 resource path uses
+#ifndef GL_ARB_direct_state_access
+#define GL_ARB_direct_state_access 1
+typedef void (APIENTRYP PFNGLCREATEBUFFERSPROC)(GLsizei n, GLuint* buffers);
+typedef void (APIENTRYP PFNGLNAMEDBUFFERSTORAGEPROC)(GLuint buffer, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void (APIENTRYP PFNGLNAMEDBUFFERSUBDATAPROC)(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data);
+typedef void* (APIENTRYP PFNGLMAPNAMEDBUFFERRANGEPROC)(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef void (APIENTRYP PFNGLFLUSHMAPPEDNAMEDBUFFERRANGEPROC)(GLuint buffer, GLintptr offset, GLsizeiptr length);
+typedef GLboolean (APIENTRYP PFNGLUNMAPNAMEDBUFFERPROC)(GLuint buffer);
+typedef void (APIENTRYP PFNGLCREATEVERTEXARRAYSPROC)(GLsizei n, GLuint* arrays);
+typedef void (APIENTRYP PFNGLVERTEXARRAYVERTEXBUFFERPROC)(GLuint vaobj, GLuint bindingindex, GLuint buffer, GLintptr offset, GLsizei stride);
+typedef void (APIENTRYP PFNGLVERTEXARRAYELEMENTBUFFERPROC)(GLuint vaobj, GLuint buffer);
+typedef void (APIENTRYP PFNGLENABLEVERTEXARRAYATTRIBPROC)(GLuint vaobj, GLuint index);
+typedef void (APIENTRYP PFNGLVERTEXARRAYATTRIBFORMATPROC)(GLuint vaobj, GLuint attribindex, GLint size, GLenum type, GLboolean normalized, GLuint relativeoffset);
+typedef void (APIENTRYP PFNGLVERTEXARRAYATTRIBIFORMATPROC)(GLuint vaobj, GLuint attribindex, GLint size, GLenum type, GLuint relativeoffset);
+typedef void (APIENTRYP PFNGLVERTEXARRAYATTRIBBINDINGPROC)(GLuint vaobj, GLuint attribindex, GLuint bindingindex);
+typedef void (APIENTRYP PFNGLVERTEXARRAYBINDINGDIVISORPROC)(GLuint vaobj, GLuint bindingindex, GLuint divisor);
+typedef void (APIENTRYP PFNGLCREATETEXTURESPROC)(GLenum target, GLsizei n, GLuint* textures);
+typedef void (APIENTRYP PFNGLTEXTURESTORAGE2DPROC)(GLuint texture, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void (APIENTRYP PFNGLTEXTURESTORAGE3DPROC)(GLuint texture, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth);
+typedef void (APIENTRYP PFNGLTEXTURESUBIMAGE2DPROC)(GLuint texture, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels);
+typedef void (APIENTRYP PFNGLTEXTURESUBIMAGE3DPROC)(GLuint texture, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels);
+typedef void (APIENTRYP PFNGLTEXTUREPARAMETERIPROC)(GLuint texture, GLenum pname, GLint param);
+typedef void (APIENTRYP PFNGLGENERATETEXTUREMIPMAPPROC)(GLuint texture);
+typedef void (APIENTRYP PFNGLBINDTEXTUREUNITPROC)(GLuint unit, GLuint texture);
+typedef void (APIENTRYP PFNGLCREATEFRAMEBUFFERSPROC)(GLsizei n, GLuint* framebuffers);
+typedef void (APIENTRYP PFNGLNAMEDFRAMEBUFFERTEXTUREPROC)(GLuint framebuffer, GLenum attachment, GLuint texture, GLint level);
+typedef void (APIENTRYP PFNGLNAMEDFRAMEBUFFERRENDERBUFFERPROC)(GLuint framebuffer, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer);
+typedef void (APIENTRYP PFNGLNAMEDFRAMEBUFFERDRAWBUFFERPROC)(GLuint framebuffer, GLenum buf);
+typedef void (APIENTRYP PFNGLNAMEDFRAMEBUFFERREADBUFFERPROC)(GLuint framebuffer, GLenum src);
+typedef GLenum (APIENTRYP PFNGLCHECKNAMEDFRAMEBUFFERSTATUSPROC)(GLuint framebuffer, GLenum target);
+typedef void (APIENTRYP PFNGLCREATERENDERBUFFERSPROC)(GLsizei n, GLuint* renderbuffers);
+typedef void (APIENTRYP PFNGLNAMEDRENDERBUFFERSTORAGEPROC)(GLuint renderbuffer, GLenum internalformat, GLsizei width, GLsizei height);
+inline int GLAD_GL_ARB_direct_state_access = 0;
+inline PFNGLCREATEBUFFERSPROC glad_glCreateBuffers = NULL;
+inline PFNGLNAMEDBUFFERSTORAGEPROC glad_glNamedBufferStorage = NULL;
+inline PFNGLNAMEDBUFFERSUBDATAPROC glad_glNamedBufferSubData = NULL;
+inline PFNGLMAPNAMEDBUFFERRANGEPROC glad_glMapNamedBufferRange = NULL;
+inline PFNGLFLUSHMAPPEDNAMEDBUFFERRANGEPROC glad_glFlushMappedNamedBufferRange = NULL;
+inline PFNGLUNMAPNAMEDBUFFERPROC glad_glUnmapNamedBuffer = NULL;
+inline PFNGLCREATEVERTEXARRAYSPROC glad_glCreateVertexArrays = NULL;
+inline PFNGLVERTEXARRAYVERTEXBUFFERPROC glad_glVertexArrayVertexBuffer = NULL;
+inline PFNGLVERTEXARRAYELEMENTBUFFERPROC glad_glVertexArrayElementBuffer = NULL;
+inline PFNGLENABLEVERTEXARRAYATTRIBPROC glad_glEnableVertexArrayAttrib = NULL;
+inline PFNGLVERTEXARRAYATTRIBFORMATPROC glad_glVertexArrayAttribFormat = NULL;
+inline PFNGLVERTEXARRAYATTRIBIFORMATPROC glad_glVertexArrayAttribIFormat = NULL;
+inline PFNGLVERTEXARRAYATTRIBBINDINGPROC glad_glVertexArrayAttribBinding = NULL;
+inline PFNGLVERTEXARRAYBINDINGDIVISORPROC glad_glVertexArrayBindingDivisor = NULL;
+inline PFNGLCREATETEXTURESPROC glad_glCreateTextures = NULL;
+inline PFNGLTEXTURESTORAGE2DPROC glad_glTextureStorage2D = NULL;
+inline PFNGLTEXTURESTORAGE3DPROC glad_glTextureStorage3D = NULL;
+inline PFNGLTEXTURESUBIMAGE2DPROC glad_glTextureSubImage2D = NULL;
+inline PFNGLTEXTURESUBIMAGE3DPROC glad_glTextureSubImage3D = NULL;
+inline PFNGLTEXTUREPARAMETERIPROC glad_glTextureParameteri = NULL;
+inline PFNGLGENERATETEXTUREMIPMAPPROC glad_glGenerateTextureMipmap = NULL;
+inline PFNGLBINDTEXTUREUNITPROC glad_glBindTextureUnit = NULL;
+inline PFNGLCREATEFRAMEBUFFERSPROC glad_glCreateFramebuffers = NULL;
+inline PFNGLNAMEDFRAMEBUFFERTEXTUREPROC glad_glNamedFramebufferTexture = NULL;
+inline PFNGLNAMEDFRAMEBUFFERRENDERBUFFERPROC glad_glNamedFramebufferRenderbuffer = NULL;
+inline PFNGLNAMEDFRAMEBUFFERDRAWBUFFERPROC glad_glNamedFramebufferDrawBuffer = NULL;
+inline PFNGLNAMEDFRAMEBUFFERREADBUFFERPROC glad_glNamedFramebufferReadBuffer = NULL;
+inline PFNGLCHECKNAMEDFRAMEBUFFERSTATUSPROC glad_glCheckNamedFramebufferStatus = NULL;
+inline PFNGLCREATERENDERBUFFERSPROC glad_glCreateRenderbuffers = NULL;
+inline PFNGLNAMEDRENDERBUFFERSTORAGEPROC glad_glNamedRenderbufferStorage = NULL;
+#define glCreateBuffers glad_glCreateBuffers
+#define glNamedBufferStorage glad_glNamedBufferStorage
+#define glNamedBufferSubData glad_glNamedBufferSubData
+#define glMapNamedBufferRange glad_glMapNamedBufferRange
+#define glFlushMappedNamedBufferRange glad_glFlushMappedNamedBufferRange
+#define glUnmapNamedBuffer glad_glUnmapNamedBuffer
+#define glCreateVertexArrays glad_glCreateVertexArrays
+#define glVertexArrayVertexBuffer glad_glVertexArrayVertexBuffer
+#define glVertexArrayElementBuffer glad_glVertexArrayElementBuffer
+#define glEnableVertexArrayAttrib glad_glEnableVertexArrayAttrib
+#define glVertexArrayAttribFormat glad_glVertexArrayAttribFormat
+#define glVertexArrayAttribIFormat glad_glVertexArrayAttribIFormat
+#define glVertexArrayAttribBinding glad_glVertexArrayAttribBinding
+#define glVertexArrayBindingDivisor glad_glVertexArrayBindingDivisor
+#define glCreateTextures glad_glCreateTextures
+#define glTextureStorage2D glad_glTextureStorage2D
+#define glTextureStorage3D glad_glTextureStorage3D
+#define glTextureSubImage2D glad_glTextureSubImage2D
+#define glTextureSubImage3D glad_glTextureSubImage3D
+#define glTextureParameteri glad_glTextureParameteri
+#define glGenerateTextureMipmap glad_glGenerateTextureMipmap
+#define glBindTextureUnit glad_glBindTextureUnit
+#define glCreateFramebuffers glad_glCreateFramebuffers
+#define glNamedFramebufferTexture glad_glNamedFramebufferTexture
+#define glNamedFramebufferRenderbuffer glad_glNamedFramebufferRenderbuffer
+#define glNamedFramebufferDrawBuffer glad_glNamedFramebufferDrawBuffer
+#define glNamedFramebufferReadBuffer glad_glNamedFramebufferReadBuffer
+#define glCheckNamedFramebufferStatus glad_glCheckNamedFramebufferStatus
+#define glCreateRenderbuffers glad_glCreateRenderbuffers
+#define glNamedRenderbufferStorage glad_glNamedRenderbufferStorage
+#endif
+
+inline void loadGLExtensions(GLADloadproc load)
+{
+	GLAD_GL_OVR_multiview2 = hasGLExtension("GL_OVR_multiview2");
+	glad_glFramebufferTextureMultiviewOVR = (PFNGLFRAMEBUFFERTEXTUREMULTIVIEWOVRPROC)load("glFramebufferTextureMultiviewOVR");
+	GLAD_GL_OVR_multiview2 = GLAD_GL_OVR_multiview2 && glad_glFramebufferTextureMultiviewOVR != NULL;
+
+	GLAD_GL_ARB_clip_control = hasGLVersion(4, 5) || hasGLExtension("GL_ARB_clip_control");
+	glad_glClipControl = (PFNGLCLIPCONTROLPROC)load("glClipControl");
+	GLAD_GL_ARB_clip_control = GLAD_GL_ARB_clip_control && glad_glClipControl != NULL;
+
+	GLAD_GL_ARB_compute_shader = hasGLVersion(4, 3) || hasGLExtension("GL_ARB_compute_shader");
+	glad_glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)load("glDispatchCompute");
+	GLAD_GL_ARB_compute_shader = GLAD_GL_ARB_compute_shader && glad_glDispatchCompute != NULL;
+
+	GLAD_GL_ARB_shader_storage_buffer_object = hasGLVersion(4, 3) || hasGLExtension("GL_ARB_shader_storage_buffer_object");
+
+	GLAD_GL_ARB_shader_image_load_store = hasGLVersion(4, 2) || hasGLExtension("GL_ARB_shader_image_load_store");
+	glad_glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)load("glMemoryBarrier");
+	GLAD_GL_ARB_shader_image_load_store = GLAD_GL_ARB_shader_image_load_store && glad_glMemoryBarrier != NULL;
+
+	GLAD_GL_ARB_draw_indirect = hasGLVersion(4, 0) || hasGLExtension("GL_ARB_draw_indirect");
+	GLAD_GL_ARB_base_instance = hasGLVersion(4, 2) || hasGLExtension("GL_ARB_base_instance");
+
+	GLAD_GL_ARB_multi_draw_indirect = hasGLVersion(4, 3) || hasGLExtension("GL_ARB_multi_draw_indirect");
+	glad_glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)load("glMultiDrawElementsIndirect");
+	GLAD_GL_ARB_multi_draw_indirect = GLAD_GL_ARB_multi_draw_indirect && glad_glMultiDrawElementsIndirect != NULL;
+
+	GLAD_GL_ARB_get_program_binary = hasGLVersion(4, 1) || hasGLExtension("GL_ARB_get_program_binary");
+	glad_glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)load("glGetProgramBinary");
+	glad_glProgramBinary = (PFNGLPROGRAMBINARYPROC)load("glProgramBinary");
+	glad_glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+	GLAD_GL_ARB_get_program_binary = GLAD_GL_ARB_get_program_binary && glad_glGetProgramBinary != NULL && glad_glProgramBinary != NULL && glad_glProgramParameteri != NULL;
+
+	// the ARB version of the extension has the same enums and entry point signature
+	GLAD_GL_KHR_parallel_shader_compile = hasGLExtension("GL_KHR_parallel_shader_compile");
+	glad_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load(GLAD_GL_KHR_parallel_shader_compile ? "glMaxShaderCompilerThreadsKHR" : "glMaxShaderCompilerThreadsARB");
+	GLAD_GL_KHR_parallel_shader_compile = (GLAD_GL_KHR_parallel_shader_compile || hasGLExtension("GL_ARB_parallel_shader_compile")) && glad_glMaxShaderCompilerThreadsKHR != NULL;
+
+	GLAD_GL_ARB_buffer_storage = hasGLVersion(4, 4) || hasGLExtension("GL_ARB_buffer_storage");
+	glad_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)load("glBufferStorage");
+	GLAD_GL_ARB_buffer_storage = GLAD_GL_ARB_buffer_storage && glad_glBufferStorage != NULL;
+
+	GLAD_GL_ARB_direct_state_access = hasGLVersion(4, 5) || hasGLExtension("GL_ARB_direct_state_access");
+	glad_glCreateBuffers = (PFNGLCREATEBUFFERSPROC)load("glCreateBuffers");
+	glad_glNamedBufferStorage = (PFNGLNAMEDBUFFERSTORAGEPROC)load("glNamedBufferStorage");
+	glad_glNamedBufferSubData = (PFNGLNAMEDBUFFERSUBDATAPROC)load("glNamedBufferSubData");
+	glad_glMapNamedBufferRange = (PFNGLMAPNAMEDBUFFERRANGEPROC)load("glMapNamedBufferRange");
+	glad_glFlushMappedNamedBufferRange = (PFNGLFLUSHMAPPEDNAMEDBUFFERRANGEPROC)load("glFlushMappedNamedBufferRange");
+	glad_glUnmapNamedBuffer = (PFNGLUNMAPNAMEDBUFFERPROC)load("glUnmapNamedBuffer");
+	glad_glCreateVertexArrays = (PFNGLCREATEVERTEXARRAYSPROC)load("glCreateVertexArrays");
+	glad_glVertexArrayVertexBuffer = (PFNGLVERTEXARRAYVERTEXBUFFERPROC)load("glVertexArrayVertexBuffer");
+	glad_glVertexArrayElementBuffer = (PFNGLVERTEXARRAYELEMENTBUFFERPROC)load("glVertexArrayElementBuffer");
+	glad_glEnableVertexArrayAttrib = (PFNGLENABLEVERTEXARRAYATTRIBPROC)load("glEnableVertexArrayAttrib");
+	glad_glVertexArrayAttribFormat = (PFNGLVERTEXARRAYATTRIBFORMATPROC)load("glVertexArrayAttribFormat");
+	glad_glVertexArrayAttribIFormat = (PFNGLVERTEXARRAYATTRIBIFORMATPROC)load("glVertexArrayAttribIFormat");
+	glad_glVertexArrayAttribBinding = (PFNGLVERTEXARRAYATTRIBBINDINGPROC)load("glVertexArrayAttribBinding");
+	glad_glVertexArrayBindingDivisor = (PFNGLVERTEXARRAYBINDINGDIVISORPROC)load("glVertexArrayBindingDivisor");
+	glad_glCreateTextures = (PFNGLCREATETEXTURESPROC)load("glCreateTextures");
+	glad_glTextureStorage2D = (PFNGLTEXTURESTORAGE2DPROC)load("glTextureStorage2D");
+	glad_glTextureStorage3D = (PFNGLTEXTURESTORAGE3DPROC)load("glTextureStorage3D");
+	glad_glTextureSubImage2D = (PFNGLTEXTURESUBIMAGE2DPROC)load("glTextureSubImage2D");
+	glad_glTextureSubImage3D = (PFNGLTEXTURESUBIMAGE3DPROC)load("glTextureSubImage3D");
+	glad_glTextureParameteri = (PFNGLTEXTUREPARAMETERIPROC)load("glTextureParameteri");
+	glad_glGenerateTextureMipmap = (PFNGLGENERATETEXTUREMIPMAPPROC)load("glGenerateTextureMipmap");
+	glad_glBindTextureUnit = (PFNGLBINDTEXTUREUNITPROC)load("glBindTextureUnit");
+	glad_glCreateFramebuffers = (PFNGLCREATEFRAMEBUFFERSPROC)load("glCreateFramebuffers");
+	glad_glNamedFramebufferTexture = (PFNGLNAMEDFRAMEBUFFERTEXTUREPROC)load("glNamedFramebufferTexture");
+	glad_glNamedFramebufferRenderbuffer = (PFNGLNAMEDFRAMEBUFFERRENDERBUFFERPROC)load("glNamedFramebufferRenderbuffer");
+	glad_glNamedFramebufferDrawBuffer = (PFNGLNAMEDFRAMEBUFFERDRAWBUFFERPROC)load("glNamedFramebufferDrawBuffer");
+	glad_glNamedFramebufferReadBuffer = (PFNGLNAMEDFRAMEBUFFERREADBUFFERPROC)load("glNamedFramebufferReadBuffer");
+	glad_glCheckNamedFramebufferStatus = (PFNGLCHECKNAMEDFRAMEBUFFERSTATUSPROC)load("glCheckNamedFramebufferStatus");
+	glad_glCreateRenderbuffers = (PFNGLCREATERENDERBUFFERSPROC)load("glCreateRenderbuffers");
+	glad_glNamedRenderbufferStorage = (PFNGLNAMEDRENDERBUFFERSTORAGEPROC)load("glNamedRenderbufferStorage");
+	GLAD_GL_ARB_direct_state_access = GLAD_GL_ARB_direct_state_access && glad_glCreateBuffers != NULL && glad_glNamedBufferStorage != NULL
+		&& glad_glCreateVertexArrays != NULL && glad_glCreateTextures != NULL && glad_glTextureStorage2D != NULL && glad_glTextureStorage3D != NULL
+		&& glad_glCreateFramebuffers != NULL && glad_glNamedRenderbufferStorage != NULL;
+}
+
+#endif
@@ -0,0 +1,294 @@
+#ifndef GL_RESOURCES_H
+#define GL_RESOURCES_H
+
+#include <glad/glad.h>
+
+#include "gl_extensions.h"
+#include "gl_state.h"
+
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <cstddef>
+
+// Buffer, texture and vertex array creation for both context versions. With DSA and buffer
+// storage (4.5) objects are created and edited by name and get immutable storage, so the
+// driver validates their size and format once instead of on every use. Without them the
+// same calls fall back to the bind-to-edit 3.3 way. 3.3 paths bind through glState, so these
+// are safe to call in the middle of a frame.
+
+inline bool UseDirectStateAccess()
+{
+	return GLAD_GL_ARB_direct_state_access && GLAD_GL_ARB_buffer_storage;
+}
+
+// flags as for glBufferStorage: 0 for data that never changes, GL_DYNAMIC_STORAGE_BIT to allow
+// UpdateBuffer(). On 3.3 they only pick the usage hint. GL_COPY_WRITE_BUFFER is used to edit
+// because no VAO or draw state depends on it.
+inline GLuint CreateBuffer(GLsizeiptr size, const void* data, GLbitfield flags = 0)
+{
+	GLuint buffer = 0;
+
+	if (UseDirectStateAccess())
+	{
+		// zero-sized storage is an error
+		glCreateBuffers(1, &buffer);
+		glNamedBufferStorage(buffer, std::max(size, (GLsizeiptr)1), size > 0 ? data : NULL, flags);
+	}
+	else
+	{
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, size, data, (flags & GL_DYNAMIC_STORAGE_BIT) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+
+	return buffer;
+}
+
+inline void UpdateBuffer(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data)
+{
+	if (UseDirectStateAccess())
+	{
+		glNamedBufferSubData(buffer, offset, size, data);
+	}
+	else
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+}
+
+// GPU to GPU, nothing passes through the client. Grown buffers keep their old contents this way.
+inline void CopyBuffer(GLuint source, GLuint destination, GLsizeiptr size)
+{
+	glBindBuffer(GL_COPY_READ_BUFFER, source);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, destination);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+inline GLsizei MipLevelCount(GLsizei width, GLsizei height)
+{
+	GLsizei levels = 1;
+
+	while ((width | height) >> levels)
+		levels++;
+
+	return levels;
+}
+
+// levels 0 is the full mip chain. pixels, if given, become level 0 and the other levels are
+// generated from it. Filtering and wrapping are left to SetTextureParameter().
+inline GLuint CreateTexture2D(GLenum internalFormat, GLsizei width, GLsizei height, GLsizei levels, GLenum format, GLenum type, const void* pixels)
+{
+	if (levels == 0)
+		levels = MipLevelCount(width, height);
+
+	GLuint texture = 0;
+
+	if (UseDirectStateAccess())
+	{
+		glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+		glTextureStorage2D(texture, levels, internalFormat, width, height);
+
+		if (pixels)
+		{
+			glTextureSubImage2D(texture, 0, 0, 0, width, height, format, type, pixels);
+
+			if (levels > 1)
+				glGenerateTextureMipmap(texture);
+		}
+	}
+	else
+	{
+		glGenTextures(1, &texture);
+		glState.BindTexture(0, GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, pixels);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+		if (pixels && levels > 1)
+			glGenerateMipmap(GL_TEXTURE_2D);
+	}
+
+	return texture;
+}
+
+// layers are filled with UploadTextureLayer(), mipmaps with GenerateMipmaps() afterwards.
+// format/type only matter on 3.3, where the storage is specified with a NULL upload.
+inline GLuint CreateTexture2DArray(GLenum internalFormat, GLsizei width, GLsizei height, GLsizei layers, GLsizei levels, GLenum format, GLenum type)
+{
+	if (levels == 0)
+		levels = MipLevelCount(width, height);
+
+	GLuint texture = 0;
+
+	if (UseDirectStateAccess())
+	{
+		glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &texture);
+		glTextureStorage3D(texture, levels, internalFormat, width, height, layers);
+	}
+	else
+	{
+		glGenTextures(1, &texture);
+		glState.BindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, internalFormat, width, height, layers, 0, format, type, NULL);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	}
+
+	return texture;
+}
+
+inline void UploadTextureLayer(GLuint texture, GLint layer, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+	if (UseDirectStateAccess())
+	{
+		glTextureSubImage3D(texture, 0, 0, 0, layer, width, height, 1, format, type, pixels);
+	}
+	else
+	{
+		glState.BindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, format, type, pixels);
+	}
+}
+
+inline void GenerateMipmaps(GLenum target, GLuint texture)
+{
+	if (UseDirectStateAccess())
+	{
+		glGenerateTextureMipmap(texture);
+	}
+	else
+	{
+		glState.BindTexture(0, target, texture);
+		glGenerateMipmap(target);
+	}
+}
+
+inline void SetTextureParameter(GLenum target, GLuint texture, GLenum name, GLint value)
+{
+	if (UseDirectStateAccess())
+	{
+		glTextureParameteri(texture, name, value);
+	}
+	else
+	{
+		glState.BindTexture(0, target, texture);
+		glTexParameteri(target, name, value);
+	}
+}
+
+// Describes a VAO as buffer bindings plus attributes reading from them, the 4.5 model. On 3.3
+// each attribute is pointed at its binding's buffer with glVertexAttribPointer instead.
+//
+//	VertexArrayBuilder builder;
+//	builder.Buffer(0, VBO, sizeof(Vertex));
+//	builder.Indices(EBO);
+//	builder.Attribute(0, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Position));
+//	VAO = builder.Finish();
+class VertexArrayBuilder
+{
+public:
+	// vao 0 creates a new VAO, anything else adds to an existing one
+	VertexArrayBuilder(GLuint vao = 0) : VAO(vao), dsa(UseDirectStateAccess())
+	{
+		if (VAO == 0)
+		{
+			if (dsa)
+				glCreateVertexArrays(1, &VAO);
+			else
+				glGenVertexArrays(1, &VAO);
+		}
+
+		if (!dsa)
+			glState.BindVertexArray(VAO);
+
+		for (int i = 0; i < MAX_BINDINGS; i++)
+			bindings[i] = Binding();
+	}
+
+	// divisor 1 makes every attribute of the binding per instance
+	void Buffer(GLuint binding, GLuint buffer, GLsizei stride, GLuint divisor = 0)
+	{
+		bindings[binding].buffer = buffer;
+		bindings[binding].stride = stride;
+		bindings[binding].divisor = divisor;
+
+		if (dsa)
+		{
+			glVertexArrayVertexBuffer(VAO, binding, buffer, 0, stride);
+			glVertexArrayBindingDivisor(VAO, binding, divisor);
+		}
+	}
+
+	void Indices(GLuint buffer)
+	{
+		if (dsa)
+			glVertexArrayElementBuffer(VAO, buffer);
+		else
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+	}
+
+	void Attribute(GLuint index, GLuint binding, GLint size, GLenum type, GLboolean normalized, size_t offset)
+	{
+		if (dsa)
+		{
+			glEnableVertexArrayAttrib(VAO, index);
+			glVertexArrayAttribFormat(VAO, index, size, type, normalized, (GLuint)offset);
+			glVertexArrayAttribBinding(VAO, index, binding);
+		}
+		else
+		{
+			const Binding& b = bindings[binding];
+			glState.BindBuffer(GL_ARRAY_BUFFER, b.buffer);
+			glEnableVertexAttribArray(index);
+			glVertexAttribPointer(index, size, type, normalized, b.stride, (void*)offset);
+			glVertexAttribDivisor(index, b.divisor);
+		}
+	}
+
+	// integer inputs (uint, ivec), no conversion to float
+	void IntegerAttribute(GLuint index, GLuint binding, GLint size, GLenum type, size_t offset)
+	{
+		if (dsa)
+		{
+			glEnableVertexArrayAttrib(VAO, index);
+			glVertexArrayAttribIFormat(VAO, index, size, type, (GLuint)offset);
+			glVertexArrayAttribBinding(VAO, index, binding);
+		}
+		else
+		{
+			const Binding& b = bindings[binding];
+			glState.BindBuffer(GL_ARRAY_BUFFER, b.buffer);
+			glEnableVertexAttribArray(index);
+			glVertexAttribIPointer(index, size, type, b.stride, (void*)offset);
+			glVertexAttribDivisor(index, b.divisor);
+		}
+	}
+
+	GLuint Finish()
+	{
+		// nothing set up afterwards can end up in this VAO by accident
+		if (!dsa)
+			glState.BindVertexArray(0);
+
+		return VAO;
+	}
+
+private:
+	enum { MAX_BINDINGS = 4 };
+
+	struct Binding {
+		GLuint buffer = 0;
+		GLsizei stride = 0;
+		GLuint divisor = 0;
+	};
+
+	GLuint VAO;
+	bool dsa;
+	Binding bindings[MAX_BINDINGS];
+};
+
+#endif
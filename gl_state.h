@@ -0,0 +1,196 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+#include "gl_extensions.h"
+
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+const int GL_STATE_TEXTURE_UNITS = 16;
+
+struct GLStateStats {
+	unsigned int issued;	// calls that reached GL
+	unsigned int elided;	// calls dropped because the state was already set
+};
+
+// Shadow copy of the GL state the draw code touches: program, VAO, array and indirect buffer,
+// 2D / 2D array textures per unit, a few capabilities and sampler uniforms. A call that would
+// not change anything never reaches the driver.
+//
+// Everything that binds these during a frame has to go through glState. Setup code (mesh
+// uploads, texture loading, tile streaming) may still call GL directly as long as it runs
+// before BeginFrame() or is followed by Invalidate().
+class GLStateCache
+{
+public:
+	GLStateCache()
+	{
+		current = GLStateStats();
+		last = GLStateStats();
+		Invalidate();
+	}
+
+	// forget everything, the next call of each kind goes to GL again
+	void Invalidate()
+	{
+		program = UNKNOWN;
+		vertexArray = UNKNOWN;
+		arrayBuffer = UNKNOWN;
+		indirectBuffer = UNKNOWN;
+		activeUnit = UNKNOWN;
+
+		for (int i = 0; i < GL_STATE_TEXTURE_UNITS; i++)
+		{
+			textures2D[i] = UNKNOWN;
+			texturesArray[i] = UNKNOWN;
+		}
+
+		for (int i = 0; i < CAPABILITY_COUNT; i++)
+			capabilities[i] = -1;
+
+		uniforms.clear();
+	}
+
+	// keeps the counters of the frame that just ended, see GetFrameStats()
+	void BeginFrame()
+	{
+		last = current;
+		current = GLStateStats();
+		Invalidate();
+	}
+
+	void UseProgram(GLuint id)
+	{
+		if (!changed(program, id))
+			return;
+
+		glUseProgram(id);
+	}
+
+	void BindVertexArray(GLuint id)
+	{
+		if (!changed(vertexArray, id))
+			return;
+
+		glBindVertexArray(id);
+	}
+
+	// GL_ARRAY_BUFFER and GL_DRAW_INDIRECT_BUFFER are tracked, other targets go straight through
+	void BindBuffer(GLenum target, GLuint id)
+	{
+		if (target == GL_ARRAY_BUFFER && !changed(arrayBuffer, id))
+			return;
+		if (target == GL_DRAW_INDIRECT_BUFFER && !changed(indirectBuffer, id))
+			return;
+
+		glBindBuffer(target, id);
+	}
+
+	// GL_TEXTURE_2D and GL_TEXTURE_2D_ARRAY on units below GL_STATE_TEXTURE_UNITS are tracked
+	void BindTexture(unsigned int unit, GLenum target, GLuint id)
+	{
+		GLuint* slot = NULL;
+
+		if (unit < GL_STATE_TEXTURE_UNITS)
+			slot = target == GL_TEXTURE_2D ? &textures2D[unit] : target == GL_TEXTURE_2D_ARRAY ? &texturesArray[unit] : NULL;
+
+		if (slot && !changed(*slot, id))
+			return;
+
+		if (changed(activeUnit, unit))
+			glActiveTexture(GL_TEXTURE0 + unit);
+
+		glBindTexture(target, id);
+	}
+
+	void Enable(GLenum capability) { setCapability(capability, true); }
+	void Disable(GLenum capability) { setCapability(capability, false); }
+
+	// int uniforms (samplers) of the current program
+	void Uniform1i(GLuint programID, GLint location, int value)
+	{
+		uint64_t key = ((uint64_t)programID << 32) | (uint32_t)location;
+		auto it = uniforms.find(key);
+
+		if (it != uniforms.end() && it->second == value)
+		{
+			current.elided++;
+			return;
+		}
+
+		uniforms[key] = value;
+		current.issued++;
+		glUniform1i(location, value);
+	}
+
+	const GLStateStats& GetFrameStats() const { return last; }
+
+private:
+	enum { CAPABILITY_COUNT = 4 };
+	static const GLuint UNKNOWN = 0xFFFFFFFF;
+
+	GLuint program;
+	GLuint vertexArray;
+	GLuint arrayBuffer;
+	GLuint indirectBuffer;
+	GLuint activeUnit;
+	GLuint textures2D[GL_STATE_TEXTURE_UNITS];
+	GLuint texturesArray[GL_STATE_TEXTURE_UNITS];
+	int capabilities[CAPABILITY_COUNT];	// -1 unknown
+	std::unordered_map<uint64_t, int> uniforms;
+
+	GLStateStats current;
+	GLStateStats last;
+
+	// true and updated if value differs from the tracked state
+	bool changed(GLuint& tracked, GLuint value)
+	{
+		if (tracked == value)
+		{
+			current.elided++;
+			return false;
+		}
+
+		tracked = value;
+		current.issued++;
+		return true;
+	}
+
+	void setCapability(GLenum capability, bool enabled)
+	{
+		int slot = -1;
+
+		switch (capability)
+		{
+			case GL_DEPTH_TEST: slot = 0; break;
+			case GL_BLEND: slot = 1; break;
+			case GL_CULL_FACE: slot = 2; break;
+			case GL_PROGRAM_POINT_SIZE: slot = 3; break;
+		}
+
+		if (slot >= 0)
+		{
+			if (capabilities[slot] == (int)enabled)
+			{
+				current.elided++;
+				return;
+			}
+
+			capabilities[slot] = (int)enabled;
+			current.issued++;
+		}
+
+		if (enabled)
+			glEnable(capability);
+		else
+			glDisable(capability);
+	}
+};
+
+// the one context this program renders with
+inline GLStateCache glState;
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef GLYPH_FONT_H
+#define GLYPH_FONT_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Printable ASCII as a 5 x 7 pixel font, one byte per row from the top, bit 4 is the leftmost
+// column. Glyphs are drawn with one column and two rows of spacing around them.
+const int GLYPH_FONT_FIRST = 32;
+const int GLYPH_FONT_COUNT = 95;
+const int GLYPH_FONT_WIDTH = 5;
+const int GLYPH_FONT_HEIGHT = 7;
+
+const uint8_t GLYPH_FONT_5X7[GLYPH_FONT_COUNT][GLYPH_FONT_HEIGHT] = {
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// space
+	{ 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 },	// '!'
+	{ 0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00 },	// '"'
+	{ 0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A },	// '#'
+	{ 0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04 },	// '$'
+	{ 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 },	// '%'
+	{ 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D },	// '&'
+	{ 0x04, 0x04, 0x04, 0x00, 0x00, 0x00, 0x00 },	// '\''
+	{ 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 },	// '('
+	{ 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 },	// ')'
+	{ 0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00 },	// '*'
+	{ 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 },	// '+'
+	{ 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 },	// ','
+	{ 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 },	// '-'
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C },	// '.'
+	{ 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },	// '/'
+	{ 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },	// '0'
+	{ 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },	// '1'
+	{ 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },	// '2'
+	{ 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },	// '3'
+	{ 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },	// '4'
+	{ 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },	// '5'
+	{ 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },	// '6'
+	{ 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },	// '7'
+	{ 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },	// '8'
+	{ 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },	// '9'
+	{ 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 },	// ':'
+	{ 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08 },	// ';'
+	{ 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 },	// '<'
+	{ 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 },	// '='
+	{ 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 },	// '>'
+	{ 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 },	// '?'
+	{ 0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E },	// '@'
+	{ 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },	// 'A'
+	{ 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E },	// 'B'
+	{ 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E },	// 'C'
+	{ 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C },	// 'D'
+	{ 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F },	// 'E'
+	{ 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 },	// 'F'
+	{ 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F },	// 'G'
+	{ 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },	// 'H'
+	{ 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },	// 'I'
+	{ 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C },	// 'J'
+	{ 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },	// 'K'
+	{ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F },	// 'L'
+	{ 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 },	// 'M'
+	{ 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },	// 'N'
+	{ 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },	// 'O'
+	{ 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 },	// 'P'
+	{ 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D },	// 'Q'
+	{ 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 },	// 'R'
+	{ 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E },	// 'S'
+	{ 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },	// 'T'
+	{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },	// 'U'
+	{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 },	// 'V'
+	{ 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A },	// 'W'
+	{ 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 },	// 'X'
+	{ 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 },	// 'Y'
+	{ 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F },	// 'Z'
+	{ 0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E },	// '['
+	{ 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 },	// '\\'
+	{ 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E },	// ']'
+	{ 0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00 },	// '^'
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F },	// '_'
+	{ 0x08, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00 },	// '`'
+	{ 0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F },	// 'a'
+	{ 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E },	// 'b'
+	{ 0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E },	// 'c'
+	{ 0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F },	// 'd'
+	{ 0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E },	// 'e'
+	{ 0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08 },	// 'f'
+	{ 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E },	// 'g'
+	{ 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11 },	// 'h'
+	{ 0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E },	// 'i'
+	{ 0x02, 0x00, 0x06, 0x02, 0x02, 0x12, 0x0C },	// 'j'
+	{ 0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12 },	// 'k'
+	{ 0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },	// 'l'
+	{ 0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11 },	// 'm'
+	{ 0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11 },	// 'n'
+	{ 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E },	// 'o'
+	{ 0x00, 0x00, 0x1E, 0x11, 0x1E, 0x10, 0x10 },	// 'p'
+	{ 0x00, 0x00, 0x0D, 0x13, 0x0F, 0x01, 0x01 },	// 'q'
+	{ 0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10 },	// 'r'
+	{ 0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E },	// 's'
+	{ 0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06 },	// 't'
+	{ 0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D },	// 'u'
+	{ 0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04 },	// 'v'
+	{ 0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A },	// 'w'
+	{ 0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11 },	// 'x'
+	{ 0x00, 0x00, 0x11, 0x11, 0x0F, 0x01, 0x0E },	// 'y'
+	{ 0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F },	// 'z'
+	{ 0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02 },	// '{'
+	{ 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },	// '|'
+	{ 0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08 },	// '}'
+	{ 0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00 },	// '~'
+};
+
+// Signed distance field atlas of GLYPH_FONT_5X7, one R8 cell per glyph in rows of
+// GLYPH_ATLAS_COLUMNS. Every font pixel covers GLYPH_ATLAS_SCALE texels and each cell has
+// GLYPH_ATLAS_PADDING texels of border for the field to fall off in. 128 is the outline,
+// brighter is inside, one step of GLYPH_ATLAS_SPREAD texels spans the whole 0 .. 255 range.
+const int GLYPH_ATLAS_COLUMNS = 16;
+const int GLYPH_ATLAS_ROWS = (GLYPH_FONT_COUNT + GLYPH_ATLAS_COLUMNS - 1) / GLYPH_ATLAS_COLUMNS;
+const int GLYPH_ATLAS_SCALE = 6;
+const int GLYPH_ATLAS_PADDING = 6;
+const int GLYPH_ATLAS_CELL_WIDTH = GLYPH_FONT_WIDTH * GLYPH_ATLAS_SCALE + 2 * GLYPH_ATLAS_PADDING;
+const int GLYPH_ATLAS_CELL_HEIGHT = GLYPH_FONT_HEIGHT * GLYPH_ATLAS_SCALE + 2 * GLYPH_ATLAS_PADDING;
+const int GLYPH_ATLAS_WIDTH = GLYPH_ATLAS_COLUMNS * GLYPH_ATLAS_CELL_WIDTH;
+const int GLYPH_ATLAS_HEIGHT = GLYPH_ATLAS_ROWS * GLYPH_ATLAS_CELL_HEIGHT;
+const float GLYPH_ATLAS_SPREAD = 12.0f;
+
+// cell of a character, anything outside printable ASCII shows as '?'
+inline int GlyphIndex(unsigned char c)
+{
+	if (c < GLYPH_FONT_FIRST || c >= GLYPH_FONT_FIRST + GLYPH_FONT_COUNT)
+		c = '?';
+
+	return c - GLYPH_FONT_FIRST;
+}
+
+// The glyphs are unions of square pixels, so the distance of a texel to the outline is exactly
+// the distance to the nearest pixel of the other kind. Pixels outside the 5 x 7 box are empty;
+// one ring of them is enough, the field is clamped well before anything further could be nearer.
+inline std::vector<uint8_t> BuildGlyphAtlas()
+{
+	std::vector<uint8_t> atlas(GLYPH_ATLAS_WIDTH * GLYPH_ATLAS_HEIGHT, 0);
+
+	for (int glyph = 0; glyph < GLYPH_FONT_COUNT; glyph++)
+	{
+		int cellX = (glyph % GLYPH_ATLAS_COLUMNS) * GLYPH_ATLAS_CELL_WIDTH;
+		int cellY = (glyph / GLYPH_ATLAS_COLUMNS) * GLYPH_ATLAS_CELL_HEIGHT;
+
+		for (int y = 0; y < GLYPH_ATLAS_CELL_HEIGHT; y++)
+		{
+			for (int x = 0; x < GLYPH_ATLAS_CELL_WIDTH; x++)
+			{
+				// texel centre in font pixels, relative to the glyph's top left corner
+				float px = (x + 0.5f - GLYPH_ATLAS_PADDING) / GLYPH_ATLAS_SCALE;
+				float py = (y + 0.5f - GLYPH_ATLAS_PADDING) / GLYPH_ATLAS_SCALE;
+				int ownX = (int)std::floor(px);
+				int ownY = (int)std::floor(py);
+				bool inside = ownX >= 0 && ownX < GLYPH_FONT_WIDTH && ownY >= 0 && ownY < GLYPH_FONT_HEIGHT
+					&& (GLYPH_FONT_5X7[glyph][ownY] >> (GLYPH_FONT_WIDTH - 1 - ownX) & 1);
+
+				float nearest = 1e30f;
+
+				for (int row = -1; row <= GLYPH_FONT_HEIGHT; row++)
+				{
+					for (int column = -1; column <= GLYPH_FONT_WIDTH; column++)
+					{
+						bool set = row >= 0 && row < GLYPH_FONT_HEIGHT && column >= 0 && column < GLYPH_FONT_WIDTH
+							&& (GLYPH_FONT_5X7[glyph][row] >> (GLYPH_FONT_WIDTH - 1 - column) & 1);
+
+						if (set == inside)
+							continue;
+
+						float dx = std::max(std::max(column - px, px - (column + 1)), 0.0f);
+						float dy = std::max(std::max(row - py, py - (row + 1)), 0.0f);
+						nearest = std::min(nearest, dx * dx + dy * dy);
+					}
+				}
+
+				float distance = std::sqrt(nearest) * GLYPH_ATLAS_SCALE * (inside ? 1.0f : -1.0f);
+				float value = 0.5f + distance / GLYPH_ATLAS_SPREAD;
+				atlas[(cellY + y) * GLYPH_ATLAS_WIDTH + cellX + x] = (uint8_t)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+			}
+		}
+	}
+
+	return atlas;
+}
+
+#endif
@@ -0,0 +1,394 @@
+#ifndef GPU_CULLING_H
+#define GPU_CULLING_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_access.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "gl_extensions.h"
+#include "shader.h"
+#include "shader_cache.h"
+#include "camera.h"
+#include "star_store.h"
+#include "mesh_pool.h"
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+
+// std430 layouts shared with star_cull.comp and star_instanced.vert
+struct GpuStar {
+	float x, y, z;		// light years, the camera is subtracted on the GPU
+	uint32_t starClass;
+};
+
+struct GpuStarInstance {
+	float x, y, z;		// camera-relative render units
+	float scale;
+	uint32_t starClass;
+	uint32_t lod;
+	uint32_t pad[2];
+};
+
+static_assert(sizeof(GpuStar) == 16, "GpuStar must match the std430 layout in star_cull.comp");
+static_assert(sizeof(GpuStarInstance) == 32, "GpuStarInstance must match the std430 layout in star_cull.comp");
+
+const int GPU_CULL_LOD_COUNT = 4;
+const int GPU_CULL_IMPOSTOR = GPU_CULL_LOD_COUNT;			// command after the sphere LODs
+const int GPU_CULL_COMMAND_COUNT = GPU_CULL_LOD_COUNT + 1;
+const int GPU_CULL_GROUP_SIZE = 256;
+
+// Visibility for the whole star field is decided on the GPU. All stars live in a storage buffer,
+// star_cull.comp tests each against the frustum and its projected size, picks a sphere LOD and
+// writes the survivors into a compacted instance buffer plus one DrawElementsIndirectCommand per
+// LOD. Draw() is then a single glMultiDrawElementsIndirect, so the CPU does the same handful of
+// calls per frame whether there are a hundred stars or fifty million.
+//
+// Stars between impostorPixelRadius[0] and [1] skip the spheres and land in an extra command
+// that draws one camera-facing quad each; DrawImpostors() ray-casts the sphere on it
+// (star_impostor.vert / .frag), with exact depth and the same shading as the mesh.
+//
+// Culling runs in three dispatches: classify (frustum/size test and LOD count per star), offsets
+// (one invocation turns the counts into baseInstance values) and scatter (visible stars are
+// copied to their slot). Needs GL 4.3 or the matching extensions, check IsSupported().
+class GpuStarCuller
+{
+public:
+	float starRadius;			// render units, matches the 0.05 scale of the star models
+	float minPixelRadius;		// stars smaller than this on screen are dropped
+	float lodPixelRadius[GPU_CULL_LOD_COUNT - 1];	// switch to the next coarser sphere below these
+	float impostorPixelRadius[2];	// ray-cast quads from [0] up to [1], both 0 turns them off
+
+	GpuStarCuller() : starRadius(0.05f), minPixelRadius(0.5f), starCount(0), cullShader(NULL), starBuffer(0), lodBuffer(0),
+		commandBuffer(0), instanceBuffer(0), cursorBuffer(0), VAO(0), VBO(0), EBO(0)
+	{
+		lodPixelRadius[0] = 48.0f;
+		lodPixelRadius[1] = 12.0f;
+		lodPixelRadius[2] = 3.0f;
+		impostorPixelRadius[0] = 0.0f;
+		impostorPixelRadius[1] = 0.0f;
+	}
+
+	~GpuStarCuller()
+	{
+		glDeleteBuffers(1, &starBuffer);
+		glDeleteBuffers(1, &lodBuffer);
+		glDeleteBuffers(1, &commandBuffer);
+		glDeleteBuffers(1, &instanceBuffer);
+		glDeleteBuffers(1, &cursorBuffer);
+		glDeleteBuffers(1, &VBO);
+		glDeleteBuffers(1, &EBO);
+		glDeleteVertexArrays(1, &VAO);
+
+		if (cullShader)
+		{
+			glDeleteProgram(cullShader->ID);
+			delete cullShader;
+		}
+	}
+
+	GpuStarCuller(const GpuStarCuller&) = delete;
+	GpuStarCuller& operator=(const GpuStarCuller&) = delete;
+
+	static bool IsSupported()
+	{
+		return GLAD_GL_ARB_compute_shader && GLAD_GL_ARB_shader_storage_buffer_object && GLAD_GL_ARB_shader_image_load_store
+			&& GLAD_GL_ARB_draw_indirect && GLAD_GL_ARB_base_instance && GLAD_GL_ARB_multi_draw_indirect;
+	}
+
+	// the compute program goes through shaderCache if one is given
+	bool Init(ShaderCache* shaderCache = NULL)
+	{
+		if (!IsSupported())
+		{
+			std::cout << "ERROR::GPU_CULLING:: Needs GL 4.3 (compute shaders, storage buffers, multi draw indirect)" << std::endl;
+			return false;
+		}
+
+		if (shaderCache)
+		{
+			cullShader = new Shader(shaderCache->Request("star_cull.comp"));
+			shaderCache->Finish();
+		}
+		else
+		{
+			cullShader = new Shader("star_cull.comp");
+		}
+
+		// the program never changes, its uniforms are looked up once
+		static const char* const names[UNIFORM_COUNT] = { "eyeHigh", "eyeLow", "mapScale", "starRadius", "pixelScale",
+			"minPixelRadius", "lodPixelRadius", "impostorPixelRadius", "frustumPlanes", "starCount", "stage" };
+
+		for (int i = 0; i < UNIFORM_COUNT; i++)
+			uniforms[i] = glGetUniformLocation(cullShader->ID, names[i]);
+
+		glGenBuffers(1, &starBuffer);
+		glGenBuffers(1, &lodBuffer);
+		glGenBuffers(1, &commandBuffer);
+		glGenBuffers(1, &instanceBuffer);
+		glGenBuffers(1, &cursorBuffer);
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, cursorBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, GPU_CULL_COMMAND_COUNT * sizeof(GLuint), NULL, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		buildSpheres();
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(commandTemplate), commandTemplate, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+		return true;
+	}
+
+	// Replaces the star field. Only needed when stars are added, never per frame.
+	void Upload(const StarStore& store)
+	{
+		std::vector<GpuStar> stars(store.Size());
+
+		for (size_t i = 0; i < store.Size(); i++)
+		{
+			stars[i].x = (float)store.stars[i].x;
+			stars[i].y = (float)store.stars[i].y;
+			stars[i].z = (float)store.stars[i].z;
+			stars[i].starClass = store.stars[i].starClass;
+		}
+
+		starCount = (unsigned int)stars.size();
+		size_t capacity = stars.empty() ? 1 : stars.size();
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, starBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(GpuStar), stars.empty() ? NULL : stars.data(), GL_STATIC_DRAW);
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, lodBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(GLuint), NULL, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+		glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(GpuStarInstance), NULL, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		std::cout << "GPU culling: " << starCount << " stars, " << (capacity * (sizeof(GpuStar) + sizeof(GLuint) + sizeof(GpuStarInstance)) >> 20) << " MB" << std::endl;
+	}
+
+	// eye in light years, view/projection as used for drawing, viewportHeight in pixels
+	void Cull(const glm::dvec3& eye, double mapScale, const glm::mat4& view, const glm::mat4& projection, int viewportHeight)
+	{
+		if (starCount == 0)
+			return;
+
+		// instance counts back to zero, everything else in the commands is constant
+		glState.BindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(commandTemplate), commandTemplate);
+
+		// the eye is split into a float and the float rounding error, so stars near a camera
+		// far from Sol are not snapped to the float grid of their absolute position
+		glm::vec3 eyeHigh = glm::vec3(eye);
+		glm::vec3 eyeLow = glm::vec3(eye - glm::dvec3(eyeHigh));
+
+		glm::mat4 viewProjection = projection * view;
+		glm::vec4 planes[5];
+		planes[0] = glm::row(viewProjection, 3) + glm::row(viewProjection, 0);
+		planes[1] = glm::row(viewProjection, 3) - glm::row(viewProjection, 0);
+		planes[2] = glm::row(viewProjection, 3) + glm::row(viewProjection, 1);
+		planes[3] = glm::row(viewProjection, 3) - glm::row(viewProjection, 1);
+		// the far plane sits at infinity, only the near plane is left: view space -z >= near
+		glm::vec3 forward = -glm::vec3(glm::row(view, 2));
+		planes[4] = glm::vec4(forward, -NEAR_PLANE);
+
+		for (int i = 0; i < 4; i++)
+			planes[i] /= glm::length(glm::vec3(planes[i]));
+
+		cullShader->use();
+		glUniform3fv(uniforms[EYE_HIGH], 1, &eyeHigh[0]);
+		glUniform3fv(uniforms[EYE_LOW], 1, &eyeLow[0]);
+		glUniform1f(uniforms[MAP_SCALE], (float)mapScale);
+		glUniform1f(uniforms[STAR_RADIUS], starRadius);
+		glUniform1f(uniforms[PIXEL_SCALE], projection[1][1] * viewportHeight * 0.5f);
+		glUniform1f(uniforms[MIN_PIXEL_RADIUS], minPixelRadius);
+		glUniform1fv(uniforms[LOD_PIXEL_RADIUS], GPU_CULL_LOD_COUNT - 1, lodPixelRadius);
+		glUniform2f(uniforms[IMPOSTOR_PIXEL_RADIUS], impostorPixelRadius[0], impostorPixelRadius[1]);
+		glUniform4fv(uniforms[FRUSTUM_PLANES], 5, &planes[0][0]);
+		glUniform1ui(uniforms[STAR_COUNT], starCount);
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, starBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, lodBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, instanceBuffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, cursorBuffer);
+
+		GLuint groups = (starCount + GPU_CULL_GROUP_SIZE - 1) / GPU_CULL_GROUP_SIZE;
+
+		glUniform1i(uniforms[STAGE], 0);
+		glDispatchCompute(groups, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		glUniform1i(uniforms[STAGE], 1);
+		glDispatchCompute(1, 1, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		glUniform1i(uniforms[STAGE], 2);
+		glDispatchCompute(groups, 1, 1);
+		glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+		for (int i = 0; i < 5; i++)
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, 0);
+	}
+
+	// draws the spheres the last Cull() left in the command buffer
+	void Draw(Shader& shader)
+	{
+		if (starCount == 0)
+			return;
+
+		shader.use();
+
+		glState.BindVertexArray(VAO);
+		glState.BindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, GPU_CULL_LOD_COUNT, 0);
+	}
+
+	// the impostor quads of the last Cull(), same VAO and instance layout as Draw()
+	void DrawImpostors(Shader& shader)
+	{
+		if (starCount == 0 || impostorPixelRadius[1] <= impostorPixelRadius[0])
+			return;
+
+		shader.use();
+		shader.setInt("depthZeroToOne", GLAD_GL_ARB_clip_control);
+
+		glState.BindVertexArray(VAO);
+		glState.BindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(GPU_CULL_IMPOSTOR * sizeof(DrawElementsIndirectCommand)), 1, 0);
+	}
+
+	// Reads the commands back, stalls the pipeline. Debugging and benchmarks only.
+	unsigned int GetVisibleCount(unsigned int perLod[GPU_CULL_COMMAND_COUNT] = NULL)
+	{
+		DrawElementsIndirectCommand commands[GPU_CULL_COMMAND_COUNT];
+
+		glState.BindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+		glGetBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(commands), commands);
+
+		unsigned int total = 0;
+
+		for (int i = 0; i < GPU_CULL_COMMAND_COUNT; i++)
+		{
+			total += commands[i].instanceCount;
+
+			if (perLod)
+				perLod[i] = commands[i].instanceCount;
+		}
+
+		return total;
+	}
+
+	unsigned int GetStarCount() const { return starCount; }
+
+private:
+	enum { EYE_HIGH, EYE_LOW, MAP_SCALE, STAR_RADIUS, PIXEL_SCALE, MIN_PIXEL_RADIUS, LOD_PIXEL_RADIUS,
+		IMPOSTOR_PIXEL_RADIUS, FRUSTUM_PLANES, STAR_COUNT, STAGE, UNIFORM_COUNT };
+
+	unsigned int starCount;
+	Shader* cullShader;
+	GLint uniforms[UNIFORM_COUNT];
+
+	unsigned int starBuffer;		// GpuStar per star
+	unsigned int lodBuffer;			// LOD per star after classify, ~0u when culled
+	unsigned int commandBuffer;		// DrawElementsIndirectCommand per LOD, then the impostors
+	unsigned int instanceBuffer;	// compacted GpuStarInstance, per-instance vertex attributes
+	unsigned int cursorBuffer;		// per LOD write position during scatter
+
+	unsigned int VAO, VBO, EBO;
+	DrawElementsIndirectCommand commandTemplate[GPU_CULL_COMMAND_COUNT];
+
+	// One unit sphere per LOD and the impostor quad, all in one vertex and index buffer so a single
+	// VAO serves every command. Normals equal positions and are not stored.
+	void buildSpheres()
+	{
+		const int rings[GPU_CULL_LOD_COUNT] = { 32, 16, 8, 4 };
+
+		std::vector<glm::vec3> vertices;
+		std::vector<GLuint> indices;
+
+		for (int lod = 0; lod < GPU_CULL_LOD_COUNT; lod++)
+		{
+			int segments = rings[lod] * 2;
+
+			commandTemplate[lod] = {};
+			commandTemplate[lod].firstIndex = (GLuint)indices.size();
+			commandTemplate[lod].baseVertex = (GLint)vertices.size();
+
+			for (int r = 0; r <= rings[lod]; r++)
+			{
+				float phi = glm::pi<float>() * r / rings[lod];
+
+				for (int s = 0; s <= segments; s++)
+				{
+					float theta = glm::two_pi<float>() * s / segments;
+					vertices.push_back(glm::vec3(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta)));
+				}
+			}
+
+			for (int r = 0; r < rings[lod]; r++)
+			{
+				for (int s = 0; s < segments; s++)
+				{
+					GLuint a = r * (segments + 1) + s;
+					GLuint b = a + segments + 1;
+
+					indices.push_back(a);
+					indices.push_back(a + 1);
+					indices.push_back(b);
+
+					indices.push_back(a + 1);
+					indices.push_back(b + 1);
+					indices.push_back(b);
+				}
+			}
+
+			commandTemplate[lod].count = (GLuint)indices.size() - commandTemplate[lod].firstIndex;
+		}
+
+		// corners in x / y, star_impostor.vert turns them towards the camera
+		commandTemplate[GPU_CULL_IMPOSTOR] = {};
+		commandTemplate[GPU_CULL_IMPOSTOR].count = 6;
+		commandTemplate[GPU_CULL_IMPOSTOR].firstIndex = (GLuint)indices.size();
+		commandTemplate[GPU_CULL_IMPOSTOR].baseVertex = (GLint)vertices.size();
+
+		vertices.insert(vertices.end(), { glm::vec3(-1.0f, -1.0f, 0.0f), glm::vec3(1.0f, -1.0f, 0.0f), glm::vec3(1.0f, 1.0f, 0.0f), glm::vec3(-1.0f, 1.0f, 0.0f) });
+		indices.insert(indices.end(), { 0, 1, 2, 0, 2, 3 });
+
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &VBO);
+		glGenBuffers(1, &EBO);
+
+		glBindVertexArray(VAO);
+
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+
+		// per-instance attributes come straight from the compacted buffer the compute pass wrote,
+		// baseInstance in each command points them at that LOD's range
+		glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(GpuStarInstance), (void*)0);
+		glVertexAttribDivisor(1, 1);
+		glEnableVertexAttribArray(2);
+		glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(GpuStarInstance), (void*)offsetof(GpuStarInstance, starClass));
+		glVertexAttribDivisor(2, 1);
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+};
+
+#endif
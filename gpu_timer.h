@@ -0,0 +1,88 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <glad/glad.h>
+
+const int GPU_TIMER_LATENCY = 4;	// frames a result may trail the commands it timed
+
+// GPU time of the commands between Begin() and End(), with GL_TIME_ELAPSED queries. Each frame
+// uses the next of GPU_TIMER_LATENCY queries and only a result that is already available is
+// read, so timing never stalls the pipeline. Timers must not nest, one query of this kind can
+// be active at a time.
+class GpuTimer
+{
+public:
+	GpuTimer() : current(0), milliseconds(0.0f)
+	{
+		for (int i = 0; i < GPU_TIMER_LATENCY; i++)
+		{
+			queries[i] = 0;
+			pending[i] = false;
+		}
+	}
+
+	~GpuTimer()
+	{
+		if (queries[0])
+			glDeleteQueries(GPU_TIMER_LATENCY, queries);
+	}
+
+	GpuTimer(const GpuTimer&) = delete;
+	GpuTimer& operator=(const GpuTimer&) = delete;
+
+	void Begin()
+	{
+		if (!queries[0])
+			glGenQueries(GPU_TIMER_LATENCY, queries);
+
+		current = (current + 1) % GPU_TIMER_LATENCY;
+
+		// the oldest query is about to be reused, collect it if the GPU is done with it
+		if (pending[current])
+			collect(current);
+
+		glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+	}
+
+	void End()
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		pending[current] = true;
+	}
+
+	// the latest finished measurement
+	float GetMilliseconds()
+	{
+		for (int i = 1; i <= GPU_TIMER_LATENCY; i++)
+		{
+			int index = (current + i) % GPU_TIMER_LATENCY;
+
+			if (pending[index] && index != current)
+				collect(index);
+		}
+
+		return milliseconds;
+	}
+
+private:
+	GLuint queries[GPU_TIMER_LATENCY];
+	bool pending[GPU_TIMER_LATENCY];
+	int current;
+	float milliseconds;
+
+	void collect(int index)
+	{
+		GLint available = 0;
+		glGetQueryObjectiv(queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (!available)
+			return;
+
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(queries[index], GL_QUERY_RESULT, &nanoseconds);
+		milliseconds = (float)(nanoseconds / 1.0e6);
+		pending[index] = false;
+	}
+};
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef HISTORY_PLAYBACK_H
+#define HISTORY_PLAYBACK_H
+
+#include <glm/glm.hpp>
+
+#include "jump_history.h"
+
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <cmath>
+
+// systems [first, end) of the JumpHistory became visible or hidden
+typedef std::function<void(uint32_t first, uint32_t end, bool visible)> HistoryRevealListener;
+
+// Replays a JumpHistory. A clock runs through the history at speed history seconds per second
+// and can be sought or scrubbed to any moment; both only cost a binary search, however many
+// years of jumps there are. GetJumps() and GetJumpProgress() say how much of a TravelPath to
+// draw, the newest jump growing out of its system over jumpSeconds. Systems appear as they are
+// first reached: whoever subscribed through OnReveal() hears which ones changed.
+class HistoryPlayback
+{
+public:
+	double speed = 7.0 * 86400.0;	// history seconds per second, a week
+	double jumpSeconds = 0.5;		// seconds the newest jump takes to draw
+
+	HistoryPlayback(const JumpHistory& history) : history(history), time(0.0), playing(false), jumps(0), systems(0)
+	{
+	}
+
+	HistoryPlayback(const HistoryPlayback&) = delete;
+	HistoryPlayback& operator=(const HistoryPlayback&) = delete;
+
+	void Play()
+	{
+		// from the start again once it ran out
+		if (time >= (double)history.GetEndTime())
+			Seek((double)history.GetStartTime());
+
+		playing = true;
+	}
+
+	void Pause() { playing = false; }
+	void Toggle() { playing ? Pause() : Play(); }
+
+	// seconds since 1970, clamped to the history
+	void Seek(double timestamp)
+	{
+		time = std::min(std::max(timestamp, (double)history.GetStartTime()), (double)history.GetEndTime());
+		jumps = history.JumpsUntil((int64_t)std::floor(time));
+
+		size_t visible = history.SystemsAfter(jumps);
+
+		if (visible != systems)
+		{
+			size_t first = std::min(visible, systems);
+			size_t end = std::max(visible, systems);
+			systems = visible;
+
+			for (HistoryRevealListener& listener : revealListeners)
+				listener((uint32_t)first, (uint32_t)end, visible == end);
+		}
+	}
+
+	// by history seconds, negative goes back
+	void Scrub(double seconds)
+	{
+		Seek(time + seconds);
+	}
+
+	// seconds since the last frame
+	void Update(double deltaTime)
+	{
+		if (!playing)
+			return;
+
+		Seek(time + deltaTime * speed);
+
+		if (time >= (double)history.GetEndTime())
+			playing = false;
+	}
+
+	void OnReveal(const HistoryRevealListener& listener) { revealListeners.push_back(listener); }
+
+	// 0 as the newest jump starts, 1 once it arrived
+	double GetJumpProgress() const
+	{
+		if (jumps == 0)
+			return 1.0;
+
+		double elapsed = time - (double)history.GetTime(jumps - 1);
+		return std::min(elapsed / std::max(jumpSeconds * speed, 1.0), 1.0);
+	}
+
+	// light years, along the newest jump while it is drawn
+	glm::dvec3 GetShipPosition() const
+	{
+		if (jumps == 0)
+			return history.GetJumpCount() > 0 ? history.GetPosition(history.GetJump(0).to) : glm::dvec3(0.0);
+
+		const JumpRecord& jump = history.GetJump(jumps - 1);
+		glm::dvec3 to = history.GetPosition(jump.to);
+
+		return jump.from == JUMP_HISTORY_NONE ? to : glm::mix(history.GetPosition(jump.from), to, GetJumpProgress());
+	}
+
+	double GetTime() const { return time; }
+	bool IsPlaying() const { return playing; }
+	size_t GetJumps() const { return jumps; }
+	size_t GetVisibleSystems() const { return systems; }
+
+private:
+	const JumpHistory& history;
+
+	double time;		// seconds since 1970
+	bool playing;
+	size_t jumps;		// made up to time
+	size_t systems;		// reached up to time
+
+	std::vector<HistoryRevealListener> revealListeners;
+};
+
+#endif
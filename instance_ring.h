@@ -0,0 +1,227 @@
+#ifndef INSTANCE_RING_H
+#define INSTANCE_RING_H
+
+#include <glad/glad.h>
+
+#include "gl_extensions.h"
+#include "gl_resources.h"
+
+#include <vector>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+
+const int INSTANCE_RING_REGIONS = 3;	// frames the CPU may run ahead of the GPU
+const size_t INSTANCE_RING_BLOCK = 16;	// records per dirty bit, small enough that scattered edits stay cheap
+
+// Per-instance records that live on the GPU for many frames and change a few at a time.
+//
+// The CPU keeps a shadow copy of every record. Edit() hands out a pointer into it and marks the
+// records dirty; Commit() brings the GPU copy up to date and returns where to read it from. On
+// the 4.5 path the buffer is immutable, persistently mapped and split into
+// INSTANCE_RING_REGIONS full copies used in turn: Commit() moves to the next region, waits for
+// the fence of the frame that last read it and copies only the blocks that changed since that
+// region was written, so a frame that edits nothing uploads nothing. On 3.3 there is a single
+// copy and each dirty run goes out with glBufferSubData.
+class InstanceRing
+{
+public:
+	GLuint ID;
+
+	InstanceRing(size_t recordSize) : ID(0), recordSize(recordSize), count(0), region(0), mapped(NULL), committedBytes(0), waits(0)
+	{
+		for (int i = 0; i < INSTANCE_RING_REGIONS; i++)
+			fences[i] = 0;
+	}
+
+	~InstanceRing()
+	{
+		release();
+	}
+
+	InstanceRing(const InstanceRing&) = delete;
+	InstanceRing& operator=(const InstanceRing&) = delete;
+
+	// Reallocates for recordCount records, the contents are undefined and all of them dirty.
+	// On 3.3 the buffer keeps its name so VAOs pointing at it stay valid.
+	void Resize(size_t recordCount)
+	{
+		count = recordCount;
+		shadow.assign(std::max(count, (size_t)1) * recordSize, 0);
+
+		size_t regionBytes = shadow.size();
+
+		if (UseDirectStateAccess())
+		{
+			release();
+
+			// dynamic storage for the glBufferSubData fallback should mapping fail
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glCreateBuffers(1, &ID);
+			glNamedBufferStorage(ID, regionBytes * INSTANCE_RING_REGIONS, NULL, flags | GL_DYNAMIC_STORAGE_BIT);
+			mapped = (unsigned char*)glMapNamedBufferRange(ID, 0, regionBytes * INSTANCE_RING_REGIONS, flags);
+
+			if (!mapped)
+				std::cout << "ERROR::INSTANCE_RING:: Could not map " << regionBytes * INSTANCE_RING_REGIONS << " bytes, falling back to glBufferSubData" << std::endl;
+		}
+		else
+		{
+			if (ID == 0)
+				glGenBuffers(1, &ID);
+
+			glBindBuffer(GL_COPY_WRITE_BUFFER, ID);
+			glBufferData(GL_COPY_WRITE_BUFFER, regionBytes, NULL, GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		}
+
+		size_t blocks = (count + INSTANCE_RING_BLOCK - 1) / INSTANCE_RING_BLOCK;
+		size_t words = (blocks + 63) / 64;
+
+		for (int i = 0; i < INSTANCE_RING_REGIONS; i++)
+			dirty[i].assign(words, 0);
+
+		MarkAllDirty();
+	}
+
+	size_t Size() const { return count; }
+	size_t GetRecordSize() const { return recordSize; }
+
+	// recordCount records from first on, to be written before the next Commit()
+	unsigned char* Edit(size_t first, size_t recordCount = 1)
+	{
+		if (recordCount == 0 || first >= count)
+			return NULL;
+
+		size_t firstBlock = first / INSTANCE_RING_BLOCK;
+		size_t lastBlock = (std::min(first + recordCount, count) - 1) / INSTANCE_RING_BLOCK;
+
+		// every region is behind until it has been written once more
+		for (int i = 0; i < INSTANCE_RING_REGIONS; i++)
+			for (size_t block = firstBlock; block <= lastBlock; block++)
+				dirty[i][block / 64] |= 1ull << (block % 64);
+
+		return &shadow[first * recordSize];
+	}
+
+	const unsigned char* Read(size_t record) const { return &shadow[record * recordSize]; }
+
+	void MarkAllDirty()
+	{
+		if (count > 0)
+			Edit(0, count);
+	}
+
+	// Uploads what changed since the region was last used and returns its byte offset. Call once
+	// per frame before the draws that read the records, followed by Fence() after them.
+	size_t Commit()
+	{
+		committedBytes = 0;
+
+		if (mapped)
+		{
+			region = (region + 1) % INSTANCE_RING_REGIONS;
+			wait(fences[region]);
+		}
+
+		size_t regionOffset = mapped ? region * shadow.size() : 0;
+		std::vector<uint64_t>& bits = dirty[mapped ? region : 0];
+		size_t blocks = (count + INSTANCE_RING_BLOCK - 1) / INSTANCE_RING_BLOCK;
+		size_t block = 0;
+
+		while (block < blocks)
+		{
+			if (!(bits[block / 64] & (1ull << (block % 64))))
+			{
+				// skip clean words whole
+				if (bits[block / 64] == 0)
+					block = (block / 64 + 1) * 64;
+				else
+					block++;
+				continue;
+			}
+
+			size_t runEnd = block;
+			while (runEnd < blocks && (bits[runEnd / 64] & (1ull << (runEnd % 64))))
+				runEnd++;
+
+			size_t first = block * INSTANCE_RING_BLOCK * recordSize;
+			size_t bytes = std::min(runEnd * INSTANCE_RING_BLOCK, count) * recordSize - first;
+
+			if (mapped)
+				std::memcpy(mapped + regionOffset + first, &shadow[first], bytes);
+			else
+				UpdateBuffer(ID, first, bytes, &shadow[first]);
+
+			committedBytes += bytes;
+			block = runEnd;
+		}
+
+		std::fill(bits.begin(), bits.end(), 0);
+
+		return regionOffset;
+	}
+
+	// after the last draw that reads what Commit() returned
+	void Fence()
+	{
+		if (!mapped)
+			return;
+
+		if (fences[region])
+			glDeleteSync(fences[region]);
+
+		fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	// bytes the last Commit() copied
+	size_t GetCommittedBytes() const { return committedBytes; }
+	// Commit() calls that had to wait for the GPU
+	unsigned int GetWaits() const { return waits; }
+
+private:
+	size_t recordSize;
+	size_t count;
+	int region;
+	unsigned char* mapped;
+	GLsync fences[INSTANCE_RING_REGIONS];
+	std::vector<unsigned char> shadow;
+	std::vector<uint64_t> dirty[INSTANCE_RING_REGIONS];	// one bit per INSTANCE_RING_BLOCK records, only [0] on 3.3
+	size_t committedBytes;
+	unsigned int waits;
+
+	void wait(GLsync& fence)
+	{
+		if (!fence)
+			return;
+
+		// flush once so the fence is guaranteed to signal, then keep waiting
+		GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		GLenum result;
+
+		while ((result = glClientWaitSync(fence, waitFlags, 1000000)) == GL_TIMEOUT_EXPIRED)
+			waitFlags = 0;
+
+		if (result == GL_CONDITION_SATISFIED)
+			waits++;
+
+		glDeleteSync(fence);
+		fence = 0;
+	}
+
+	void release()
+	{
+		for (int i = 0; i < INSTANCE_RING_REGIONS; i++)
+			wait(fences[i]);
+
+		if (mapped)
+			glUnmapNamedBuffer(ID);
+
+		glDeleteBuffers(1, &ID);
+		ID = 0;
+		mapped = NULL;
+	}
+};
+
+#endif
@@ -1,11 +1,18 @@
+#ifndef JOURNAL_READER_H
+#define JOURNAL_READER_H
+
 #include <vector>
 #include <string>
 #include <iostream>
 #include <filesystem>
 #include <fstream>
+#include <algorithm>
 
 #include <stdio.h>
 
+#include "jump_history.h"
+#include "event_store.h"
+
 #include "External Libraries/rapidjson/document.h"
 #include "External Libraries/rapidjson/writer.h"
 #include "External Libraries/rapidjson/stringbuffer.h"
@@ -30,16 +37,45 @@ enum StarClass {
 struct Coordinate {
 	std::string name;
 	StarClass starClass;
-	glm::vec3 coords;
+	glm::dvec3 coords;	// light years from Sol, full precision
 };
 
 class JournalReader {
 public:
 
-	JournalReader() { }
+	JournalReader() : mLastJournalOffset(0) { }
 	std::vector<Coordinate> mVisitedCoordinates;
+	JumpHistory mJumpHistory;
+	EventStore mEvents;	// every event of every journal
+	std::string mCurrentSystem;	// where the ship is, from the last Location or FSDJump
 	void readAllJounals(std::string path) 
 	{
+		for (const auto& journal : listJournals(path, ""))
+			readJournal(journal);
+	}
+
+	// What the game wrote since the last read, meant to be called every so often while it runs.
+	// True if there are new systems or jumps.
+	bool pollJournals(std::string path)
+	{
+		size_t visited = mVisitedCoordinates.size();
+		size_t jumps = mJumpHistory.GetJumpCount();
+
+		for (const auto& journal : listJournals(path, mLastJournal))
+			readJournal(journal);
+
+		return mVisitedCoordinates.size() != visited || mJumpHistory.GetJumpCount() != jumps;
+	}
+private:
+	std::string mLastJournal;			// sort key of the journal read last
+	std::streamoff mLastJournalOffset;	// and how far
+
+	// sort keys and paths of the journals from the one with key first on, oldest first: the jump
+	// history only grows forwards in time
+	std::vector<std::pair<std::string, std::string>> listJournals(const std::string& path, const std::string& first)
+	{
+		std::vector<std::pair<std::string, std::string>> journals;
+
 		for (const auto& entry : std::filesystem::directory_iterator(path))
 		{
 			std::string fileName = entry.path().string();
@@ -47,12 +83,24 @@ public:
 			fileName = ReplaceAll(fileName, path, "");
 			fileName = ReplaceAll(fileName, "\\", "");
 
-			if (fileName._Starts_with("Journal.") && hasEnding(fileName, ".log"))
-				processFile(entry.path().string(), mVisitedCoordinates);
+			if (fileName._Starts_with("Journal.") && hasEnding(fileName, ".log") && journalSortKey(fileName) >= first)
+				journals.push_back(std::make_pair(journalSortKey(fileName), entry.path().string()));
 		}
+
+		std::sort(journals.begin(), journals.end());
+		return journals;
 	}
-private:
-	void processFile(std::string path, std::vector<Coordinate> visitedCoordinates)
+
+	void readJournal(const std::pair<std::string, std::string>& journal)
+	{
+		std::streamoff offset = journal.first == mLastJournal ? mLastJournalOffset : 0;
+
+		mLastJournalOffset = processFile(journal.second, mVisitedCoordinates, offset);
+		mLastJournal = journal.first;
+	}
+
+	// from offset on, returns the offset after the last complete line
+	std::streamoff processFile(std::string path, std::vector<Coordinate>& visitedCoordinates, std::streamoff offset)
 	{
 		fstream newFile;
 
@@ -62,20 +110,33 @@ private:
 		{
 			string line;
 
+			newFile.seekg(offset);
+
 			while (getline(newFile, line))
 			{
+				// the game may be halfway through writing it, it is read again next time
+				if (newFile.eof())
+					break;
+
+				offset = newFile.tellg();
+
 				const char* lineChars = line.c_str();
 
 				rapidjson::Document doc;
 				doc.Parse(lineChars);
-
+				mEvents.Ingest(doc);
 
 				rapidjson::Value& v = doc["event"];
 				string event(v.GetString());
 
 				
 
-				if (event == "StartJump")
+				if (event == "Location")
+				{
+					mCurrentSystem = doc["StarSystem"].GetString();
+					mJumpHistory.Locate(mCurrentSystem);
+				}
+				else if (event == "StartJump")
 				{
 					rapidjson::Value& t = doc["JumpType"];
 					string jType(t.GetString());
@@ -109,24 +170,31 @@ private:
 					{
 						Coordinate& c = *i;
 
-						c.coords.x = posArr[0].GetFloat() / 10;
-						c.coords.y = posArr[1].GetFloat() / 10;
-						c.coords.z = posArr[2].GetFloat() / 10;
+						c.coords.x = posArr[0].GetDouble();
+						c.coords.y = posArr[1].GetDouble();
+						c.coords.z = posArr[2].GetDouble();
 						cout << "System: " << c.name << ", StarClass: " << c.starClass << ", x: " << c.coords.x << ", y: " << c.coords.y << ", z: " << c.coords.z << endl;
 					}
 					else
 					{
 						Coordinate c;
 						c.name = sSystem;
-						c.coords.x = posArr[0].GetFloat() / 10;
-						c.coords.y = posArr[1].GetFloat() / 10;
-						c.coords.z = posArr[2].GetFloat() / 10;
+						c.coords.x = posArr[0].GetDouble();
+						c.coords.y = posArr[1].GetDouble();
+						c.coords.z = posArr[2].GetDouble();
 						mVisitedCoordinates.push_back(c);
 						cout << "System: " << c.name << ", StarClass: Unknown, " << ", x: " << c.coords.x << ", y: " << c.coords.y << ", z: " << c.coords.z << endl;
 					}
+
+					glm::dvec3 coords(posArr[0].GetDouble(), posArr[1].GetDouble(), posArr[2].GetDouble());
+					double distance = doc.HasMember("JumpDist") ? doc["JumpDist"].GetDouble() : -1.0;
+					mJumpHistory.Append(JumpHistory::ParseTimestamp(doc["timestamp"].GetString()), sSystem, coords, distance);
+					mCurrentSystem = sSystem;
 				}
 			}
 		}
+
+		return offset;
 	}
 
 	std::string ReplaceAll(std::string str, const std::string& from, const std::string& to) {
@@ -138,6 +206,22 @@ private:
 		return str;
 	}
 
+	// Journal.YYMMDDhhmmss.01.log until early 2022, Journal.YYYY-MM-DDThhmmss.01.log since; both
+	// become YYYYMMDDhhmmss.01 so that they sort by time
+	std::string journalSortKey(const std::string& fileName)
+	{
+		std::string key = fileName.substr(8, fileName.length() - 12);
+
+		if (key.length() > 4 && key[4] == '-')
+		{
+			key.erase(std::remove(key.begin(), key.end(), '-'), key.end());
+			key.erase(std::remove(key.begin(), key.end(), 'T'), key.end());
+			return key;
+		}
+
+		return "20" + key;
+	}
+
 	bool hasEnding(std::string const& fullString, std::string const& ending)
 	{
 		if (fullString.length() >= ending.length())
@@ -148,7 +232,8 @@ private:
 			return false;
 	}
 
-	StarClass EvaluateStarClass(std::string classString)
+public:
+	static StarClass EvaluateStarClass(std::string classString)
 	{
 		if (classString == "O")
 		{
@@ -215,4 +300,6 @@ private:
 			return StarClass::GENERIC;
 		}
 	}
-};
\ No newline at end of file
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,162 @@
+#ifndef JUMP_HISTORY_H
+#define JUMP_HISTORY_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+
+const uint32_t JUMP_HISTORY_NONE = 0xFFFFFFFFu;
+
+// one hyperspace jump, 16 bytes
+struct JumpRecord {
+	uint32_t time;		// seconds since the history's epoch
+	uint32_t from;		// system index, JUMP_HISTORY_NONE if the ship's location was not known
+	uint32_t to;		// system index
+	float distance;		// light years
+};
+
+// Every FSDJump in the order it happened. Jumps are only ever appended and must not go back in
+// time, so the records are their own time index: the jumps up to any moment are a prefix, found
+// by binary search. Systems are numbered in the order they were first reached, which makes the
+// systems visited up to any moment a prefix as well.
+class JumpHistory
+{
+public:
+	JumpHistory() : epoch(0), current(JUMP_HISTORY_NONE)
+	{
+	}
+
+	// timestamp in seconds since 1970, distance < 0 measures it from the system jumped from
+	bool Append(int64_t timestamp, const std::string& system, const glm::dvec3& coords, double distance = -1.0)
+	{
+		if (jumps.empty())
+			epoch = timestamp;
+
+		if (timestamp < GetEndTime() || timestamp - epoch > (int64_t)UINT32_MAX)
+		{
+			std::cout << "ERROR::JUMP_HISTORY::OUT_OF_ORDER: jump to " << system << " at " << timestamp << " dropped" << std::endl;
+			return false;
+		}
+
+		uint32_t to = FindSystem(system);
+
+		if (to == JUMP_HISTORY_NONE)
+		{
+			to = (uint32_t)names.size();
+			index[system] = to;
+			names.push_back(system);
+			positions.push_back(coords);
+			firstJumps.push_back((uint32_t)jumps.size());
+		}
+
+		JumpRecord jump;
+		jump.time = (uint32_t)(timestamp - epoch);
+		jump.from = current;
+		jump.to = to;
+		jump.distance = (float)(distance >= 0.0 || current == JUMP_HISTORY_NONE ? std::max(distance, 0.0) : glm::length(coords - positions[current]));
+		jumps.push_back(jump);
+
+		current = to;
+		return true;
+	}
+
+	// the ship turned up somewhere without a jump, e.g. on loading the game
+	void Locate(const std::string& system)
+	{
+		current = FindSystem(system);
+	}
+
+	// jumps made up to and including timestamp
+	size_t JumpsUntil(int64_t timestamp) const
+	{
+		if (jumps.empty() || timestamp < epoch)
+			return 0;
+
+		uint32_t time = (uint32_t)std::min(timestamp - epoch, (int64_t)UINT32_MAX);
+		return std::upper_bound(jumps.begin(), jumps.end(), time, [](uint32_t t, const JumpRecord& jump) { return t < jump.time; }) - jumps.begin();
+	}
+
+	// systems reached within the first jumpCount jumps
+	size_t SystemsAfter(size_t jumpCount) const
+	{
+		return std::lower_bound(firstJumps.begin(), firstJumps.end(), (uint32_t)std::min(jumpCount, (size_t)UINT32_MAX)) - firstJumps.begin();
+	}
+
+	uint32_t FindSystem(const std::string& system) const
+	{
+		auto it = index.find(system);
+		return it == index.end() ? JUMP_HISTORY_NONE : it->second;
+	}
+
+	const JumpRecord& GetJump(size_t jump) const { return jumps[jump]; }
+	int64_t GetTime(size_t jump) const { return epoch + jumps[jump].time; }
+	size_t GetJumpCount() const { return jumps.size(); }
+
+	const std::string& GetName(uint32_t system) const { return names[system]; }
+	const glm::dvec3& GetPosition(uint32_t system) const { return positions[system]; }
+	size_t GetFirstJump(uint32_t system) const { return firstJumps[system]; }
+	size_t GetSystemCount() const { return names.size(); }
+
+	int64_t GetStartTime() const { return epoch; }
+	int64_t GetEndTime() const { return jumps.empty() ? epoch : epoch + jumps.back().time; }
+
+	// journal timestamps, "2023-01-31T18:04:55Z", in seconds since 1970; -1 if it is none
+	static int64_t ParseTimestamp(const char* text)
+	{
+		int year, month, day, hour, minute, second;
+
+		if (!text || sscanf(text, "%d-%d-%dT%d:%d:%d", &year, &month, &day, &hour, &minute, &second) != 6)
+			return -1;
+
+		// days since 1970-01-01 of the proleptic Gregorian calendar, Howard Hinnant's days_from_civil
+		year -= month <= 2;
+		int64_t era = (year >= 0 ? year : year - 399) / 400;
+		int64_t yearOfEra = year - era * 400;
+		int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+		int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+		int64_t days = era * 146097 + dayOfEra - 719468;
+
+		return days * 86400 + hour * 3600 + minute * 60 + second;
+	}
+
+	// the other way round, Howard Hinnant's civil_from_days
+	static std::string FormatTimestamp(int64_t timestamp)
+	{
+		int64_t days = (timestamp >= 0 ? timestamp : timestamp - 86399) / 86400;
+		int64_t seconds = timestamp - days * 86400;
+
+		days += 719468;
+		int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+		int64_t dayOfEra = days - era * 146097;
+		int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+		int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+		int64_t monthIndex = (5 * dayOfYear + 2) / 153;
+		int day = (int)(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+		int month = (int)(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+		int year = (int)(yearOfEra + era * 400 + (month <= 2));
+
+		char text[32];
+		snprintf(text, sizeof(text), "%04d-%02d-%02dT%02d:%02d:%02dZ", year, month, day, (int)(seconds / 3600), (int)(seconds / 60 % 60), (int)(seconds % 60));
+		return text;
+	}
+
+private:
+	int64_t epoch;		// seconds since 1970 of the first jump
+	uint32_t current;	// where the ship is
+
+	std::vector<JumpRecord> jumps;
+
+	// systems in the order they were first reached
+	std::vector<std::string> names;
+	std::vector<glm::dvec3> positions;	// light years
+	std::vector<uint32_t> firstJumps;	// index of the jump that first reached the system
+	std::unordered_map<std::string, uint32_t> index;
+};
+
+#endif
@@ -12,35 +12,199 @@
 #include "camera.h"
 #include "model.h"
 #include "journal_reader.h"
+#include "render_targets.h"
+#include "gl_extensions.h"
+#include "OpenVRPart.h"
+#include "stereo.h"
+#include "star_store.h"
+#include "galaxy_importer.h"
+#include "galaxy_octree.h"
+#include "gpu_culling.h"
+#include "star_batch.h"
+#include "shader_cache.h"
+#include "gl_state.h"
+#include "gl_resources.h"
+#include "render_queue.h"
+#include "clustered_lights.h"
+#include "star_hlod.h"
+#include "bloom.h"
+#include "text_labels.h"
+#include "star_picker.h"
+#include "star_grid.h"
+#include "route_planner.h"
+#include "route_line.h"
+#include "history_playback.h"
+#include "travel_path.h"
+#include "exploration_stats.h"
+#include "text_overlay.h"
 
 #include <iostream>
 
 #include <string>
 
+// #define ENABLE_VR	// render both eyes in a single pass and submit them through OpenVRPart
+// #define MOCK_VR		// no headset: use MockVRBackend, benchmark the stereo path in a hidden window and exit
+// #define GALAXY_DUMP "galaxy.json.gz"	// community dump (JSON lines or CSV, plain or gzip) imported once into GALAXY_SNAPSHOT
+#define GALAXY_SNAPSHOT "galaxy.stars"
+// #define GALAXY_OCTREE "galaxy.octree"	// built from GALAXY_SNAPSHOT once, then streamed around the camera
+const size_t GALAXY_TILE_BUDGET = 256 << 20;	// bytes of star tiles kept resident
+// #define BENCHMARK_MESH_OPTIMIZER	// vertex cache numbers for the star models on the CPU, then exit
+// #define GPU_CULLING	// cull and draw the star field on the GPU (compute + multi draw indirect, GL 4.3)
+// #define STAR_IMPOSTORS	// GPU_CULLING: stars 5-100 px across are ray-cast on a quad instead of meshed
+// #define NO_DSA		// create buffers, textures and framebuffers the GL 3.3 way even on a 4.5 context
+// #define GL_STATE_STATS	// GL state calls issued / elided by glState in the last frame, shown in the window title
+// #define GPU_TIMINGS	// GPU time of the bloom chain, shown in the window title
+// #define PROCEDURAL_STARS	// every class from one generated sphere shaded by star_procedural.frag, no star models or textures
+// #define CLUSTERED_LIGHTING	// visited stars light their neighbours, binned per frame into a cluster grid
+// #define BENCHMARK_INSTANCE_RING	// instance upload bandwidth at 1M stars in a hidden window, then exit
+// #define STAR_HLOD	// every star of GALAXY_SNAPSHOT as a point, dense cells far away merged into one glow each
+// #define SYSTEM_LABELS	// names of the visited systems (and of GALAXY_SNAPSHOT, if there is one) next to the stars
+// #define STAR_PICKING	// hover highlights the star under the cursor or crosshair, left click selects, right click frees the cursor
+// #define ROUTE_PLANNER	// STAR_PICKING: selecting a system plans a route to it from the ship's system
+// #define HISTORY_PLAYBACK	// P plays the jump history back, holding [ or ] scrubs it; systems appear as they were first visited
+// #define TRAVEL_PATH	// the path through every jump of the journals as a line (HISTORY_PLAYBACK draws it up to the playback time)
+// #define LIVE_JOURNAL	// the journals are read again every second, new jumps extend the history, path, visited stars, picking, routes and labels as they arrive
+// #define EXPLORATION_STATS	// jump, distance and star class statistics of the journals (and GALAXY_SNAPSHOT) in an overlay, J writes them to STATS_JSON_PATH
+// #define BENCHMARK_EXPLORATION_STATS	// statistics over a 10M jump synthetic history on all threads and on one, then exit
+// #define BENCHMARK_EVENT_STORE	// ingests 5M synthetic journal events into an EventStore and times a few queries, then exit
+// #define BENCHMARK_ROUTE_PLANNER	// routes between random systems of GALAXY_SNAPSHOT (or 10M synthetic ones), then exit
+
 static void error_callback(int error, const char* description);
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void processInput(GLFWwindow* window);
 void drawOutput(glm::vec4 backgroundColor, Shader shader, JournalReader jR, Model loadedModel);
-void drawOutputToTexture(glm::vec4 backgroundColor, Shader shader, Shader screenShader, JournalReader jR, unsigned int framebuffer, unsigned int textColorBuffer, unsigned int quadVAO);
+void drawOutputToTexture(glm::vec4 backgroundColor, Shader shader, Shader screenShader, JournalReader& jR, int sceneTarget, unsigned int quadVAO);
+void drawStereoOutput(glm::vec4 backgroundColor, Shader& shader, JournalReader& jR, StereoRenderTarget& target, OpenVRPart& vrPart, bool singlePass);
+void benchmarkStereo(Shader& shader, JournalReader& jR, StereoRenderTarget& target, OpenVRPart& vrPart, unsigned int frames);
 glm::mat4 toGLM(const vr::HmdMatrix34_t& m);
-void drawCorrectStarModel(Coordinate c, Shader shader);
+void drawStars(Shader& shader, std::vector<Coordinate>& coordinates, unsigned int instanceCount);
+Model& correctStarModel(StarClass starClass);
+void benchmarkMeshOptimizer();
+void benchmarkInstanceRing(size_t starCount, unsigned int frames);
+void benchmarkRoutePlanner(size_t syntheticCount, unsigned int pairs);
+void benchmarkEventStore(size_t eventCount);
+void benchmarkExplorationStats(size_t jumpCount);
+size_t pickToBatch(size_t pick);
+size_t findPickStar(const JournalReader& jR, const std::string& name);
+void mapVisitedStars(const JournalReader& jR, bool located);
+void updateNearbyStars(const glm::dvec3& eye, bool force);
+void mapHistoryStars(const JournalReader& jR);
+void addLiveSystems(const JournalReader& jR);
+void updateStarLights(std::vector<Coordinate>& coordinates, const glm::mat4& view, const glm::mat4& projection);
 
 //settings
 const unsigned int SRC_WIDTH = 2560;
 const unsigned int SRC_HEIGHT = 1080;
+const double MAP_SCALE = 0.1; // render units per light year
+const float STAR_LIGHT_RADIUS = 1.5f; // render units a star lights up around it
+const float STAR_LIGHT_INTENSITY = 0.5f;
+const std::string JOURNAL_PATH = "C:\\Users\\dario\\Saved Games\\Frontier Developments\\Elite Dangerous";
+const float JOURNAL_POLL_INTERVAL = 1.0f; // seconds, LIVE_JOURNAL
+const double JUMP_RANGE = 50.0; // light years per jump for the route planner
+const size_t NEARBY_STAR_COUNT = 100000; // systems around the camera that can be picked and labelled
+const double GALAXY_GRID_CELL = 100.0; // light years, cells of the grid the nearby systems are found in
+const float VISITED_STAR_SCALE = 0.05f; // render units, radius of a visited star in StarBatch
+const double HISTORY_SCRUB_SPEED = 365.0 * 86400.0; // history seconds per second while [ or ] is held
+const std::string STATS_JSON_PATH = "exploration_stats.json"; // EXPLORATION_STATS
 
 //camera
-Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+Camera camera(glm::dvec3(0.0, 0.0, 3.0));
 float lastX = SRC_WIDTH / 2.0f;
 float lastY = SRC_HEIGHT / 2.0f;
 bool firstMouse = true;
+bool freeCursor = false; // the mouse moves a cursor instead of turning the camera
 
 //timing
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+//offscreen targets, sized to the window framebuffer
+RenderTargetPool renderTargets;
+
+//out-of-core galaxy, only set up when GALAXY_OCTREE is defined
+OctreeStreamer* galaxyStreamer = NULL;
+Shader* galaxyShader = NULL;
+
+//GPU-driven star field, only set up when GPU_CULLING is defined and supported
+GpuStarCuller* starCuller = NULL;
+Shader* starCullerShader = NULL;
+Shader* starImpostorShader = NULL;
+
+//star store as a cell hierarchy, only set up when STAR_HLOD is defined
+StarHlodTree* starHlodTree = NULL;
+StarHlodRenderer* starHlod = NULL;
+Shader* starHlodPointShader = NULL;
+Shader* starHlodGlowShader = NULL;
+
+//all star models in one mesh pool and texture array, drawn with a single multi-draw
+StarBatch* starBatch = NULL;
+Shader* starBatchShader = NULL;
+
+//HDR scene glow, set up once the render targets exist
+Bloom* bloom = NULL;
+
+//glyphs of the labels and the stats overlay, only set up when either is
+GlyphAtlas* glyphAtlas = NULL;
+
+//system names, only set up when SYSTEM_LABELS is defined
+TextLabels* systemLabels = NULL;
+Shader* textShader = NULL;
+
+//GALAXY_SNAPSHOT, or the visited systems if there is none, loaded once for every consumer below.
+//Visited systems it does not have are added as they are mapped to StarBatch.
+StarStore galaxyStars;
+
+//the systems nearest the camera, only set up when STAR_PICKING or SYSTEM_LABELS is defined. They are gathered
+//again once the camera has moved a quarter of the way to the farthest of them.
+StarGrid* galaxyGrid = NULL;
+std::vector<uint32_t> nearbyStars;
+glm::dvec3 nearbyCenter = glm::dvec3(0.0);
+double nearbyRadius = 0.0;
+
+//galaxyStars index of each StarBatch star and back
+std::vector<uint32_t> batchGalaxy;
+std::unordered_map<uint32_t, size_t> galaxyBatch;
+
+//star under the cursor, only set up when STAR_PICKING is defined. It picks from the visited and
+//the nearby systems, by galaxyStars index.
+StarPicker* starPicker = NULL;
+
+//routes over galaxyStars, only set up when ROUTE_PLANNER is defined
+RoutePlanner* routePlanner = NULL;
+RouteLine* routeLine = NULL;
+Shader* routeShader = NULL;
+
+//jump history replay, only set up when HISTORY_PLAYBACK is defined. historyBatchStars is the
+//StarBatch star of each history system, (size_t)-1 if it has none.
+HistoryPlayback* playback = NULL;
+std::vector<size_t> historyBatchStars;
+
+//history systems mapped to galaxyStars, LIVE_JOURNAL adds the ones after
+size_t liveSystems = 0;
+
+//the jumps as a line, only set up when TRAVEL_PATH or HISTORY_PLAYBACK is defined
+TravelPath* travelPath = NULL;
+Shader* travelPathShader = NULL;
+
+//only set up when EXPLORATION_STATS is defined
+ExplorationStats* explorationStats = NULL;
+TextOverlay* statsOverlay = NULL;
+Shader* overlayShader = NULL;
+
+//per-model star draws, sorted by state before they are issued
+RenderQueue renderQueue;
+
+//visited stars as point lights, only set up when CLUSTERED_LIGHTING is defined
+ClusteredLights* clusteredLights = NULL;
+std::vector<ClusterLight> starLightSources;	// radius and colour, rebuilt when the visited stars change
+std::vector<glm::dvec3> starLightPositions;
+std::vector<ClusterLight> starLights;			// the sources moved to the camera, every frame
+bool starLightsChanged = true;
+
 Model genericStarModel		;//= Model("resources/models/stars/generic_star/star.obj");
 Model classASpotlessModel	;//= Model("resources/models/stars/a_spotless/a_spotless.obj");
 Model classASpotsModel		;//= Model("resources/models/stars/a_with_spots/a_with_spots.obj");
@@ -58,14 +222,52 @@ Model classYModel			;//= Model("resources/models/stars/y/y.obj");
 int main()
 {
 	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	// 4.5 for compute culling, indirect draws and clip control, everything else runs on 3.3
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 	glfwSetErrorCallback(error_callback);
 
+#ifdef BENCHMARK_MESH_OPTIMIZER
+	benchmarkMeshOptimizer();
+	glfwTerminate();
+	return 0;
+#endif
+
+#ifdef BENCHMARK_ROUTE_PLANNER
+	benchmarkRoutePlanner(10000000, 20);
+	glfwTerminate();
+	return 0;
+#endif
+
+#ifdef BENCHMARK_EVENT_STORE
+	benchmarkEventStore(5000000);
+	glfwTerminate();
+	return 0;
+#endif
+
+#ifdef BENCHMARK_EXPLORATION_STATS
+	benchmarkExplorationStats(10000000);
+	glfwTerminate();
+	return 0;
+#endif
+
+#if defined(MOCK_VR) || defined(BENCHMARK_INSTANCE_RING)
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#endif
+
 	JournalReader jR = JournalReader();
-	jR.readAllJounals("C:\\Users\\dario\\Saved Games\\Frontier Developments\\Elite Dangerous");
+	jR.readAllJounals(JOURNAL_PATH);
+	liveSystems = jR.mJumpHistory.GetSystemCount();
+
+#ifdef GALAXY_DUMP
+	if (!fs::exists(GALAXY_SNAPSHOT))
+	{
+		GalaxyImporter importer;
+		importer.Import(GALAXY_DUMP, GALAXY_SNAPSHOT, jR.mVisitedCoordinates);
+	}
+#endif
 
 	//GLFW Fenster (zum Gucken!)
 	GLFWwindow* window;
@@ -74,7 +276,13 @@ int main()
 	//window = glfwCreateWindow(vrPart.rtWidth, vrPart.rtHeight, "Hello OpenVR", NULL, NULL);
 	//window = glfwCreateWindow(SRC_WIDTH, SRC_HEIGHT, "HelloWindow", glfwGetPrimaryMonitor(), NULL);
 	window = glfwCreateWindow(SRC_WIDTH, SRC_HEIGHT, "HelloWindow", NULL, NULL);
-	
+
+	if (window == NULL)
+	{
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		window = glfwCreateWindow(SRC_WIDTH, SRC_HEIGHT, "HelloWindow", NULL, NULL);
+	}
 
 	if (window == NULL)
 	{
@@ -88,6 +296,8 @@ int main()
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetScrollCallback(window, scroll_callback);
+	glfwSetMouseButtonCallback(window, mouse_button_callback);
+	glfwSetKeyCallback(window, key_callback);
 
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
@@ -98,27 +308,161 @@ int main()
 		return -1;
 	}
 
+	loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+#ifdef NO_DSA
+	GLAD_GL_ARB_direct_state_access = 0;
+#endif
+
 	//stbi_set_flip_vertically_on_load(true);
 	glEnable(GL_DEPTH_TEST);
 
-	// Shader bauen
-	Shader ourShader("model_loading.vert", "model_loading.frag");
-	Shader screenShader("screen.vert", "screen.frag");
-
-	// Model laden
-	genericStarModel    = Model("resources/models/stars/generic_star/star.obj");
-	classASpotlessModel = Model("resources/models/stars/a_spotless/a_spotless.obj");
-	classASpotsModel	= Model("resources/models/stars/a_with_spots/a_with_spots.obj");
-	classBModel			= Model("resources/models/stars/b/b.obj");
-	classFModel			= Model("resources/models/stars/f/f.obj");
-	classGModel			= Model("resources/models/stars/g/g.obj");
-	classKModel			= Model("resources/models/stars/k/k.obj");
-	classLModel			= Model("resources/models/stars/l/l.obj");
-	classMModel			= Model("resources/models/stars/m/m.obj");
-	classOModel			= Model("resources/models/stars/o/o.obj");
-	classTModel			= Model("resources/models/stars/t/t.obj");
-	wolfRayetModel		= Model("resources/models/stars/wolf_rayet/wolf_rayet.obj");
-	classYModel			= Model("resources/models/stars/y/y.obj");
+	// reversed-Z: near maps to 1, infinity to 0. With clip control the full float range of the
+	// depth buffer is used, without it depth lands in [0.5, 1] but still sorts correctly.
+	if (GLAD_GL_ARB_clip_control)
+		glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+	glDepthFunc(GL_GREATER);
+	glClearDepth(0.0);
+
+#ifdef BENCHMARK_INSTANCE_RING
+	benchmarkInstanceRing(1000000, 300);
+	glfwTerminate();
+	return 0;
+#endif
+
+	// Shader bauen: all programs are queued first so the driver compiles them in parallel, linked
+	// binaries are kept in shader_cache/ for the next start
+	ShaderCache shaderCache;
+#ifdef CLUSTERED_LIGHTING
+	Shader ourShader = shaderCache.Request("colors.vert", "colors.frag");
+	clusteredLights = new ClusteredLights();
+#else
+	Shader ourShader = shaderCache.Request("model_loading.vert", "model_loading.frag");
+#endif
+	Shader screenShader = shaderCache.Request("screen.vert", "screen.frag");
+	Shader bloomDownShader = shaderCache.Request("screen.vert", "bloom_downsample.frag");
+	Shader bloomUpShader = shaderCache.Request("screen.vert", "bloom_upsample.frag");
+#ifdef PROCEDURAL_STARS
+	Shader batchShader = shaderCache.Request("star_batch.vert", "star_procedural.frag");
+#else
+	Shader batchShader = shaderCache.Request("star_batch.vert", "star_batch.frag");
+#endif
+#ifdef GALAXY_OCTREE
+	Shader starPointShader = shaderCache.Request("star_points.vert", "star_points.frag");
+#endif
+#ifdef GPU_CULLING
+	Shader gpuStarShader = shaderCache.Request("star_instanced.vert", "star_instanced.frag");
+	Shader impostorShader = shaderCache.Request("star_impostor.vert", "star_impostor.frag");
+#endif
+#ifdef STAR_HLOD
+	Shader hlodPointShader = shaderCache.Request("star_hlod_points.vert", "star_points.frag");
+	Shader hlodGlowShader = shaderCache.Request("star_hlod_glow.vert", "star_hlod_glow.frag");
+#endif
+#if defined(SYSTEM_LABELS) || defined(EXPLORATION_STATS)
+	Shader labelShader = shaderCache.Request("text.vert", "text.frag");
+#endif
+#if defined(ROUTE_PLANNER) || defined(HISTORY_PLAYBACK) || defined(TRAVEL_PATH)
+	Shader routeLineShader = shaderCache.Request("route_line.vert", "route_line.frag");
+#endif
+	shaderCache.Finish();
+
+	// star meshes only carry what the shaders drawing them read, packed small. The stereo
+	// vertex shaders read the same inputs as model_loading.vert.
+	unsigned int starAttributes = ReflectVertexAttributes(ourShader.ID) | ReflectVertexAttributes(batchShader.ID);
+
+	// Model laden: the per-model and stereo paths still draw the star models
+#if !defined(PROCEDURAL_STARS) || defined(ENABLE_VR)
+	genericStarModel    = Model("resources/models/stars/generic_star/star.obj", false, starAttributes);
+	classASpotlessModel = Model("resources/models/stars/a_spotless/a_spotless.obj", false, starAttributes);
+	classASpotsModel	= Model("resources/models/stars/a_with_spots/a_with_spots.obj", false, starAttributes);
+	classBModel			= Model("resources/models/stars/b/b.obj", false, starAttributes);
+	classFModel			= Model("resources/models/stars/f/f.obj", false, starAttributes);
+	classGModel			= Model("resources/models/stars/g/g.obj", false, starAttributes);
+	classKModel			= Model("resources/models/stars/k/k.obj", false, starAttributes);
+	classLModel			= Model("resources/models/stars/l/l.obj", false, starAttributes);
+	classMModel			= Model("resources/models/stars/m/m.obj", false, starAttributes);
+	classOModel			= Model("resources/models/stars/o/o.obj", false, starAttributes);
+	classTModel			= Model("resources/models/stars/t/t.obj", false, starAttributes);
+	wolfRayetModel		= Model("resources/models/stars/wolf_rayet/wolf_rayet.obj", false, starAttributes);
+	classYModel			= Model("resources/models/stars/y/y.obj", false, starAttributes);
+#endif
+
+#ifdef PROCEDURAL_STARS
+	// one sphere for all classes, class and seed travel per instance
+	Model starSphere = Model::Sphere(32, 64, starAttributes);
+	starBatch = new StarBatch();
+
+	for (int starClass = 0; starClass < STAR_CLASS_COUNT; starClass++)
+		starBatch->SetClassModel((StarClass)starClass, starSphere, STAR_CLASS_COLORS[starClass]);
+#else
+	// same class to model mapping as correctStarModel
+	starBatch = new StarBatch();
+	starBatch->SetClassModel(StarClass::O, classOModel, STAR_CLASS_COLORS[StarClass::O]);
+	starBatch->SetClassModel(StarClass::B, classBModel, STAR_CLASS_COLORS[StarClass::B]);
+	starBatch->SetClassModel(StarClass::A, classASpotsModel, STAR_CLASS_COLORS[StarClass::A]);
+	starBatch->SetClassModel(StarClass::F, classFModel, STAR_CLASS_COLORS[StarClass::F]);
+	starBatch->SetClassModel(StarClass::G, classGModel, STAR_CLASS_COLORS[StarClass::G]);
+	starBatch->SetClassModel(StarClass::K, classKModel, STAR_CLASS_COLORS[StarClass::K]);
+	starBatch->SetClassModel(StarClass::L, classLModel, STAR_CLASS_COLORS[StarClass::L]);
+	starBatch->SetClassModel(StarClass::M, classMModel, STAR_CLASS_COLORS[StarClass::M]);
+	starBatch->SetClassModel(StarClass::T, classTModel, STAR_CLASS_COLORS[StarClass::T]);
+	starBatch->SetClassModel(StarClass::Y, classYModel, STAR_CLASS_COLORS[StarClass::Y]);
+	starBatch->SetClassModel(StarClass::D, wolfRayetModel, STAR_CLASS_COLORS[StarClass::D]);
+	starBatch->SetClassModel(StarClass::GENERIC, classASpotsModel, STAR_CLASS_COLORS[StarClass::GENERIC]);
+#endif
+	starBatch->Upload(starAttributes);
+	starBatch->SetStars(jR.mVisitedCoordinates, VISITED_STAR_SCALE);
+	starBatchShader = &batchShader;
+
+#ifdef HISTORY_PLAYBACK
+	{
+		const JumpHistory& history = jR.mJumpHistory;
+		std::cout << "Jump history: " << history.GetJumpCount() << " jumps to " << history.GetSystemCount() << " systems" << std::endl;
+
+		// every history system hidden until the start reveals the first
+		playback = new HistoryPlayback(history);
+		mapHistoryStars(jR);
+
+		playback->OnReveal([](uint32_t first, uint32_t end, bool visible) {
+			for (uint32_t system = first; system < end && system < historyBatchStars.size(); system++)
+				if (historyBatchStars[system] != (size_t)-1)
+					starBatch->SetScale(historyBatchStars[system], visible ? VISITED_STAR_SCALE : 0.0f);
+		});
+
+		playback->Seek((double)history.GetStartTime());
+	}
+#endif
+
+#if defined(TRAVEL_PATH) || defined(HISTORY_PLAYBACK)
+	travelPath = new TravelPath();
+	travelPath->Sync(jR.mJumpHistory);
+	travelPathShader = &routeLineShader;
+#endif
+
+#if defined(GPU_CULLING) || defined(STAR_HLOD) || defined(STAR_PICKING) || defined(SYSTEM_LABELS) || defined(EXPLORATION_STATS)
+	bool hasSnapshot = fs::exists(GALAXY_SNAPSHOT) && galaxyStars.Load(GALAXY_SNAPSHOT);
+
+	if (!hasSnapshot)
+		galaxyStars.AddVisited(jR.mVisitedCoordinates);
+#endif
+
+#if defined(SYSTEM_LABELS) || defined(EXPLORATION_STATS)
+	glyphAtlas = new GlyphAtlas();
+	glyphAtlas->Init();
+#endif
+
+#ifdef EXPLORATION_STATS
+	explorationStats = new ExplorationStats();
+	explorationStats->Update(jR.mJumpHistory, jR.mVisitedCoordinates);
+
+	if (hasSnapshot)
+		explorationStats->Update(galaxyStars);
+
+	statsOverlay = new TextOverlay(*glyphAtlas);
+	statsOverlay->SetText(explorationStats->Report());
+	overlayShader = &labelShader;
+
+	std::cout << "Exploration: " << explorationStats->Summary() << std::endl;
+#endif
 
 	glm::vec4 backgroundRGBA = glm::vec4(0.01f, 0.01f, 0.01f, 1.00f);
 
@@ -135,42 +479,170 @@ int main()
 		 1.0f,  1.0f,  1.0f, 1.0f
 	};
 	
-	unsigned int quadVAO, quadVBO;
-	glGenVertexArrays(1, &quadVAO);
-	glGenBuffers(1, &quadVBO);
-	glBindVertexArray(quadVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+	unsigned int quadVBO = CreateBuffer(sizeof(quadVertices), quadVertices);
+	VertexArrayBuilder quadBuilder;
+	quadBuilder.Buffer(0, quadVBO, 4 * sizeof(float));
+	quadBuilder.Attribute(0, 0, 2, GL_FLOAT, GL_FALSE, 0);
+	quadBuilder.Attribute(1, 0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float));
+	unsigned int quadVAO = quadBuilder.Finish();
 
 	screenShader.use();
 	screenShader.setInt("screenTexture", 0);
+	screenShader.setInt("bloomTexture", 1);
+	screenShader.setFloat("exposure", 1.0f);
+
+	int fbWidth, fbHeight;
+	glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+	renderTargets.Resize(fbWidth, fbHeight);
+
+	// storage is created on first use and rebuilt whenever the window size changes. The scene
+	// is HDR so bright stars can exceed 1.0 and bloom, the screen pass tone maps it.
+	RenderTargetDesc sceneDesc;
+	sceneDesc.colorFormat = GL_R11F_G11F_B10F;
+	sceneDesc.depthFormat = GL_DEPTH32F_STENCIL8;
+	int sceneTarget = renderTargets.Create("scene", sceneDesc);
+	bloom = new Bloom(renderTargets, bloomDownShader, bloomUpShader);
+
+#ifdef GALAXY_OCTREE
+	if (!fs::exists(GALAXY_OCTREE))
+	{
+		OctreeBuilder builder;
+		builder.Build(GALAXY_SNAPSHOT, GALAXY_OCTREE);
+	}
+
+	GalaxyOctree galaxyOctree;
+
+	if (galaxyOctree.Open(GALAXY_OCTREE))
+	{
+		galaxyStreamer = new OctreeStreamer(galaxyOctree, GALAXY_TILE_BUDGET);
+		galaxyShader = &starPointShader;
+	}
+#endif
+
+#ifdef GPU_CULLING
+	starCuller = new GpuStarCuller();
+
+	if (starCuller->Init(&shaderCache))
+	{
+		starCuller->Upload(galaxyStars);
+		starCullerShader = &gpuStarShader;
+#ifdef STAR_IMPOSTORS
+		starCuller->impostorPixelRadius[0] = 2.5f;
+		starCuller->impostorPixelRadius[1] = 50.0f;
+		starImpostorShader = &impostorShader;
+#endif
+	}
+	else
+	{
+		delete starCuller;
+		starCuller = NULL;
+	}
+#endif
+
+#ifdef STAR_HLOD
+	{
+		starHlodTree = new StarHlodTree();
+		starHlodTree->Build(galaxyStars);
+		starHlod = new StarHlodRenderer();
+		starHlod->Upload(*starHlodTree);
+		starHlodTree->ReleaseStars();
+		starHlodPointShader = &hlodPointShader;
+		starHlodGlowShader = &hlodGlowShader;
+	}
+#endif
+
+#if defined(STAR_PICKING) || defined(SYSTEM_LABELS)
+	galaxyGrid = new StarGrid();
+	galaxyGrid->Build(galaxyStars, GALAXY_GRID_CELL);
+	mapVisitedStars(jR, false);
+#endif
+
+#ifdef STAR_PICKING
+	{
+		starPicker = new StarPicker();
+		starPicker->starRadius = 0.05 / MAP_SCALE;	// drawStars / StarBatch scale
+
+		starPicker->OnHover([](size_t previous, size_t current) {
+			if (pickToBatch(previous) != (size_t)-1)
+				starBatch->SetHighlight(pickToBatch(previous), false);
+			if (pickToBatch(current) != (size_t)-1)
+				starBatch->SetHighlight(pickToBatch(current), true);
+		});
+
+		starPicker->OnSelect([](size_t, size_t current) {
+			if (current == STAR_PICK_NONE)
+				return;
+
+			glm::dvec3 position = galaxyStars.GetPosition(current);
+			std::cout << "Selected " << galaxyStars.GetName(current) << " (" << position.x << ", " << position.y << ", " << position.z << ")" << std::endl;
+		});
+
+#ifdef ROUTE_PLANNER
+		routePlanner = new RoutePlanner(galaxyStars);
+		routePlanner->Prepare(JUMP_RANGE);
+		routeLine = new RouteLine();
+		routeShader = &routeLineShader;
+
+		// from where the ship is
+		starPicker->OnSelect([&jR](size_t, size_t current) {
+			if (current == STAR_PICK_NONE)
+				return;
+
+			size_t ship = findPickStar(jR, jR.mCurrentSystem);
+
+			if (ship == STAR_PICK_NONE)
+			{
+				std::cout << "Route: the ship is not in a visited system (" << jR.mCurrentSystem << ")" << std::endl;
+				return;
+			}
+
+			RouteOptions options;
+			options.jumpRange = JUMP_RANGE;
+			options.neutronBoost = true;
+			Route route = routePlanner->Plan((uint32_t)ship, (uint32_t)current, options);
+			routeLine->SetRoute(galaxyStars, route);
+
+			if (route.Found())
+				std::cout << "Route: " << route.Jumps() << " jumps, " << route.distance << " ly, " << route.expanded << " systems searched in " << route.milliseconds << " ms" << std::endl;
+			else
+				std::cout << "Route: none within " << route.expanded << " systems (" << route.milliseconds << " ms)" << std::endl;
+		});
+#endif
+	}
+#endif
+
+#ifdef SYSTEM_LABELS
+	systemLabels = new TextLabels(*glyphAtlas);
+	textShader = &labelShader;
+#endif
+
+#if defined(STAR_PICKING) || defined(SYSTEM_LABELS)
+	updateNearbyStars(camera.Position / MAP_SCALE, true);
+#else
+	// nothing reads it after start-up
+	galaxyStars = StarStore();
+#endif
+
+#ifdef ENABLE_VR
+#ifdef MOCK_VR
+	OpenVRPart vrPart(true);
+#else
+	OpenVRPart vrPart;
+#endif
+	StereoRenderTarget stereoTarget(vrPart.rtWidth, vrPart.rtHeight);
+	Shader stereoShader = shaderCache.Request(stereoTarget.GetVertexShaderPath(), "model_loading.frag");
+	shaderCache.Finish();
+
+#ifdef MOCK_VR
+	benchmarkStereo(stereoShader, jR, stereoTarget, vrPart, 300);
+	glfwSetWindowShouldClose(window, true);
+#endif
+#endif
+
+#ifdef LIVE_JOURNAL
+	float lastJournalPoll = 0.0f;
+#endif
 
-	unsigned int framebuffer;
-	glGenFramebuffers(1, &framebuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-
-	unsigned int textureColorbuffer;
-	glGenTextures(1, &textureColorbuffer);
-	glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, SRC_WIDTH, SRC_HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureColorbuffer, 0);
-
-	unsigned int rbo;
-	glGenRenderbuffers(1, &rbo);
-	glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, SRC_WIDTH, SRC_HEIGHT); // use a single renderbuffer object for both a depth AND stencil buffer.
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo); // now actually attach it
-	// now that we actually created the framebuffer and added all attachments we want to check if it is actually complete now
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << endl;
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	
 	while (!glfwWindowShouldClose(window))
 	{
 		float currentFrame = glfwGetTime();
@@ -178,15 +650,136 @@ int main()
 		lastFrame = currentFrame;
 
 		processInput(window);
+		renderTargets.BeginFrame();
+
+#ifdef LIVE_JOURNAL
+		if (currentFrame - lastJournalPoll >= JOURNAL_POLL_INTERVAL)
+		{
+			lastJournalPoll = currentFrame;
+
+			int64_t previousEnd = jR.mJumpHistory.GetEndTime();
+
+			if (jR.pollJournals(JOURNAL_PATH))
+			{
+				if (travelPath)
+					travelPath->Sync(jR.mJumpHistory);
+				if (explorationStats && explorationStats->Update(jR.mJumpHistory, jR.mVisitedCoordinates))
+					statsOverlay->SetText(explorationStats->Report());
+
+				starBatch->SetStars(jR.mVisitedCoordinates, VISITED_STAR_SCALE);
+				starLightsChanged = true;
+				addLiveSystems(jR);
+
+				// playback decides which visited stars are shown; one sitting at the end follows along
+				if (playback)
+				{
+					mapHistoryStars(jR);
+
+					if (playback->GetTime() >= (double)previousEnd)
+						playback->Seek((double)jR.mJumpHistory.GetEndTime());
+				}
+
+				if (starPicker && pickToBatch(starPicker->GetHovered()) != (size_t)-1)
+					starBatch->SetHighlight(pickToBatch(starPicker->GetHovered()), true);
+			}
+		}
+#endif
+
+		if (playback)
+			playback->Update(deltaTime);
+
+		if (galaxyGrid)
+			updateNearbyStars(camera.Position / MAP_SCALE, false);
+
+		if (starPicker)
+		{
+			// through the cursor when it is free, else through the middle of the screen
+			glm::vec2 ndc = glm::vec2(0.0f);
+
+			if (freeCursor)
+			{
+				double cursorX, cursorY;
+				int windowWidth, windowHeight;
+				glfwGetCursorPos(window, &cursorX, &cursorY);
+				glfwGetWindowSize(window, &windowWidth, &windowHeight);
+				ndc = glm::vec2(cursorX / windowWidth * 2.0 - 1.0, 1.0 - cursorY / windowHeight * 2.0);
+			}
+
+			glm::mat4 projection = camera.GetProjectionMatrix((float)renderTargets.GetWidth() / (float)renderTargets.GetHeight());
+			starPicker->UpdateHover(camera.Position / MAP_SCALE, camera.GetViewMatrix(), projection, ndc, renderTargets.GetHeight());
+		}
+
+		if (galaxyStreamer)
+		{
+			galaxyStreamer->Update(camera.Position / MAP_SCALE);
+			galaxyStreamer->ProcessUploads();
+		}
+
+		// everything above may bind behind glState's back, from here on all draws go through it
+		glState.BeginFrame();
+
+#if defined(GL_STATE_STATS) || defined(GPU_TIMINGS) || defined(HISTORY_PLAYBACK)
+		std::string title = "HelloWindow";
+#ifdef HISTORY_PLAYBACK
+		title += " - jump " + std::to_string(playback->GetJumps()) + " of " + std::to_string(jR.mJumpHistory.GetJumpCount()) + ", " + std::to_string(playback->GetVisibleSystems()) + " systems";
+#endif
+#ifdef GL_STATE_STATS
+		const GLStateStats& stateStats = glState.GetFrameStats();
+		title += " - GL state calls: " + std::to_string(stateStats.issued) + " issued, " + std::to_string(stateStats.elided) + " elided";
+#endif
+#ifdef GPU_TIMINGS
+		title += " - bloom: " + std::to_string(bloom->GetMilliseconds()) + " ms";
+#endif
+		glfwSetWindowTitle(window, title.c_str());
+#endif
+
 		//drawOutput(backgroundRGBA, ourShader, jR, loadedModel);
-		drawOutputToTexture(backgroundRGBA, ourShader, screenShader, jR, framebuffer, textureColorbuffer, quadVAO);
+		drawOutputToTexture(backgroundRGBA, ourShader, screenShader, jR, sceneTarget, quadVAO);
 
-		//vrPart.submitFramesToOpenVR(result, result);
+#ifdef ENABLE_VR
+		drawStereoOutput(backgroundRGBA, stereoShader, jR, stereoTarget, vrPart, true);
+#endif
 
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
 
+	delete galaxyStreamer;
+	galaxyStreamer = NULL;
+	delete starCuller;
+	starCuller = NULL;
+	delete starHlod;
+	starHlod = NULL;
+	delete starHlodTree;
+	starHlodTree = NULL;
+	delete starBatch;
+	starBatch = NULL;
+	delete clusteredLights;
+	clusteredLights = NULL;
+	delete bloom;
+	bloom = NULL;
+	delete systemLabels;
+	systemLabels = NULL;
+	delete starPicker;
+	starPicker = NULL;
+	delete galaxyGrid;
+	galaxyGrid = NULL;
+	delete routeLine;
+	routeLine = NULL;
+	delete routePlanner;
+	routePlanner = NULL;
+	delete playback;
+	playback = NULL;
+	delete travelPath;
+	travelPath = NULL;
+	delete explorationStats;
+	explorationStats = NULL;
+	delete statsOverlay;
+	statsOverlay = NULL;
+	delete glyphAtlas;
+	glyphAtlas = NULL;
+	renderTargets.Clear();
+
 	glfwTerminate();
 	return 0;
 }
@@ -198,7 +791,7 @@ void drawOutput(glm::vec4 backgroundColor, Shader shader, JournalReader jR)
 
 	shader.use();
 
-	glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SRC_WIDTH / (float)SRC_HEIGHT, 0.1f, 500.0f);
+	glm::mat4 projection = camera.GetProjectionMatrix((float)SRC_WIDTH / (float)SRC_HEIGHT);
 	glm::mat4 view = camera.GetViewMatrix();
 	shader.setMat4("projection", projection);
 	shader.setMat4("view", view);
@@ -206,41 +799,112 @@ void drawOutput(glm::vec4 backgroundColor, Shader shader, JournalReader jR)
 	/*for (unsigned int i = 0; i < jR.mVisitedCoordinates.size(); i++)
 	{
 		glm::mat4 model = glm::mat4(1.0f);
-		model = glm::translate(model, jR.mVisitedCoordinates[i].coords);
+		model = glm::translate(model, camera.GetRelativePosition(jR.mVisitedCoordinates[i].coords * MAP_SCALE));
 		model = glm::scale(model, glm::vec3(0.05f, 0.05f, 0.05f));
 		shader.setMat4("model", model);
 		loadedModel.Draw(shader);
 	}*/
 
 	glm::mat4 model = glm::mat4(1.0f);
-	model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f));
+	model = glm::translate(model, camera.GetRelativePosition(glm::dvec3(0.0, 0.0, 0.0)));
 	model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
 	shader.setMat4("model", model);
 	genericStarModel.Draw(shader);
 }
 
-void drawOutputToTexture(glm::vec4 backgroundColor, Shader shader, Shader screenShader, JournalReader jR, unsigned int framebuffer, unsigned int textColorBuffer, unsigned int quadVAO)
+void drawOutputToTexture(glm::vec4 backgroundColor, Shader shader, Shader screenShader, JournalReader& jR, int sceneTarget, unsigned int quadVAO)
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-	glEnable(GL_DEPTH_TEST);
+	renderTargets.Bind(sceneTarget);
+	glState.Enable(GL_DEPTH_TEST);
 
 	glClearColor(backgroundColor.x, backgroundColor.y, backgroundColor.z, backgroundColor.w);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	shader.use();
 
-	glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SRC_WIDTH / (float)SRC_HEIGHT, 0.1f, 500.0f);
+	glm::mat4 projection = camera.GetProjectionMatrix((float)renderTargets.GetWidth() / (float)renderTargets.GetHeight());
 	glm::mat4 view = camera.GetViewMatrix();
 	shader.setMat4("projection", projection);
 	shader.setMat4("view", view);
 
-	for (unsigned int i = 0; i < jR.mVisitedCoordinates.size(); i++)
+	if (clusteredLights)
 	{
-		glm::mat4 model = glm::mat4(1.0f);
-		model = glm::translate(model, jR.mVisitedCoordinates[i].coords);
-		model = glm::scale(model, glm::vec3(0.05f, 0.05f, 0.05f));
-		shader.setMat4("model", model);
-		drawCorrectStarModel(jR.mVisitedCoordinates[i], shader);
+		updateStarLights(jR.mVisitedCoordinates, view, projection);
+		clusteredLights->Bind(shader, renderTargets.GetWidth(), renderTargets.GetHeight());
+		clusteredLights->Bind(*starBatchShader, renderTargets.GetWidth(), renderTargets.GetHeight());
+	}
+
+	if (starCuller)
+	{
+		starCuller->Cull(camera.Position / MAP_SCALE, MAP_SCALE, view, projection, renderTargets.GetHeight());
+
+		starCullerShader->use();
+		starCullerShader->setMat4("projection", projection);
+		starCullerShader->setMat4("view", view);
+		starCuller->Draw(*starCullerShader);
+
+		if (starImpostorShader)
+		{
+			starImpostorShader->use();
+			starImpostorShader->setMat4("projection", projection);
+			starImpostorShader->setMat4("view", view);
+			starCuller->DrawImpostors(*starImpostorShader);
+		}
+	}
+	else if (starBatch)
+	{
+		starBatchShader->use();
+		starBatchShader->setMat4("projection", projection);
+		starBatchShader->setMat4("view", view);
+		starBatchShader->setFloat("time", (float)glfwGetTime());
+		starBatch->Draw(*starBatchShader, camera.Position / MAP_SCALE, MAP_SCALE);
+	}
+	else
+	{
+		drawStars(shader, jR.mVisitedCoordinates, 1);
+	}
+
+	if (galaxyStreamer)
+	{
+		galaxyShader->use();
+		galaxyShader->setMat4("projection", projection);
+		galaxyShader->setMat4("view", view);
+		galaxyShader->setFloat("pointSize", 2.0f);
+		galaxyStreamer->Draw(*galaxyShader, camera.Position / MAP_SCALE, MAP_SCALE);
+	}
+
+	if (starHlod)
+	{
+		starHlod->Update(camera.Position / MAP_SCALE, MAP_SCALE, view, projection, renderTargets.GetHeight());
+
+		starHlodPointShader->use();
+		starHlodPointShader->setMat4("projection", projection);
+		starHlodPointShader->setMat4("view", view);
+		starHlodGlowShader->use();
+		starHlodGlowShader->setMat4("projection", projection);
+		starHlodGlowShader->setMat4("view", view);
+		starHlod->Draw(*starHlodPointShader, *starHlodGlowShader);
+	}
+
+	glm::vec2 viewport = glm::vec2(renderTargets.GetWidth(), renderTargets.GetHeight());
+
+	if (routeLine)
+	{
+		routeShader->use();
+		routeShader->setMat4("projection", projection);
+		routeShader->setMat4("view", view);
+		routeLine->Draw(*routeShader, camera.Position / MAP_SCALE, MAP_SCALE, viewport);
+	}
+
+	if (travelPath)
+	{
+		size_t jumps = playback ? playback->GetJumps() : (size_t)-1;
+		float progress = playback ? (float)playback->GetJumpProgress() : 1.0f;
+
+		travelPathShader->use();
+		travelPathShader->setMat4("projection", projection);
+		travelPathShader->setMat4("view", view);
+		travelPath->Draw(*travelPathShader, camera.Position / MAP_SCALE, MAP_SCALE, viewport, jumps, progress);
 	}
 
 	/*glm::mat4 model = glm::mat4(1.0f);
@@ -249,17 +913,589 @@ void drawOutputToTexture(glm::vec4 backgroundColor, Shader shader, Shader screen
 	shader.setMat4("model", model);
 	classASpotsModel.Draw(shader);*/
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	glDisable(GL_DEPTH_TEST);
+	unsigned int bloomTexture = bloom->Apply(sceneTarget, quadVAO);
+
+	renderTargets.BindDefault();
+	glState.Disable(GL_DEPTH_TEST);
 
 	glClearColor(1.0f, 1.0f, 1.0f, 1.0f); // set clear color to white (not really necessary actually, since we won't be able to see behind the quad anyways)
 	glClear(GL_COLOR_BUFFER_BIT);
 
 	screenShader.use();
-	glBindVertexArray(quadVAO);
-	glBindTexture(GL_TEXTURE_2D, textColorBuffer);
+	screenShader.setFloat("bloomIntensity", bloom->intensity);
+	glState.BindVertexArray(quadVAO);
+	glState.BindTexture(0, GL_TEXTURE_2D, renderTargets.Get(sceneTarget).colorTexture);
+	glState.BindTexture(1, GL_TEXTURE_2D, bloomTexture);
 	glDrawArrays(GL_TRIANGLES, 0, 6);
 
+	// over the tone mapped image, text should neither bloom nor shift with exposure
+	if (systemLabels)
+	{
+		systemLabels->Layout(camera.Position / MAP_SCALE, MAP_SCALE, view, projection, renderTargets.GetWidth(), renderTargets.GetHeight());
+		systemLabels->Draw(*textShader);
+	}
+
+	if (statsOverlay)
+		statsOverlay->Draw(*overlayShader, renderTargets.GetWidth(), renderTargets.GetHeight());
+}
+
+// Renders both eyes from one traversal of the star list. With singlePass off every eye gets its
+// own traversal, which is only kept around to compare against in benchmarkStereo.
+void drawStereoOutput(glm::vec4 backgroundColor, Shader& shader, JournalReader& jR, StereoRenderTarget& target, OpenVRPart& vrPart, bool singlePass)
+{
+	glm::mat4 view = camera.GetViewMatrix();
+	glm::mat4 viewProjection[2];
+	viewProjection[0] = reversedInfiniteZ(vrPart.GetEyeProjection(vr::Eye_Left, NEAR_PLANE, 1.0f), NEAR_PLANE) * vrPart.GetEyeView(vr::Eye_Left, view);
+	viewProjection[1] = reversedInfiniteZ(vrPart.GetEyeProjection(vr::Eye_Right, NEAR_PLANE, 1.0f), NEAR_PLANE) * vrPart.GetEyeView(vr::Eye_Right, view);
+
+	target.Bind();
+	glState.Enable(GL_DEPTH_TEST);
+
+	glClearColor(backgroundColor.x, backgroundColor.y, backgroundColor.z, backgroundColor.w);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	shader.use();
+	target.SetEyeMatrices(shader, viewProjection);
+
+	if (singlePass || target.mode == STEREO_MULTIVIEW)
+	{
+		drawStars(shader, jR.mVisitedCoordinates, target.GetInstanceCount());
+	}
+	else
+	{
+		for (int eye = 0; eye < 2; eye++)
+		{
+			shader.setInt("firstEye", eye);
+			drawStars(shader, jR.mVisitedCoordinates, 1);
+		}
+	}
+
+	target.Unbind();
+	renderTargets.BindDefault();
+
+	if (target.mode == STEREO_MULTIVIEW)
+		vrPart.submitLayered(target.colorTexture);
+	else
+		vrPart.submitSideBySide(target.colorTexture);
+}
+
+void benchmarkStereo(Shader& shader, JournalReader& jR, StereoRenderTarget& target, OpenVRPart& vrPart, unsigned int frames)
+{
+	cout << "Stereo benchmark: " << jR.mVisitedCoordinates.size() << " stars, " << frames << " frames" << endl;
+
+	// runs before the frame loop, setup may have bound things directly
+	glState.Invalidate();
+
+	for (int singlePass = 1; singlePass >= 0; singlePass--)
+	{
+		if (!singlePass && target.mode == STEREO_MULTIVIEW)
+			continue;
+
+		glFinish();
+		double start = glfwGetTime();
+
+		for (unsigned int i = 0; i < frames; i++)
+			drawStereoOutput(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), shader, jR, target, vrPart, singlePass);
+
+		double submitted = glfwGetTime();
+		glFinish();
+		double finished = glfwGetTime();
+
+		cout << (singlePass ? "  single-pass: " : "  two-pass:    ") << (submitted - start) * 1000.0 / frames << " ms CPU/frame, "
+			<< (finished - start) * 1000.0 / frames << " ms incl. GPU" << endl;
+	}
+}
+
+// Source order vs. every optimizer pass, measured with the FIFO cache simulator. Runs before
+// any window or context exists.
+void benchmarkMeshOptimizer()
+{
+	const char* paths[] = {
+		"resources/models/stars/generic_star/star.obj",
+		"resources/models/stars/a_with_spots/a_with_spots.obj",
+		"resources/models/stars/wolf_rayet/wolf_rayet.obj"
+	};
+
+	for (const char* path : paths)
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+
+		if (Model::ReadGeometry(path, vertices, indices))
+			MeshOptimizer::Benchmark(vertices, indices, path);
+	}
+
+	// a large mesh in the worst possible order, to see the passes at scale
+	const unsigned int size = 256;
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+
+	for (unsigned int y = 0; y <= size; y++)
+	{
+		for (unsigned int x = 0; x <= size; x++)
+		{
+			Vertex v = {};
+			v.Position = glm::vec3((float)x, (float)y, 0.0f);
+			v.Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+			vertices.push_back(v);
+		}
+	}
+
+	std::vector<unsigned int> quads;
+
+	for (unsigned int i = 0; i < size * size; i++)
+		quads.push_back((i * 40503u) % (size * size));	// every quad once, scattered
+
+	for (unsigned int q : quads)
+	{
+		unsigned int a = (q / size) * (size + 1) + q % size;
+		unsigned int b = a + size + 1;
+		indices.insert(indices.end(), { a, a + 1, b, a + 1, b + 1, b });
+	}
+
+	MeshOptimizer::Benchmark(vertices, indices, "scattered grid");
+}
+
+// Fewest-jump routes between random systems at most 5000 ly apart, exact and weighted, with and
+// without neutron boost. Without a snapshot the systems are a synthetic exponential disk with 1%
+// neutron stars, about as dense around the core as the populated parts of a full dump.
+void benchmarkRoutePlanner(size_t syntheticCount, unsigned int pairs)
+{
+	StarStore store;
+	uint32_t random = 12345u;
+	auto uniform = [&random]() {
+		random = random * 1664525u + 1013904223u;
+		return (random >> 8) * (1.0 / 16777216.0) + 0.5 / 16777216.0;
+	};
+
+	if (!fs::exists(GALAXY_SNAPSHOT) || !store.Load(GALAXY_SNAPSHOT))
+	{
+		store.stars.reserve(syntheticCount);
+
+		for (size_t i = 0; i < syntheticCount; i++)
+		{
+			double radius = -2500.0 * std::log(uniform());
+			double angle = 6.283185307 * uniform();
+			double height = 300.0 * std::sqrt(-2.0 * std::log(uniform())) * std::cos(6.283185307 * uniform());
+			uint8_t flags = uniform() < 0.01 ? STAR_NEUTRON : 0;
+			store.Add(glm::dvec3(radius * std::cos(angle), height, radius * std::sin(angle)), "", StarClass::GENERIC, flags);
+		}
+	}
+
+	cout << "Route planner benchmark: " << store.Size() << " systems, " << JUMP_RANGE << " ly jumps, " << pairs << " routes per setting" << endl;
+
+	RoutePlanner planner(store);
+	planner.Prepare(JUMP_RANGE);
+
+	std::vector<std::pair<uint32_t, uint32_t>> routes;
+
+	while (routes.size() < pairs)
+	{
+		uint32_t start = (uint32_t)(uniform() * store.Size());
+		uint32_t goal = (uint32_t)(uniform() * store.Size());
+
+		if (glm::length(store.GetPosition(start) - store.GetPosition(goal)) <= 5000.0)
+			routes.push_back(std::make_pair(start, goal));
+	}
+
+	const float weights[] = { 1.0f, 1.25f };
+
+	for (int boost = 0; boost < 2; boost++)
+	{
+		for (float weight : weights)
+		{
+			RouteOptions options;
+			options.jumpRange = JUMP_RANGE;
+			options.neutronBoost = boost != 0;
+			options.heuristicWeight = weight;
+
+			double total = 0.0, worst = 0.0;
+			size_t jumps = 0, expanded = 0, found = 0;
+
+			for (const std::pair<uint32_t, uint32_t>& r : routes)
+			{
+				Route route = planner.Plan(r.first, r.second, options);
+				total += route.milliseconds;
+				worst = std::max(worst, route.milliseconds);
+				jumps += route.Jumps();
+				expanded += route.expanded;
+				found += route.Found();
+			}
+
+			cout << "  " << (boost ? "neutron boost" : "no boost") << ", weight " << weight << ": " << total / routes.size() << " ms mean, " << worst << " ms worst, "
+				<< found << "/" << routes.size() << " found, " << (double)jumps / std::max(found, (size_t)1) << " jumps, " << expanded / routes.size() << " systems searched" << endl;
+		}
+	}
+}
+
+// Journal lines of a made-up commander, a few seconds to a minute apart: jumps, scans, trade,
+// docking and missions. Ingest time includes parsing the JSON; every query is the best of five.
+void benchmarkEventStore(size_t eventCount)
+{
+	const char* goods[] = { "Gold", "Silver", "Painite", "Tritium", "Palladium" };
+	const char* factions[] = { "Alliance Office", "Sirius Corp", "Mother Gaia", "Pilots Federation" };
+
+	EventStore store;
+	uint32_t random = 12345u;
+	auto next = [&random]() {
+		random = random * 1664525u + 1013904223u;
+		return random >> 8;
+	};
+
+	int64_t timestamp = 1483228800;	// 2017
+	int system = 0;
+	char line[512];
+
+	double begin = glfwGetTime();
+
+	for (size_t i = 0; i < eventCount; i++)
+	{
+		timestamp += next() % 90;
+		std::string time = JumpHistory::FormatTimestamp(timestamp);
+		unsigned int kind = next() % 100;
+
+		if (kind < 30)
+		{
+			system = next() % 200000;
+			snprintf(line, sizeof(line), "{ \"timestamp\":\"%s\", \"event\":\"FSDJump\", \"StarSystem\":\"Synthetic %d\", \"StarPos\":[1.0,2.0,3.0], \"JumpDist\":%.2f, \"FuelUsed\":%.3f }", time.c_str(), system, (next() % 5000) / 100.0, (next() % 800) / 100.0);
+		}
+		else if (kind < 70)
+			snprintf(line, sizeof(line), "{ \"timestamp\":\"%s\", \"event\":\"Scan\", \"ScanType\":\"Detailed\", \"BodyName\":\"Synthetic %d %c\", \"DistanceFromArrivalLS\":%.1f, \"WasDiscovered\":%s }", time.c_str(), system, 'A' + next() % 8, (next() % 200000) / 10.0, next() % 2 ? "true" : "false");
+		else if (kind < 80)
+			snprintf(line, sizeof(line), "{ \"timestamp\":\"%s\", \"event\":\"MarketSell\", \"Type\":\"%s\", \"Count\":%u, \"SellPrice\":%u, \"TotalSale\":%u }", time.c_str(), goods[next() % 5], next() % 700, next() % 60000, next() % 40000000);
+		else if (kind < 90)
+			snprintf(line, sizeof(line), "{ \"timestamp\":\"%s\", \"event\":\"Docked\", \"StationName\":\"Port %d\", \"StationType\":\"Coriolis\" }", time.c_str(), system % 5000);
+		else
+			snprintf(line, sizeof(line), "{ \"timestamp\":\"%s\", \"event\":\"MissionCompleted\", \"Faction\":\"%s\", \"Reward\":%u }", time.c_str(), factions[next() % 4], next() % 5000000);
+
+		store.Ingest(line);
+	}
+
+	double ingest = (glfwGetTime() - begin) * 1000.0;
+	cout << "Event store benchmark: " << store.Size() << " events ingested in " << ingest << " ms, " << store.GetColumnBytes() / 1048576.0 << " MB of columns" << endl;
+
+	auto time = [](const char* name, auto query) {
+		double best = 1e300;
+		size_t result = 0;
+
+		for (int run = 0; run < 5; run++)
+		{
+			double start = glfwGetTime();
+			result = query();
+			best = std::min(best, (glfwGetTime() - start) * 1000.0);
+		}
+
+		cout << "  " << name << ": " << best << " ms, " << result << " rows / groups" << endl;
+	};
+
+	time("events per type", [&]() { return store.Query().GroupBy(EVENT_GROUP_TYPE).Aggregate().size(); });
+	time("sales per day", [&]() { return store.Query().Type("MarketSell").GroupBy(EVENT_GROUP_DAY).Aggregate("TotalSale").size(); });
+	time("jump distance per system", [&]() { return store.Query().Type("FSDJump").GroupBy(EVENT_GROUP_SYSTEM).Aggregate("JumpDist").size(); });
+	time("scans beyond 10000 ls", [&]() { return store.Query().Type("Scan").Where("DistanceFromArrivalLS", 10000.0, 1e300).Count(); });
+	time("mission rewards per faction", [&]() { return store.Query().Type("MissionCompleted").GroupBy(EVENT_GROUP_FIELD, "Faction").Aggregate("Reward").size(); });
+	time("gold sold in 2018", [&]() { return store.Query().Type("MarketSell").Between(1514764800, 1546300800).Where("Type", "Gold").Count(); });
+}
+
+// A made-up commander jumping every few minutes between a tenth as many systems as jumps, spread
+// over the galaxy. Times the whole history folded in at once on all threads and on one, then a
+// LIVE_JOURNAL poll's worth of new jumps folded in on top.
+void benchmarkExplorationStats(size_t jumpCount)
+{
+	size_t systemCount = std::max(jumpCount / 10, (size_t)1);
+	std::vector<std::string> names(systemCount);
+	std::vector<glm::dvec3> positions(systemCount);
+	uint32_t random = 12345u;
+	auto next = [&random]() {
+		random = random * 1664525u + 1013904223u;
+		return random >> 8;
+	};
+
+	for (size_t i = 0; i < systemCount; i++)
+	{
+		names[i] = "Synthetic " + std::to_string(i);
+		positions[i] = glm::dvec3((int)(next() % 90000) - 45000.0, (int)(next() % 4000) - 2000.0, (int)(next() % 90000) - 20000.0);
+	}
+
+	JumpHistory history;
+	std::vector<Coordinate> visited;
+	int64_t timestamp = 1483228800;	// 2017
+
+	for (size_t i = 0; i < jumpCount; i++)
+	{
+		size_t system = next() % systemCount;
+		timestamp += next() % 300;
+
+		if (history.FindSystem(names[system]) == JUMP_HISTORY_NONE)
+		{
+			Coordinate c;
+			c.name = names[system];
+			c.starClass = (StarClass)(next() % STATS_CLASS_COUNT);
+			c.coords = positions[system];
+			visited.push_back(c);
+		}
+
+		history.Append(timestamp, names[system], positions[system]);
+	}
+
+	cout << "Exploration statistics benchmark: " << history.GetJumpCount() << " jumps to " << history.GetSystemCount() << " systems" << endl;
+
+	unsigned int threadCounts[] = { std::max(1u, std::thread::hardware_concurrency()), 1u };
+
+	for (unsigned int threads : threadCounts)
+	{
+		ExplorationStats stats;
+		stats.threadCount = threads;
+
+		double start = glfwGetTime();
+		stats.Update(history, visited);
+		double elapsed = glfwGetTime() - start;
+
+		cout << "  " << threads << " threads: " << elapsed * 1000.0 << " ms, " << stats.Summary() << ", " << stats.GetActiveDays() << " active days" << endl;
+	}
+
+	ExplorationStats stats;
+	stats.Update(history, visited);
+
+	for (int i = 0; i < 100; i++)
+	{
+		size_t system = next() % systemCount;
+		timestamp += 60;
+		history.Append(timestamp, names[system], positions[system]);
+	}
+
+	double start = glfwGetTime();
+	stats.Update(history, visited);
+	double elapsed = glfwGetTime() - start;
+
+	cout << "  100 new jumps: " << elapsed * 1000.0 << " ms" << endl;
+
+	start = glfwGetTime();
+	stats.WriteJson(STATS_JSON_PATH);
+	elapsed = glfwGetTime() - start;
+
+	cout << "  JSON dump: " << elapsed * 1000.0 << " ms" << endl;
+}
+
+// StarBatch star of a galaxyStars star, (size_t)-1 unless it is a visited system
+size_t pickToBatch(size_t pick)
+{
+	auto it = galaxyBatch.find((uint32_t)pick);
+	return it == galaxyBatch.end() ? (size_t)-1 : it->second;
+}
+
+// galaxyStars index of a visited system, STAR_PICK_NONE if it is not one
+size_t findPickStar(const JournalReader& jR, const std::string& name)
+{
+	const std::vector<Coordinate>& visited = jR.mVisitedCoordinates;
+	size_t batch = std::find_if(visited.begin(), visited.end(), [&name](const Coordinate& c) { return c.name == name; }) - visited.begin();
+
+	return batch < batchGalaxy.size() ? batchGalaxy[batch] : STAR_PICK_NONE;
+}
+
+// batchGalaxy and galaxyBatch for the StarBatch stars not mapped yet. A visited system the galaxy
+// already has, matched by position and name, is flagged visited there, one it does not have is
+// added. With located, mapping stops at the first system whose FSDJump has not been read, it
+// has no coordinates yet.
+void mapVisitedStars(const JournalReader& jR, bool located)
+{
+	const std::vector<Coordinate>& visited = jR.mVisitedCoordinates;
+
+	for (size_t batch = batchGalaxy.size(); batch < visited.size(); batch++)
+	{
+		const Coordinate& c = visited[batch];
+
+		if (located && jR.mJumpHistory.FindSystem(c.name) == JUMP_HISTORY_NONE)
+			break;
+
+		uint32_t star = galaxyGrid->Find(galaxyStars, c.coords, c.name);
+
+		if (star == STAR_GRID_NONE)
+		{
+			star = (uint32_t)galaxyStars.Size();
+			galaxyStars.Add(c.coords, c.name, c.starClass, STAR_VISITED);
+			galaxyGrid->Append(galaxyStars, star);
+		}
+		else
+			galaxyStars.stars[star].flags |= STAR_VISITED;
+
+		batchGalaxy.push_back(star);
+		galaxyBatch[star] = batch;
+	}
+}
+
+// The picker and the labels over the visited systems and the NEARBY_STAR_COUNT systems nearest
+// the eye (light years), gathered again once the eye is a quarter of the way to the farthest of
+// them.
+void updateNearbyStars(const glm::dvec3& eye, bool force)
+{
+	if (!force && glm::length(eye - nearbyCenter) < nearbyRadius * 0.25)
+		return;
+
+	nearbyCenter = eye;
+	nearbyRadius = galaxyGrid->Nearest(eye, NEARBY_STAR_COUNT, nearbyStars);
+
+	// all of them, no need to ever look again
+	if (nearbyStars.size() < NEARBY_STAR_COUNT)
+		nearbyRadius = HUGE_VAL;
+
+	if (galaxyGrid->NeedsRebuild())
+		galaxyGrid->Build(galaxyStars, GALAXY_GRID_CELL);
+
+	std::vector<uint32_t> members(batchGalaxy);
+
+	for (uint32_t star : nearbyStars)
+		if (galaxyBatch.find(star) == galaxyBatch.end())
+			members.push_back(star);
+
+	if (starPicker)
+		starPicker->Build(galaxyStars, members);
+
+	// visited systems win over their unvisited neighbours out to four times the distance
+	if (systemLabels)
+	{
+		systemLabels->Clear();
+
+		for (uint32_t star : members)
+			systemLabels->Add(galaxyStars.GetPosition(star), galaxyStars.GetName(star), galaxyStars.IsVisited(star) ? 4.0f : 1.0f);
+	}
+}
+
+// historyBatchStars for the whole history, and the systems playback has not reached hidden.
+// StarBatch stars are in mVisitedCoordinates order.
+void mapHistoryStars(const JournalReader& jR)
+{
+	const JumpHistory& history = jR.mJumpHistory;
+	std::unordered_map<std::string, size_t> visitedIndex;
+
+	for (size_t i = 0; i < jR.mVisitedCoordinates.size(); i++)
+		visitedIndex[jR.mVisitedCoordinates[i].name] = i;
+
+	historyBatchStars.assign(history.GetSystemCount(), (size_t)-1);
+
+	for (uint32_t system = 0; system < history.GetSystemCount(); system++)
+	{
+		auto it = visitedIndex.find(history.GetName(system));
+
+		if (it != visitedIndex.end())
+		{
+			historyBatchStars[system] = it->second;
+			starBatch->SetScale(it->second, system < playback->GetVisibleSystems() ? VISITED_STAR_SCALE : 0.0f);
+		}
+	}
+}
+
+// Systems first reached since the last call (LIVE_JOURNAL) into the picker, the route planner and
+// the labels. They come from the jump history rather than mVisitedCoordinates, whose newest
+// system has no coordinates until its FSDJump is read. Each goes into the picker and the labels
+// on its own, nothing is built again; one already near the camera is in both.
+void addLiveSystems(const JournalReader& jR)
+{
+	const JumpHistory& history = jR.mJumpHistory;
+	size_t first = liveSystems;
+	liveSystems = history.GetSystemCount();
+
+	if (first == liveSystems || !galaxyGrid)
+		return;
+
+	// the route planner takes the systems the store gained on its own
+	size_t mapped = batchGalaxy.size();
+	mapVisitedStars(jR, true);
+
+	for (size_t batch = mapped; batch < batchGalaxy.size(); batch++)
+	{
+		uint32_t star = batchGalaxy[batch];
+
+		if (std::find(nearbyStars.begin(), nearbyStars.end(), star) != nearbyStars.end())
+			continue;
+
+		if (starPicker)
+			starPicker->Append(galaxyStars, star);
+
+		if (systemLabels)
+			systemLabels->Add(galaxyStars.GetPosition(star), galaxyStars.GetName(star), 4.0f);
+	}
+}
+
+// Upload cost of the star instances per frame: everything rewritten, a contiguous 1% (a
+// filter toggling one region), a scattered 1% (twinkling, selections) and nothing, against
+// re-sending the whole array with glBufferSubData as the per-frame rebuild used to.
+void benchmarkInstanceRing(size_t starCount, unsigned int frames)
+{
+	cout << "Instance ring benchmark: " << starCount << " stars, " << sizeof(StarBatchInstance) << " bytes each, " << frames << " frames, "
+		<< (UseDirectStateAccess() ? "persistent mapping" : "glBufferSubData") << endl;
+
+	InstanceRing ring(sizeof(StarBatchInstance));
+	ring.Resize(starCount);
+
+	for (size_t i = 0; i < starCount; i++)
+	{
+		StarBatchInstance instance = { (float)(i % 1000), (float)(i / 1000), 0.0f, 0.05f, 0.0f, 0.0f, 0.0f, 0 };
+		std::memcpy(ring.Edit(i), &instance, sizeof(instance));
+	}
+
+	for (int i = 0; i < INSTANCE_RING_REGIONS; i++)
+	{
+		ring.Commit();
+		ring.Fence();
+	}
+
+	const char* names[] = { "full rewrite", "1% contiguous", "1% scattered", "unchanged" };
+	size_t edits = starCount / 100;
+	uint32_t random = 12345;
+
+	for (int mode = 0; mode < 4; mode++)
+	{
+		size_t bytes = 0;
+		unsigned int waitsBefore = ring.GetWaits();
+
+		glFinish();
+		double start = glfwGetTime();
+
+		for (unsigned int frame = 0; frame < frames; frame++)
+		{
+			if (mode == 0)
+				ring.MarkAllDirty();
+			else if (mode == 1)
+				ring.Edit((frame * edits) % (starCount - edits), edits);
+			else if (mode == 2)
+			{
+				for (size_t i = 0; i < edits; i++)
+				{
+					random = random * 1664525u + 1013904223u;
+					((StarBatchInstance*)ring.Edit(random % starCount))->scale = 0.05f;
+				}
+			}
+
+			ring.Commit();
+			ring.Fence();
+			bytes += ring.GetCommittedBytes();
+		}
+
+		glFinish();
+		double elapsed = glfwGetTime() - start;
+
+		cout << "  " << names[mode] << ": " << elapsed * 1000.0 / frames << " ms/frame, " << bytes / (double)frames / (1 << 20) << " MB/frame, "
+			<< bytes / elapsed / (1 << 30) << " GB/s, " << ring.GetWaits() - waitsBefore << " fence waits" << endl;
+	}
+
+	// the old path: the whole array every frame into one buffer
+	std::vector<StarBatchInstance> instances(starCount);
+	GLuint buffer = CreateBuffer(starCount * sizeof(StarBatchInstance), NULL, GL_DYNAMIC_STORAGE_BIT);
+
+	glFinish();
+	double start = glfwGetTime();
+
+	for (unsigned int frame = 0; frame < frames; frame++)
+		UpdateBuffer(buffer, 0, instances.size() * sizeof(StarBatchInstance), instances.data());
+
+	glFinish();
+	double elapsed = glfwGetTime() - start;
+	size_t bytes = instances.size() * sizeof(StarBatchInstance) * (size_t)frames;
+
+	cout << "  glBufferSubData: " << elapsed * 1000.0 / frames << " ms/frame, " << bytes / (double)frames / (1 << 20) << " MB/frame, "
+		<< bytes / elapsed / (1 << 30) << " GB/s" << endl;
+
+	glDeleteBuffers(1, &buffer);
 }
 
 void processInput(GLFWwindow* window)
@@ -291,6 +1527,11 @@ void processInput(GLFWwindow* window)
 		camera.ProcessKeyboard(UP, deltaTime);
 	if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS)
 		camera.ProcessKeyboard(DOWN, deltaTime);
+
+	if (playback && glfwGetKey(window, GLFW_KEY_LEFT_BRACKET) == GLFW_PRESS)
+		playback->Scrub(-HISTORY_SCRUB_SPEED * deltaTime);
+	if (playback && glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS)
+		playback->Scrub(HISTORY_SCRUB_SPEED * deltaTime);
 }
 
 static void error_callback(int error, const char* description)
@@ -301,10 +1542,13 @@ static void error_callback(int error, const char* description)
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
 	glViewport(0, 0, width, height);
+	renderTargets.Resize(width, height);
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 {
+	if (freeCursor)
+		return;
 
 	if (firstMouse)
 	{
@@ -327,6 +1571,35 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 	camera.ProcessMouseScroll(yoffset);
 }
 
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+	if (action != GLFW_PRESS)
+		return;
+
+	if (button == GLFW_MOUSE_BUTTON_RIGHT)
+	{
+		// back to turning the camera without a jump from wherever the cursor went
+		freeCursor = !freeCursor;
+		firstMouse = true;
+		glfwSetInputMode(window, GLFW_CURSOR, freeCursor ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED);
+	}
+	else if (button == GLFW_MOUSE_BUTTON_LEFT && starPicker)
+	{
+		starPicker->Select();
+	}
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	if (action != GLFW_PRESS)
+		return;
+
+	if (key == GLFW_KEY_P && playback)
+		playback->Toggle();
+	if (key == GLFW_KEY_J && explorationStats && explorationStats->WriteJson(STATS_JSON_PATH))
+		std::cout << "Exploration statistics written to " << STATS_JSON_PATH << std::endl;
+}
+
 unsigned int loadTexture(char const* path)
 {
 	unsigned int textureID;
@@ -366,24 +1639,64 @@ unsigned int loadTexture(char const* path)
 	return textureID;
 }
 
-void drawCorrectStarModel(Coordinate c, Shader shader)
+// positions are subtracted from the camera in double precision, only the small
+// camera-relative offset reaches the GPU as float. Stars of one class end up next to each
+// other in the queue and share their mesh and texture binds.
+void drawStars(Shader& shader, std::vector<Coordinate>& coordinates, unsigned int instanceCount)
+{
+	for (unsigned int i = 0; i < coordinates.size(); i++)
+	{
+		glm::mat4 model = glm::mat4(1.0f);
+		model = glm::translate(model, camera.GetRelativePosition(coordinates[i].coords * MAP_SCALE));
+		model = glm::scale(model, glm::vec3(0.05f, 0.05f, 0.05f));
+		renderQueue.Submit(shader, correctStarModel(coordinates[i].starClass), model, instanceCount);
+	}
+
+	renderQueue.Flush();
+}
+
+// every visited star is a light in its class colour, ClusteredLights keeps the nearest ones
+void updateStarLights(std::vector<Coordinate>& coordinates, const glm::mat4& view, const glm::mat4& projection)
 {
-	switch (c.starClass)
+	if (starLightsChanged)
 	{
-		case StarClass::O: classOModel.Draw(shader); break;
-		case StarClass::B: classBModel.Draw(shader); break;
-		case StarClass::A: 
+		starLightSources.clear();
+		starLightPositions.clear();
+
+		for (const Coordinate& star : coordinates)
 		{
-			classASpotsModel.Draw(shader); break;
+			ClusterLight light = { glm::vec3(0.0f), STAR_LIGHT_RADIUS, STAR_CLASS_COLORS[star.starClass] * STAR_LIGHT_INTENSITY };
+			starLightSources.push_back(light);
+			starLightPositions.push_back(star.coords * MAP_SCALE);
 		}
-		case StarClass::F: classFModel.Draw(shader); break;
-		case StarClass::G: classGModel.Draw(shader); break;
-		case StarClass::K: classKModel.Draw(shader); break;
-		case StarClass::L: classLModel.Draw(shader); break;
-		case StarClass::M: classMModel.Draw(shader); break;
-		case StarClass::T: classTModel.Draw(shader); break;
-		case StarClass::Y: classYModel.Draw(shader); break;
-		case StarClass::D: wolfRayetModel.Draw(shader); break;
-		case StarClass::GENERIC: classASpotsModel.Draw(shader); break;
+
+		starLightsChanged = false;
+	}
+
+	// Update() drops and reorders the lights it is given, so it gets a fresh copy
+	starLights.assign(starLightSources.begin(), starLightSources.end());
+
+	for (size_t i = 0; i < starLights.size(); i++)
+		starLights[i].position = camera.GetRelativePosition(starLightPositions[i]);
+
+	clusteredLights->Update(starLights, view, projection);
+}
+
+Model& correctStarModel(StarClass starClass)
+{
+	switch (starClass)
+	{
+		case StarClass::O: return classOModel;
+		case StarClass::B: return classBModel;
+		case StarClass::A: return classASpotsModel;
+		case StarClass::F: return classFModel;
+		case StarClass::G: return classGModel;
+		case StarClass::K: return classKModel;
+		case StarClass::L: return classLModel;
+		case StarClass::M: return classMModel;
+		case StarClass::T: return classTModel;
+		case StarClass::Y: return classYModel;
+		case StarClass::D: return wolfRayetModel;
+		default: return classASpotsModel;
 	}
 }
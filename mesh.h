@@ -7,20 +7,14 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "shader.h"
+#include "gl_state.h"
+#include "vertex_format.h"
 
 #include <vector>
 #include <string>
 
 using namespace std;
 
-struct Vertex {
-	glm::vec3 Position;
-	glm::vec3 Normal;
-	glm::vec2 TexCoords;
-	glm::vec3 Tangent;
-	glm::vec3 Bitangent;
-};
-
 struct Texture {
 	unsigned int id;
 	string type;
@@ -33,25 +27,72 @@ public:
 	vector<unsigned int>	indices;
 	vector<Texture>		textures;
 	unsigned int VAO;
+	glm::mat4 dequantize;		// compact positions back to model space, identity for the float layout
+	unsigned int vertexBytes;	// GPU size of one vertex
 
-	Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+	// attributes: what the shaders drawing this mesh read (see ReflectVertexAttributes). VERTEX_ALL
+	// keeps the full float layout, anything else is packed into VertexFormat::Compact.
+	Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, unsigned int attributes = VERTEX_ALL)
 	{
 		this->vertices = vertices;
 		this->indices = indices;
 		this->textures = textures;
+		this->samplerProgram = 0;
+		this->dequantizeLocation = -1;
 
-		setupMesh();
+		setupSamplerNames();
+
+		if (attributes == VERTEX_ALL)
+			setupMesh();
+		else
+			setupCompactMesh(attributes);
 	}
-	void Draw(Shader &shader)
+	// state goes through glState, so a run of draws with the same mesh or the same textures
+	// only binds them once
+	void Draw(Shader &shader, unsigned int instanceCount = 1)
+	{
+		// uniform locations only change with the program
+		if (shader.ID != samplerProgram)
+		{
+			samplerProgram = shader.ID;
+			samplerLocations.clear();
+
+			for (const string& name : samplerNames)
+				samplerLocations.push_back(glGetUniformLocation(shader.ID, name.c_str()));
+
+			dequantizeLocation = glGetUniformLocation(shader.ID, "meshDequantize");
+		}
+
+		for (unsigned int i = 0; i < textures.size(); i++)
+		{
+			glState.Uniform1i(shader.ID, samplerLocations[i], i);
+			glState.BindTexture(i, GL_TEXTURE_2D, textures[i].id);
+		}
+
+		glUniformMatrix4fv(dequantizeLocation, 1, GL_FALSE, &dequantize[0][0]);
+
+		glState.BindVertexArray(VAO);
+		if (instanceCount == 1)
+			glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+		else
+			glDrawElementsInstanced(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0, instanceCount);
+	}
+private:
+	unsigned int VBO, EBO;
+	vector<string> samplerNames;	// texture_diffuse1, texture_specular1, ... in texture order
+	vector<GLint> samplerLocations;
+	GLint dequantizeLocation;
+	unsigned int samplerProgram;		// the locations are of this program
+
+	void setupSamplerNames()
 	{
 		unsigned int diffuseNr	= 1;
 		unsigned int specularNr = 1;
 		unsigned int normalNr	= 1;
 		unsigned int heightNr	= 1;
-		
+
 		for (unsigned int i = 0; i < textures.size(); i++)
 		{
-			glActiveTexture(GL_TEXTURE0 + i);
 			string number;
 			string name = textures[i].type;
 
@@ -64,48 +105,40 @@ public:
 			else if (name == "texture_height")
 				number = to_string(heightNr++);
 
-			glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-			//shader.setFloat(("material." + name + number).c_str(), i);
-			glBindTexture(GL_TEXTURE_2D, textures[i].id);
-		 }
-
-		glBindVertexArray(VAO);
-		glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-		glBindVertexArray(0);
+			samplerNames.push_back(name + number);
+		}
 	}
-private:
-	unsigned int VBO, EBO;
 
 	void setupMesh()
 	{
-		glGenVertexArrays(1, &VAO);
-		glGenBuffers(1, &VBO);
-		glGenBuffers(1, &EBO);
-
-		glBindVertexArray(VAO);
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-
-		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+		dequantize = glm::mat4(1.0f);
+		vertexBytes = sizeof(Vertex);
 
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+		VBO = CreateBuffer(vertices.size() * sizeof(Vertex), vertices.data());
+		EBO = CreateBuffer(indices.size() * sizeof(unsigned int), indices.data());
 
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+		VertexArrayBuilder builder;
+		VertexFormat::SetupFloatAttributes(builder, VBO);
+		builder.Indices(EBO);
+		VAO = builder.Finish();
+	}
 
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+	void setupCompactMesh(unsigned int attributes)
+	{
+		VertexFormat format = VertexFormat::Compact(attributes, vertices.data(), vertices.size());
+		dequantize = format.dequantize;
+		vertexBytes = format.stride;
 
-		glEnableVertexAttribArray(3);
-		glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
+		vector<unsigned char> packed;
+		format.Pack(vertices.data(), vertices.size(), packed);
 
-		glEnableVertexAttribArray(4);
-		glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+		VBO = CreateBuffer(packed.size(), packed.data());
+		EBO = CreateBuffer(indices.size() * sizeof(unsigned int), indices.data());
 
-		glBindVertexArray(0);
+		VertexArrayBuilder builder;
+		format.SetupAttributes(builder, VBO);
+		builder.Indices(EBO);
+		VAO = builder.Finish();
 	}
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,445 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <glm/glm.hpp>
+
+#include "vertex_format.h"
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <iostream>
+
+// Transform cache behaviour of an index buffer, measured with a FIFO post-transform cache the
+// way most GPUs implement it. ACMR: cache misses per triangle (0.5 is the ideal for large
+// regular meshes, 3 means no reuse at all). ATVR: misses per vertex (1 is ideal).
+struct VertexCacheStats {
+	unsigned int misses;
+	float acmr;
+	float atvr;
+};
+
+// Import-time index and vertex reordering. Run on the CPU copy before it is uploaded:
+//   WeldVertices         merges bit-identical vertices (the importer emits one per face corner)
+//   OptimizeVertexCache  Forsyth's linear-speed vertex cache optimisation
+//   OptimizeOverdraw     orders the cache-friendly clusters front-facing-outward first
+//   OptimizeVertexFetch  renumbers vertices in first-use order so fetches walk memory linearly
+class MeshOptimizer
+{
+public:
+	static VertexCacheStats SimulateCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = 16)
+	{
+		std::vector<unsigned int> stamp(vertexCount, 0);
+		unsigned int time = cacheSize + 1;
+		VertexCacheStats stats = {};
+
+		for (unsigned int index : indices)
+		{
+			// in the cache while fewer than cacheSize misses happened since it was loaded
+			if (time - stamp[index] > cacheSize)
+			{
+				stamp[index] = time++;
+				stats.misses++;
+			}
+		}
+
+		size_t used = 0;
+
+		for (unsigned int s : stamp)
+			used += s != 0;
+
+		stats.acmr = indices.empty() ? 0.0f : stats.misses / (indices.size() / 3.0f);
+		stats.atvr = used == 0 ? 0.0f : stats.misses / (float)used;
+
+		return stats;
+	}
+
+	// returns the number of vertices removed
+	static size_t WeldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+	{
+		struct VertexHash {
+			size_t operator()(const Vertex& v) const
+			{
+				const unsigned char* bytes = (const unsigned char*)&v;
+				size_t h = 14695981039346656037ull;
+
+				for (size_t i = 0; i < sizeof(Vertex); i++)
+					h = (h ^ bytes[i]) * 1099511628211ull;
+
+				return h;
+			}
+		};
+
+		struct VertexEqual {
+			bool operator()(const Vertex& a, const Vertex& b) const
+			{
+				return std::memcmp(&a, &b, sizeof(Vertex)) == 0;
+			}
+		};
+
+		std::unordered_map<Vertex, unsigned int, VertexHash, VertexEqual> unique;
+		unique.reserve(vertices.size());
+
+		std::vector<unsigned int> remap(vertices.size());
+		std::vector<Vertex> welded;
+		welded.reserve(vertices.size());
+
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			auto it = unique.find(vertices[i]);
+
+			if (it == unique.end())
+			{
+				it = unique.insert(std::make_pair(vertices[i], (unsigned int)welded.size())).first;
+				welded.push_back(vertices[i]);
+			}
+
+			remap[i] = it->second;
+		}
+
+		for (unsigned int& index : indices)
+			index = remap[index];
+
+		size_t removed = vertices.size() - welded.size();
+		vertices.swap(welded);
+
+		return removed;
+	}
+
+	static void OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = 32)
+	{
+		size_t triangleCount = indices.size() / 3;
+
+		if (triangleCount == 0)
+			return;
+
+		// triangles per vertex, only the ones not emitted yet are kept at the front
+		std::vector<unsigned int> liveCount(vertexCount, 0);
+
+		for (unsigned int index : indices)
+			liveCount[index]++;
+
+		std::vector<unsigned int> firstTriangle(vertexCount + 1, 0);
+
+		for (size_t v = 0; v < vertexCount; v++)
+			firstTriangle[v + 1] = firstTriangle[v] + liveCount[v];
+
+		std::vector<unsigned int> adjacency(indices.size());
+		std::vector<unsigned int> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+
+		for (size_t t = 0; t < triangleCount; t++)
+			for (int k = 0; k < 3; k++)
+				adjacency[fill[indices[t * 3 + k]]++] = (unsigned int)t;
+
+		std::vector<int> cachePosition(vertexCount, -1);
+		std::vector<float> vertexScore(vertexCount);
+		std::vector<float> triangleScore(triangleCount, 0.0f);
+		std::vector<bool> emitted(triangleCount, false);
+
+		for (size_t v = 0; v < vertexCount; v++)
+			vertexScore[v] = forsythScore(-1, liveCount[v], cacheSize);
+
+		for (size_t t = 0; t < triangleCount; t++)
+			for (int k = 0; k < 3; k++)
+				triangleScore[t] += vertexScore[indices[t * 3 + k]];
+
+		std::vector<unsigned int> cache;
+		std::vector<unsigned int> nextCache;
+		cache.reserve(cacheSize + 3);
+		nextCache.reserve(cacheSize + 3);
+
+		std::vector<unsigned int> result;
+		result.reserve(indices.size());
+
+		size_t scanCursor = 0;
+		long long best = -1;
+
+		while (result.size() < indices.size())
+		{
+			if (best < 0)
+			{
+				// dead end: nothing in the cache has work left, take the best remaining triangle
+				float bestScore = -1.0f;
+
+				while (scanCursor < triangleCount && emitted[scanCursor])
+					scanCursor++;
+
+				for (size_t t = scanCursor; t < triangleCount; t++)
+				{
+					if (!emitted[t] && triangleScore[t] > bestScore)
+					{
+						bestScore = triangleScore[t];
+						best = (long long)t;
+					}
+				}
+			}
+
+			unsigned int triangle = (unsigned int)best;
+			emitted[triangle] = true;
+
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int v = indices[triangle * 3 + k];
+				result.push_back(v);
+
+				// move the triangle behind the live ones of this vertex
+				unsigned int* begin = &adjacency[firstTriangle[v]];
+				unsigned int* end = begin + liveCount[v];
+				unsigned int* it = std::find(begin, end, triangle);
+				std::swap(*it, *(end - 1));
+				liveCount[v]--;
+			}
+
+			// the new triangle goes to the front of the LRU cache
+			nextCache.clear();
+
+			for (int k = 0; k < 3; k++)
+				nextCache.push_back(indices[triangle * 3 + k]);
+
+			for (unsigned int v : cache)
+			{
+				if (v != nextCache[0] && v != nextCache[1] && v != nextCache[2])
+					nextCache.push_back(v);
+			}
+
+			for (size_t i = cacheSize; i < nextCache.size(); i++)
+			{
+				cachePosition[nextCache[i]] = -1;
+				updateVertex(nextCache[i], -1, cacheSize, adjacency, firstTriangle, liveCount, vertexScore, triangleScore);
+			}
+
+			if (nextCache.size() > cacheSize)
+				nextCache.resize(cacheSize);
+
+			cache.swap(nextCache);
+
+			best = -1;
+			float bestScore = -1.0f;
+
+			for (size_t i = 0; i < cache.size(); i++)
+			{
+				unsigned int v = cache[i];
+				cachePosition[v] = (int)i;
+				updateVertex(v, (int)i, cacheSize, adjacency, firstTriangle, liveCount, vertexScore, triangleScore);
+			}
+
+			for (unsigned int v : cache)
+			{
+				for (unsigned int j = 0; j < liveCount[v]; j++)
+				{
+					unsigned int t = adjacency[firstTriangle[v] + j];
+
+					if (triangleScore[t] > bestScore)
+					{
+						bestScore = triangleScore[t];
+						best = t;
+					}
+				}
+			}
+		}
+
+		indices.swap(result);
+	}
+
+	// Splits the cache-optimised order into clusters wherever the cache had to restart (all three
+	// vertices missed) and sorts the clusters so those facing away from the mesh centre come
+	// first. Those occlude the rest, so fewer fragments are shaded twice, while each cluster keeps
+	// its cache-friendly order.
+	static void OptimizeOverdraw(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, unsigned int cacheSize = 16)
+	{
+		size_t triangleCount = indices.size() / 3;
+
+		if (triangleCount == 0)
+			return;
+
+		std::vector<size_t> clusterStart;
+		std::vector<unsigned int> stamp(vertices.size(), 0);
+		unsigned int time = cacheSize + 1;
+
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			int misses = 0;
+
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int v = indices[t * 3 + k];
+
+				if (time - stamp[v] > cacheSize)
+				{
+					stamp[v] = time++;
+					misses++;
+				}
+			}
+
+			if (t == 0 || misses == 3)
+				clusterStart.push_back(t);
+		}
+
+		clusterStart.push_back(triangleCount);
+
+		glm::vec3 meshCenter(0.0f);
+		float meshArea = 0.0f;
+
+		struct Cluster {
+			size_t begin, end;
+			float sortKey;
+		};
+
+		std::vector<Cluster> clusters;
+		std::vector<glm::vec3> clusterCenters;
+		std::vector<glm::vec3> clusterNormals;
+
+		for (size_t c = 0; c + 1 < clusterStart.size(); c++)
+		{
+			glm::vec3 center(0.0f), normal(0.0f);
+			float area = 0.0f;
+
+			for (size_t t = clusterStart[c]; t < clusterStart[c + 1]; t++)
+			{
+				glm::vec3 a = vertices[indices[t * 3 + 0]].Position;
+				glm::vec3 b = vertices[indices[t * 3 + 1]].Position;
+				glm::vec3 d = vertices[indices[t * 3 + 2]].Position;
+
+				glm::vec3 n = glm::cross(b - a, d - a);
+				float triangleArea = glm::length(n) * 0.5f;
+
+				center += (a + b + d) / 3.0f * triangleArea;
+				normal += n;
+				area += triangleArea;
+			}
+
+			meshCenter += center;
+			meshArea += area;
+
+			clusters.push_back({ clusterStart[c], clusterStart[c + 1], 0.0f });
+			clusterCenters.push_back(area > 0.0f ? center / area : center);
+			clusterNormals.push_back(glm::length(normal) > 0.0f ? glm::normalize(normal) : normal);
+		}
+
+		if (meshArea > 0.0f)
+			meshCenter /= meshArea;
+
+		for (size_t c = 0; c < clusters.size(); c++)
+			clusters[c].sortKey = glm::dot(clusterCenters[c] - meshCenter, clusterNormals[c]);
+
+		std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+		std::vector<unsigned int> result;
+		result.reserve(indices.size());
+
+		for (const Cluster& cluster : clusters)
+			result.insert(result.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+
+		indices.swap(result);
+	}
+
+	// drops unreferenced vertices as a side effect
+	static void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+	{
+		std::vector<unsigned int> remap(vertices.size(), ~0u);
+		std::vector<Vertex> ordered;
+		ordered.reserve(vertices.size());
+
+		for (unsigned int& index : indices)
+		{
+			if (remap[index] == ~0u)
+			{
+				remap[index] = (unsigned int)ordered.size();
+				ordered.push_back(vertices[index]);
+			}
+
+			index = remap[index];
+		}
+
+		vertices.swap(ordered);
+	}
+
+	// all passes in order, prints the before/after numbers for name
+	static void Optimize(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, const std::string& name)
+	{
+		size_t vertexCountBefore = vertices.size();
+		VertexCacheStats before = SimulateCache(indices, vertices.size());
+
+		WeldVertices(vertices, indices);
+		OptimizeVertexCache(indices, vertices.size());
+		OptimizeOverdraw(vertices, indices);
+		OptimizeVertexFetch(vertices, indices);
+
+		VertexCacheStats after = SimulateCache(indices, vertices.size());
+
+		std::cout << name << ": " << vertexCountBefore << " -> " << vertices.size() << " vertices, ACMR " << before.acmr << " -> " << after.acmr
+			<< ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+	}
+
+	// Cache behaviour of every pass at several cache sizes plus timings, CPU only
+	static void Benchmark(std::vector<Vertex> vertices, std::vector<unsigned int> indices, const std::string& name)
+	{
+		const unsigned int cacheSizes[] = { 8, 16, 32 };
+
+		std::cout << name << ": " << vertices.size() << " vertices, " << indices.size() / 3 << " triangles" << std::endl;
+
+		auto report = [&](const char* stage, double ms)
+		{
+			std::cout << "  " << stage;
+
+			for (unsigned int size : cacheSizes)
+			{
+				VertexCacheStats stats = SimulateCache(indices, vertices.size(), size);
+				std::cout << "  FIFO" << size << " ACMR " << stats.acmr << " ATVR " << stats.atvr;
+			}
+
+			std::cout << "  (" << ms << " ms)" << std::endl;
+		};
+
+		auto time = [](auto pass)
+		{
+			auto start = std::chrono::steady_clock::now();
+			pass();
+			return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		};
+
+		report("source order   ", 0.0);
+		report("welded         ", time([&] { WeldVertices(vertices, indices); }));
+		report("vertex cache   ", time([&] { OptimizeVertexCache(indices, vertices.size()); }));
+		report("overdraw       ", time([&] { OptimizeOverdraw(vertices, indices); }));
+		report("vertex fetch   ", time([&] { OptimizeVertexFetch(vertices, indices); }));
+	}
+
+private:
+	// Forsyth, "Linear-Speed Vertex Cache Optimisation"
+	static float forsythScore(int cachePosition, unsigned int liveTriangles, unsigned int cacheSize)
+	{
+		if (liveTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+				score = 0.75f;
+			else
+				score = std::pow(1.0f - (cachePosition - 3) / (float)(cacheSize - 3), 1.5f);
+		}
+
+		return score + 2.0f / std::sqrt((float)liveTriangles);
+	}
+
+	static void updateVertex(unsigned int v, int cachePosition, unsigned int cacheSize, const std::vector<unsigned int>& adjacency,
+		const std::vector<unsigned int>& firstTriangle, const std::vector<unsigned int>& liveCount, std::vector<float>& vertexScore, std::vector<float>& triangleScore)
+	{
+		float score = forsythScore(cachePosition, liveCount[v], cacheSize);
+		float delta = score - vertexScore[v];
+		vertexScore[v] = score;
+
+		for (unsigned int j = 0; j < liveCount[v]; j++)
+			triangleScore[adjacency[firstTriangle[v] + j]] += delta;
+	}
+};
+
+#endif
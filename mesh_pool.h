@@ -0,0 +1,227 @@
+#ifndef MESH_POOL_H
+#define MESH_POOL_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "stb_image.h"
+#include "mesh.h"
+#include "model.h"
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+
+// Layout of one command in GL_DRAW_INDIRECT_BUFFER, fixed by the GL spec
+struct DrawElementsIndirectCommand {
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+// Where one pooled mesh lives inside the shared buffers, in the units glDraw*BaseVertex and
+// DrawElementsIndirectCommand expect.
+struct MeshRange {
+	GLuint firstIndex;
+	GLuint indexCount;
+	GLint baseVertex;
+};
+
+// Many meshes in one vertex buffer, one index buffer and one VAO. Meshes are added on the CPU,
+// Upload() creates the GL objects once. Indices stay relative to their own mesh, baseVertex
+// does the rebasing at draw time. Vertex layout is the one Mesh uses (locations 0-4), so the
+// same shaders work on pooled and standalone meshes. A compact pool quantizes positions against
+// the bounds of all pooled meshes, GetDequantize() is the matching "meshDequantize".
+class MeshPool
+{
+public:
+	MeshPool() : VAO(0), VBO(0), EBO(0), dequantize(1.0f), vertexBytes(sizeof(Vertex)) {}
+
+	~MeshPool()
+	{
+		glDeleteBuffers(1, &VBO);
+		glDeleteBuffers(1, &EBO);
+		glDeleteVertexArrays(1, &VAO);
+	}
+
+	MeshPool(const MeshPool&) = delete;
+	MeshPool& operator=(const MeshPool&) = delete;
+
+	// all meshes of the model end up in one range
+	int Add(const Model& model)
+	{
+		MeshRange range;
+		range.firstIndex = (GLuint)indices.size();
+		range.baseVertex = (GLint)vertices.size();
+
+		for (const Mesh& mesh : model.meshes)
+		{
+			GLuint offset = (GLuint)vertices.size() - range.baseVertex;
+
+			vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+
+			for (unsigned int index : mesh.indices)
+				indices.push_back(index + offset);
+		}
+
+		range.indexCount = (GLuint)indices.size() - range.firstIndex;
+		ranges.push_back(range);
+
+		return (int)ranges.size() - 1;
+	}
+
+	// attributes as for Mesh: VERTEX_ALL keeps the float layout
+	void Upload(unsigned int attributes = VERTEX_ALL)
+	{
+		VertexArrayBuilder builder;
+
+		if (attributes == VERTEX_ALL)
+		{
+			VBO = CreateBuffer(vertices.size() * sizeof(Vertex), vertices.data());
+			VertexFormat::SetupFloatAttributes(builder, VBO);
+		}
+		else
+		{
+			VertexFormat format = VertexFormat::Compact(attributes, vertices.data(), vertices.size());
+			dequantize = format.dequantize;
+			vertexBytes = format.stride;
+
+			vector<unsigned char> packed;
+			format.Pack(vertices.data(), vertices.size(), packed);
+			VBO = CreateBuffer(packed.size(), packed.data());
+
+			format.SetupAttributes(builder, VBO);
+		}
+
+		EBO = CreateBuffer(indices.size() * sizeof(unsigned int), indices.data());
+		builder.Indices(EBO);
+		VAO = builder.Finish();
+
+		std::cout << "Mesh pool: " << ranges.size() << " meshes, " << vertices.size() << " vertices, " << indices.size() / 3 << " triangles, " << vertexBytes << " bytes per vertex" << std::endl;
+	}
+
+	const MeshRange& GetRange(int mesh) const { return ranges[mesh]; }
+	int GetMeshCount() const { return (int)ranges.size(); }
+	unsigned int GetVAO() const { return VAO; }
+	const glm::mat4& GetDequantize() const { return dequantize; }
+	unsigned int GetVertexBytes() const { return vertexBytes; }
+
+private:
+	vector<Vertex> vertices;
+	vector<unsigned int> indices;
+	vector<MeshRange> ranges;
+
+	unsigned int VAO, VBO, EBO;
+	glm::mat4 dequantize;
+	unsigned int vertexBytes;
+};
+
+// Images of different sizes packed into one GL_TEXTURE_2D_ARRAY. Every layer is resampled to
+// the array size; a file that fails to load becomes a flat layer in the fallback color so
+// layer indices never shift.
+class TextureArray
+{
+public:
+	unsigned int ID;
+	int width;
+	int height;
+
+	TextureArray(int width = 1024, int height = 512) : ID(0), width(width), height(height), layerCount(0) {}
+
+	~TextureArray()
+	{
+		glDeleteTextures(1, &ID);
+	}
+
+	TextureArray(const TextureArray&) = delete;
+	TextureArray& operator=(const TextureArray&) = delete;
+
+	int AddLayer(const string& path, glm::vec3 fallbackColor = glm::vec3(1.0f))
+	{
+		std::vector<unsigned char> layer(width * height * 4);
+
+		int w, h, n;
+		unsigned char* data = path.empty() ? NULL : stbi_load(path.c_str(), &w, &h, &n, 4);
+
+		if (data)
+		{
+			resample(data, w, h, layer.data());
+			stbi_image_free(data);
+		}
+		else
+		{
+			if (!path.empty())
+				std::cout << "Texture failed to load at path: " << path << std::endl;
+
+			for (size_t i = 0; i < layer.size(); i += 4)
+			{
+				layer[i + 0] = (unsigned char)(fallbackColor.r * 255.0f);
+				layer[i + 1] = (unsigned char)(fallbackColor.g * 255.0f);
+				layer[i + 2] = (unsigned char)(fallbackColor.b * 255.0f);
+				layer[i + 3] = 255;
+			}
+		}
+
+		layers.push_back(std::move(layer));
+
+		return layerCount++;
+	}
+
+	void Upload()
+	{
+		ID = CreateTexture2DArray(GL_RGBA8, width, height, (GLsizei)std::max(layers.size(), (size_t)1), 0, GL_RGBA, GL_UNSIGNED_BYTE);
+
+		for (size_t i = 0; i < layers.size(); i++)
+			UploadTextureLayer(ID, (GLint)i, width, height, GL_RGBA, GL_UNSIGNED_BYTE, layers[i].data());
+
+		GenerateMipmaps(GL_TEXTURE_2D_ARRAY, ID);
+
+		SetTextureParameter(GL_TEXTURE_2D_ARRAY, ID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		SetTextureParameter(GL_TEXTURE_2D_ARRAY, ID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		SetTextureParameter(GL_TEXTURE_2D_ARRAY, ID, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		SetTextureParameter(GL_TEXTURE_2D_ARRAY, ID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		// pixels live on the GPU from here on
+		layers.clear();
+		layers.shrink_to_fit();
+	}
+
+	int GetLayerCount() const { return layerCount; }
+
+private:
+	std::vector<std::vector<unsigned char>> layers;
+	int layerCount;
+
+	// bilinear, good enough since mipmaps are generated afterwards anyway
+	void resample(const unsigned char* src, int srcWidth, int srcHeight, unsigned char* dst)
+	{
+		for (int y = 0; y < height; y++)
+		{
+			float sy = glm::clamp((y + 0.5f) * srcHeight / height - 0.5f, 0.0f, (float)(srcHeight - 1));
+			int y0 = (int)sy;
+			int y1 = glm::min(y0 + 1, srcHeight - 1);
+			float fy = sy - y0;
+
+			for (int x = 0; x < width; x++)
+			{
+				float sx = glm::clamp((x + 0.5f) * srcWidth / width - 0.5f, 0.0f, (float)(srcWidth - 1));
+				int x0 = (int)sx;
+				int x1 = glm::min(x0 + 1, srcWidth - 1);
+				float fx = sx - x0;
+
+				for (int c = 0; c < 4; c++)
+				{
+					float top = src[(y0 * srcWidth + x0) * 4 + c] * (1.0f - fx) + src[(y0 * srcWidth + x1) * 4 + c] * fx;
+					float bottom = src[(y1 * srcWidth + x0) * 4 + c] * (1.0f - fx) + src[(y1 * srcWidth + x1) * 4 + c] * fx;
+					dst[(y * width + x) * 4 + c] = (unsigned char)(top * (1.0f - fy) + bottom * fy + 0.5f);
+				}
+			}
+		}
+	}
+};
+
+#endif
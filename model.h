@@ -5,12 +5,14 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
 #include "stb_image.h"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
 #include "mesh.h"
+#include "mesh_optimizer.h"
 #include "shader.h"
 
 #include <string>
@@ -29,26 +31,106 @@ public:
 	vector<Texture> textures_loaded;
 	string directory;
 	bool gammaCorrection;
+	unsigned int vertexAttributes;	// passed on to every Mesh, VERTEX_ALL keeps the float layout
 
 	Model()
 	{
 		
 	}
-	Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+	Model(string const &path, bool gamma = false, unsigned int attributes = VERTEX_ALL) : gammaCorrection(gamma), vertexAttributes(attributes)
 	{
 		loadModel(path);
 	}
-	void Draw(Shader& shader)
+	void Draw(Shader& shader, unsigned int instanceCount = 1)
 	{
 		for (unsigned int i = 0; i < meshes.size(); i++)
-			meshes[i].Draw(shader);
+			meshes[i].Draw(shader, instanceCount);
+	}
+
+	// Unit sphere around the origin, rings run from pole to pole. For surfaces that are generated
+	// in the shader instead of textured (star_procedural.frag); no file, no textures.
+	static Model Sphere(unsigned int rings, unsigned int segments, unsigned int attributes = VERTEX_ALL)
+	{
+		vector<Vertex> vertices;
+		vector<unsigned int> indices;
+
+		for (unsigned int ring = 0; ring <= rings; ring++)
+		{
+			float phi = glm::pi<float>() * ring / rings;
+
+			for (unsigned int segment = 0; segment <= segments; segment++)
+			{
+				float theta = glm::two_pi<float>() * segment / segments;
+
+				Vertex vertex = {};
+				vertex.Position = glm::vec3(sin(phi) * cos(theta), cos(phi), sin(phi) * sin(theta));
+				vertex.Normal = vertex.Position;
+				vertex.TexCoords = glm::vec2((float)segment / segments, (float)ring / rings);
+				vertex.Tangent = glm::vec3(-sin(theta), 0.0f, cos(theta));
+				vertex.Bitangent = glm::cross(vertex.Normal, vertex.Tangent);
+				vertices.push_back(vertex);
+			}
+		}
+
+		// counter-clockwise seen from outside
+		for (unsigned int ring = 0; ring < rings; ring++)
+		{
+			for (unsigned int segment = 0; segment < segments; segment++)
+			{
+				unsigned int a = ring * (segments + 1) + segment;
+				unsigned int b = a + segments + 1;
+				indices.insert(indices.end(), { a, a + 1, b, a + 1, b + 1, b });
+			}
+		}
+
+		MeshOptimizer::Optimize(vertices, indices, "sphere");
+
+		Model model;
+		model.gammaCorrection = false;
+		model.vertexAttributes = attributes;
+		model.meshes.push_back(Mesh(vertices, indices, vector<Texture>(), attributes));
+		return model;
+	}
+
+	// Geometry of all meshes in the file, merged, as the importer delivers it. No GL needed, used
+	// to benchmark import-time processing.
+	static bool ReadGeometry(string const &path, vector<Vertex>& vertices, vector<unsigned int>& indices)
+	{
+		Assimp::Importer import;
+		const aiScene* scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs);
+
+		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+		{
+			cout << "ERROR::ASSIMP::" << import.GetErrorString() << endl;
+			return false;
+		}
+
+		for (unsigned int i = 0; i < scene->mNumMeshes; i++)
+		{
+			vector<Vertex> meshVertices;
+			vector<unsigned int> meshIndices;
+			readGeometry(scene->mMeshes[i], meshVertices, meshIndices);
+
+			for (unsigned int index : meshIndices)
+				indices.push_back(index + (unsigned int)vertices.size());
+
+			vertices.insert(vertices.end(), meshVertices.begin(), meshVertices.end());
+		}
+
+		return true;
 	}
 
 private:
 	void loadModel(string const &path)
 	{
+		unsigned int flags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs;
+
+		// tangent space is only worth computing if a shader reads it
+		if (vertexAttributes & (VERTEX_TANGENT | VERTEX_BITANGENT))
+			flags |= aiProcess_CalcTangentSpace;
+
 		Assimp::Importer import;
-		const aiScene* scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+		const aiScene* scene = import.ReadFile(path, flags);
 
 		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
 		{
@@ -59,6 +141,18 @@ private:
 		directory = path.substr(0, path.find_last_of('/'));
 
 		processNode(scene->mRootNode, scene);
+
+		size_t vertexCount = 0;
+		size_t gpuBytes = 0;
+
+		for (const Mesh& mesh : meshes)
+		{
+			vertexCount += mesh.vertices.size();
+			gpuBytes += mesh.vertices.size() * mesh.vertexBytes;
+		}
+
+		if (vertexCount > 0)
+			cout << path << ": " << vertexCount << " vertices, " << gpuBytes / vertexCount << " bytes each (" << sizeof(Vertex) << " unpacked)" << endl;
 	}
 	void processNode(aiNode *node, const aiScene *scene)
 	{
@@ -79,9 +173,34 @@ private:
 		vector<unsigned int> indices;
 		vector<Texture> textures;
 
+		readGeometry(mesh, vertices, indices);
+		MeshOptimizer::Optimize(vertices, indices, directory + '/' + mesh->mName.C_Str());
+
+		if (mesh->mMaterialIndex >= 0)
+		{
+			aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+			// diffuse maps
+			vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
+			textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+			// specular maps
+			vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
+			textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+			// normal maps
+			vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
+			textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+			// height maps
+			vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
+			textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
+		}
+
+		return Mesh(vertices, indices, textures, vertexAttributes);
+	}
+
+	static void readGeometry(aiMesh* mesh, vector<Vertex>& vertices, vector<unsigned int>& indices)
+	{
 		for (unsigned int i = 0; i < mesh->mNumVertices; i++)
 		{
-			Vertex vertex;
+			Vertex vertex = {};
 			
 			glm::vec3 vector;
 			vector.x = mesh->mVertices[i].x;
@@ -107,7 +226,12 @@ private:
 				vec.y = mesh->mTextureCoords[0][i].y;
 
 				vertex.TexCoords = vec;
+			}
+			else
+				vertex.TexCoords = glm::vec2(0.0f, 0.0f);
 
+			if (mesh->HasTangentsAndBitangents())
+			{
 				// tangent
 				vector.x = mesh->mTangents[i].x;
 				vector.y = mesh->mTangents[i].y;
@@ -120,8 +244,6 @@ private:
 				vector.z = mesh->mBitangents[i].z;
 				vertex.Bitangent = vector;
 			}
-			else
-				vertex.TexCoords = glm::vec2(0.0f, 0.0f);
 
 			vertices.push_back(vertex);
 		}
@@ -133,26 +255,6 @@ private:
 			for (unsigned int j = 0; j < face.mNumIndices; j++)
 				indices.push_back(face.mIndices[j]);
 		}
-
-
-		if (mesh->mMaterialIndex >= 0)
-		{
-			aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-			// diffuse maps
-			vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-			textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-			// specular maps
-			vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-			textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
-			// normal maps
-			vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-			textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
-			// height maps
-			vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-			textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
-		}
-
-		return Mesh(vertices, indices, textures);
 	}
 
 	vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, string typeName)
@@ -195,8 +297,7 @@ private:
 		string filename = string(path);
 		filename = directory + '/' + filename;
 
-		unsigned int textureID;
-		glGenTextures(1, &textureID);
+		unsigned int textureID = 0;
 
 		int width, height, nrComponents;
 		unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
@@ -204,22 +305,36 @@ private:
 		if (data)
 		{
 			GLenum format;
+			GLenum internalFormat;
 			
 			if (nrComponents == 1)
+			{
 				format = GL_RED;
+				internalFormat = GL_R8;
+			}
+			else if (nrComponents == 2)
+			{
+				format = GL_RG;
+				internalFormat = GL_RG8;
+			}
 			else if (nrComponents == 3)
+			{
 				format = GL_RGB;
-			else if (nrComponents == 4)
+				internalFormat = GL_RGB8;
+			}
+			else
+			{
 				format = GL_RGBA;
+				internalFormat = GL_RGBA8;
+			}
 
-			glBindTexture(GL_TEXTURE_2D, textureID);
-			glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-			glGenerateMipmap(GL_TEXTURE_2D);
+			// immutable storage with the full mip chain on 4.5
+			textureID = CreateTexture2D(internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
 
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			SetTextureParameter(GL_TEXTURE_2D, textureID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			SetTextureParameter(GL_TEXTURE_2D, textureID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			SetTextureParameter(GL_TEXTURE_2D, textureID, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			SetTextureParameter(GL_TEXTURE_2D, textureID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
 			stbi_image_free(data);
 		}
@@ -8,9 +8,10 @@ out vec2 TexCoords;
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform mat4 meshDequantize;	// compact vertex positions back to model space
 
 void main()
 {
 	TexCoords = aTexCoords;
-	gl_Position = projection * view * model * vec4(aPos, 1.0);
+	gl_Position = projection * view * model * meshDequantize * vec4(aPos, 1.0);
 }
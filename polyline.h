@@ -0,0 +1,150 @@
+#ifndef POLYLINE_H
+#define POLYLINE_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "gl_state.h"
+#include "gl_resources.h"
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+const size_t POLYLINE_MIN_CAPACITY = 1024;	// segments of the first buffer
+
+// light years from the polyline's origin
+struct PolylineSegment {
+	glm::vec3 start;
+	glm::vec3 end;
+};
+
+// Line segments of any number drawn as anti-aliased lines width pixels wide, in one instanced
+// draw. route_line.vert turns every segment into a quad around its projected ends, route_line.frag
+// fades it out by the pixel distance to the segment, which also rounds the ends so consecutive
+// segments join without gaps.
+//
+// Segments are only ever appended. Append() stages them, the next Flush() or Draw() writes just
+// those behind the ones already on the GPU; when they no longer fit, the buffer doubles and the
+// old contents are copied over on the GPU. Positions are float offsets from the first point
+// appended, which is moved camera-relative in double every frame like a galaxy tile.
+class Polyline
+{
+public:
+	glm::vec3 color = glm::vec3(0.2f, 0.8f, 1.0f);
+	float width = 2.0f;	// pixels
+
+	Polyline() : VAO(0), VBO(0), capacity(0), count(0), origin(0.0)
+	{
+	}
+
+	~Polyline()
+	{
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &VBO);
+	}
+
+	Polyline(const Polyline&) = delete;
+	Polyline& operator=(const Polyline&) = delete;
+
+	// light years
+	void Append(const glm::dvec3& start, const glm::dvec3& end)
+	{
+		if (count == 0 && pending.empty())
+			origin = start;
+
+		PolylineSegment segment;
+		segment.start = glm::vec3(start - origin);
+		segment.end = glm::vec3(end - origin);
+		pending.push_back(segment);
+	}
+
+	// keeps the buffer for whatever is appended next
+	void Clear()
+	{
+		count = 0;
+		pending.clear();
+	}
+
+	void Flush()
+	{
+		if (pending.empty())
+			return;
+
+		size_t needed = count + pending.size();
+
+		if (needed > capacity)
+			grow(std::max(std::max(needed, capacity * 2), POLYLINE_MIN_CAPACITY));
+
+		UpdateBuffer(VBO, count * sizeof(PolylineSegment), pending.size() * sizeof(PolylineSegment), pending.data());
+		count = needed;
+		pending.clear();
+	}
+
+	// The first segments of all there are, the last of them only lastProgress of the way. eye in
+	// light years, mapScale render units per light year, viewport in pixels; view / projection
+	// already set.
+	void Draw(Shader& shader, const glm::dvec3& eye, double mapScale, const glm::vec2& viewport, size_t segments = (size_t)-1, float lastProgress = 1.0f)
+	{
+		Flush();
+		segments = std::min(segments, count);
+
+		if (segments == 0)
+			return;
+
+		shader.use();
+		shader.setVec3("origin", glm::vec3((origin - eye) * mapScale));
+		shader.setFloat("mapScale", (float)mapScale);
+		shader.setVec2("viewport", viewport);
+		shader.setFloat("halfWidth", width * 0.5f);
+		shader.setVec3("color", color);
+		shader.setInt("lastSegment", (int)segments - 1);
+		shader.setFloat("lastProgress", lastProgress);
+
+		// blended over the stars but not hiding them, nor each other where segments meet
+		glState.Enable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDepthMask(GL_FALSE);
+
+		glState.BindVertexArray(VAO);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)segments);
+
+		glDepthMask(GL_TRUE);
+		glState.Disable(GL_BLEND);
+	}
+
+	// on the GPU, not counting what is still staged
+	size_t GetCount() const { return count; }
+	size_t GetCapacity() const { return capacity; }
+
+private:
+	unsigned int VAO;
+	unsigned int VBO;
+	size_t capacity;	// segments
+	size_t count;		// segments
+	glm::dvec3 origin;	// light years
+
+	std::vector<PolylineSegment> pending;
+
+	void grow(size_t segments)
+	{
+		GLuint buffer = CreateBuffer(segments * sizeof(PolylineSegment), NULL, GL_DYNAMIC_STORAGE_BIT);
+
+		if (count > 0)
+			CopyBuffer(VBO, buffer, count * sizeof(PolylineSegment));
+
+		glDeleteBuffers(1, &VBO);
+		VBO = buffer;
+		capacity = segments;
+
+		VertexArrayBuilder builder(VAO);
+		builder.Buffer(0, VBO, sizeof(PolylineSegment), 1);
+		builder.Attribute(0, 0, 3, GL_FLOAT, GL_FALSE, offsetof(PolylineSegment, start));
+		builder.Attribute(1, 0, 3, GL_FLOAT, GL_FALSE, offsetof(PolylineSegment, end));
+		VAO = builder.Finish();
+	}
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "gl_state.h"
+#include "shader.h"
+#include "mesh.h"
+#include "model.h"
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+struct RenderItem {
+	Shader* shader;
+	Mesh* mesh;
+	glm::mat4 model;
+	unsigned int instanceCount;
+};
+
+// Collects the draws of one pass and issues them sorted by the state they need, so runs of
+// draws share program, VAO and textures and glState drops the rebinds. Sort key, most
+// expensive change first: program | VAO | first texture. Equal keys keep submission order.
+// Only for opaque geometry, the order within a pass changes.
+class RenderQueue
+{
+public:
+	RenderQueue() : lastCount(0) {}
+
+	// every mesh of the model, with the same transform
+	void Submit(Shader& shader, Model& model, const glm::mat4& transform, unsigned int instanceCount = 1)
+	{
+		for (Mesh& mesh : model.meshes)
+			Submit(shader, mesh, transform, instanceCount);
+	}
+
+	void Submit(Shader& shader, Mesh& mesh, const glm::mat4& transform, unsigned int instanceCount = 1)
+	{
+		GLuint texture = mesh.textures.empty() ? 0 : mesh.textures[0].id;
+		uint64_t key = ((uint64_t)(shader.ID & 0xFFFF) << 48) | ((uint64_t)(mesh.VAO & 0xFFFF) << 32) | ((uint64_t)(texture & 0xFFFF) << 16);
+
+		keys.push_back(std::make_pair(key, (uint32_t)items.size()));
+
+		RenderItem item = { &shader, &mesh, transform, instanceCount };
+		items.push_back(item);
+	}
+
+	// draws and empties the queue, "model" is set per item
+	void Flush()
+	{
+		std::sort(keys.begin(), keys.end());
+
+		GLuint program = 0;
+		GLint modelLocation = -1;
+
+		for (const auto& key : keys)
+		{
+			RenderItem& item = items[key.second];
+
+			if (item.shader->ID != program)
+			{
+				program = item.shader->ID;
+				modelLocation = glGetUniformLocation(program, "model");
+				item.shader->use();
+			}
+
+			glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &item.model[0][0]);
+			item.mesh->Draw(*item.shader, item.instanceCount);
+		}
+
+		lastCount = (unsigned int)items.size();
+		keys.clear();
+		items.clear();
+	}
+
+	unsigned int GetLastCount() const { return lastCount; }
+
+private:
+	std::vector<std::pair<uint64_t, uint32_t>> keys;	// key, item
+	std::vector<RenderItem> items;
+	unsigned int lastCount;
+};
+
+#endif
@@ -0,0 +1,325 @@
+#ifndef RENDER_TARGETS_H
+#define RENDER_TARGETS_H
+
+#include <glad/glad.h>
+
+#include "gl_state.h"
+#include "gl_resources.h"
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+
+struct RenderTargetDesc
+{
+	GLenum colorFormat	= GL_RGB8;				// 0 = no color attachment
+	GLenum depthFormat	= GL_DEPTH24_STENCIL8;	// 0 = no depth attachment
+	unsigned int divisor = 1;					// 1 = window size, 2 = half size, ...
+
+	bool operator==(const RenderTargetDesc& other) const
+	{
+		return colorFormat == other.colorFormat && depthFormat == other.depthFormat && divisor == other.divisor;
+	}
+};
+
+// Owns every offscreen framebuffer. Targets are (re)allocated lazily the first time they are
+// used after a resize, transient targets are handed out per pass and shared between passes that
+// do not overlap in time.
+class RenderTargetPool
+{
+public:
+	struct Target
+	{
+		std::string name;
+		RenderTargetDesc desc;
+		bool transient = false;
+		bool inUse = false;
+		unsigned long long lastUsedFrame = 0;
+
+		unsigned int FBO = 0;
+		unsigned int colorTexture = 0;
+		unsigned int depthBuffer = 0;
+		int width = 0;
+		int height = 0;
+	};
+
+	// transient targets not requested for this many frames give their memory back
+	unsigned int transientLifetime = 120;
+
+	RenderTargetPool() { }
+
+	// must run while the GL context is still alive
+	void Clear()
+	{
+		for (Target& t : targets)
+			freeTarget(t);
+
+		targets.clear();
+	}
+
+	RenderTargetPool(const RenderTargetPool&) = delete;
+	RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+	// only remembers the new size, GL storage is rebuilt on the next Get()
+	void Resize(int width, int height)
+	{
+		if (width <= 0 || height <= 0)
+			return;
+
+		windowWidth = width;
+		windowHeight = height;
+	}
+
+	int Create(const std::string& name, const RenderTargetDesc& desc)
+	{
+		Target t;
+		t.name = name;
+		t.desc = desc;
+		targets.push_back(t);
+
+		return (int)targets.size() - 1;
+	}
+
+	// hands out a free transient target with a matching description, or makes a new one
+	int AcquireTransient(const RenderTargetDesc& desc)
+	{
+		for (unsigned int i = 0; i < targets.size(); i++)
+		{
+			if (targets[i].transient && !targets[i].inUse && targets[i].desc == desc)
+			{
+				targets[i].inUse = true;
+				targets[i].lastUsedFrame = frame;
+				return i;
+			}
+		}
+
+		int handle = Create("transient", desc);
+		targets[handle].transient = true;
+		targets[handle].inUse = true;
+		targets[handle].lastUsedFrame = frame;
+
+		return handle;
+	}
+
+	// the target may be handed to the next pass that asks for the same description
+	void Release(int handle)
+	{
+		targets[handle].inUse = false;
+	}
+
+	void BeginFrame()
+	{
+		frame++;
+
+		for (Target& t : targets)
+		{
+			if (t.transient && !t.inUse && t.FBO != 0 && frame - t.lastUsedFrame > transientLifetime)
+			{
+				freeTarget(t);
+				memoryChanged = true;
+			}
+		}
+
+		if (memoryChanged)
+		{
+			std::cout << "RenderTargets: " << GetAllocatedCount() << " allocated, " << GetMemoryUsage() / (1024.0 * 1024.0) << " MB" << std::endl;
+			memoryChanged = false;
+		}
+	}
+
+	Target& Get(int handle)
+	{
+		Target& t = targets[handle];
+
+		int width = std::max(1, windowWidth / (int)t.desc.divisor);
+		int height = std::max(1, windowHeight / (int)t.desc.divisor);
+
+		if (t.FBO == 0 || t.width != width || t.height != height)
+			allocate(t, width, height);
+
+		t.lastUsedFrame = frame;
+
+		return t;
+	}
+
+	void Bind(int handle)
+	{
+		Target& t = Get(handle);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, t.FBO);
+		glViewport(0, 0, t.width, t.height);
+	}
+
+	void BindDefault()
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, windowWidth, windowHeight);
+	}
+
+	int GetWidth() const { return windowWidth; }
+	int GetHeight() const { return windowHeight; }
+
+	unsigned int GetAllocatedCount() const
+	{
+		unsigned int count = 0;
+
+		for (const Target& t : targets)
+			if (t.FBO != 0)
+				count++;
+
+		return count;
+	}
+
+	// estimated bytes of GPU memory held by all allocated targets
+	size_t GetMemoryUsage() const
+	{
+		size_t bytes = 0;
+
+		for (const Target& t : targets)
+		{
+			if (t.FBO == 0)
+				continue;
+
+			bytes += (size_t)t.width * t.height * (bytesPerPixel(t.desc.colorFormat) + bytesPerPixel(t.desc.depthFormat));
+		}
+
+		return bytes;
+	}
+
+	static unsigned int bytesPerPixel(GLenum format)
+	{
+		switch (format)
+		{
+			case 0:						return 0;
+			case GL_R8:					return 1;
+			case GL_RG8:				return 2;
+			case GL_R16F:				return 2;
+			case GL_RGB8:				return 4; // drivers pad 24 bit formats
+			case GL_RGBA8:				return 4;
+			case GL_R11F_G11F_B10F:		return 4;
+			case GL_R32F:				return 4;
+			case GL_RGB16F:				return 8;
+			case GL_RGBA16F:			return 8;
+			case GL_RGB32F:				return 16;
+			case GL_RGBA32F:			return 16;
+			case GL_DEPTH_COMPONENT16:	return 2;
+			case GL_DEPTH_COMPONENT24:	return 4;
+			case GL_DEPTH24_STENCIL8:	return 4;
+			case GL_DEPTH_COMPONENT32F:	return 4;
+			case GL_DEPTH32F_STENCIL8:	return 8;
+			default:					return 4;
+		}
+	}
+
+private:
+	std::vector<Target> targets;
+	int windowWidth = 1;
+	int windowHeight = 1;
+	unsigned long long frame = 0;
+	bool memoryChanged = false;
+
+	void allocate(Target& t, int width, int height)
+	{
+		freeTarget(t);
+
+		t.width = width;
+		t.height = height;
+
+		if (t.desc.colorFormat != 0)
+		{
+			t.colorTexture = CreateTexture2D(t.desc.colorFormat, width, height, 1, GL_RGBA, isFloatFormat(t.desc.colorFormat) ? GL_FLOAT : GL_UNSIGNED_BYTE, NULL);
+			SetTextureParameter(GL_TEXTURE_2D, t.colorTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			SetTextureParameter(GL_TEXTURE_2D, t.colorTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			SetTextureParameter(GL_TEXTURE_2D, t.colorTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			SetTextureParameter(GL_TEXTURE_2D, t.colorTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		}
+
+		GLenum depthAttachment = hasStencil(t.desc.depthFormat) ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+		GLenum status;
+
+		if (UseDirectStateAccess())
+		{
+			glCreateFramebuffers(1, &t.FBO);
+
+			if (t.colorTexture != 0)
+			{
+				glNamedFramebufferTexture(t.FBO, GL_COLOR_ATTACHMENT0, t.colorTexture, 0);
+			}
+			else
+			{
+				glNamedFramebufferDrawBuffer(t.FBO, GL_NONE);
+				glNamedFramebufferReadBuffer(t.FBO, GL_NONE);
+			}
+
+			if (t.desc.depthFormat != 0)
+			{
+				glCreateRenderbuffers(1, &t.depthBuffer);
+				glNamedRenderbufferStorage(t.depthBuffer, t.desc.depthFormat, width, height);
+				glNamedFramebufferRenderbuffer(t.FBO, depthAttachment, GL_RENDERBUFFER, t.depthBuffer);
+			}
+
+			status = glCheckNamedFramebufferStatus(t.FBO, GL_FRAMEBUFFER);
+		}
+		else
+		{
+			glGenFramebuffers(1, &t.FBO);
+			glBindFramebuffer(GL_FRAMEBUFFER, t.FBO);
+
+			if (t.colorTexture != 0)
+			{
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, t.colorTexture, 0);
+			}
+			else
+			{
+				glDrawBuffer(GL_NONE);
+				glReadBuffer(GL_NONE);
+			}
+
+			if (t.desc.depthFormat != 0)
+			{
+				glGenRenderbuffers(1, &t.depthBuffer);
+				glBindRenderbuffer(GL_RENDERBUFFER, t.depthBuffer);
+				glRenderbufferStorage(GL_RENDERBUFFER, t.desc.depthFormat, width, height);
+				glFramebufferRenderbuffer(GL_FRAMEBUFFER, depthAttachment, GL_RENDERBUFFER, t.depthBuffer);
+			}
+
+			status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		}
+
+		if (status != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "ERROR::FRAMEBUFFER:: Render target '" << t.name << "' is not complete!" << std::endl;
+
+		memoryChanged = true;
+	}
+
+	void freeTarget(Target& t)
+	{
+		if (t.colorTexture != 0)
+			glDeleteTextures(1, &t.colorTexture);
+		if (t.depthBuffer != 0)
+			glDeleteRenderbuffers(1, &t.depthBuffer);
+		if (t.FBO != 0)
+			glDeleteFramebuffers(1, &t.FBO);
+
+		t.colorTexture = 0;
+		t.depthBuffer = 0;
+		t.FBO = 0;
+		t.width = 0;
+		t.height = 0;
+	}
+
+	static bool isFloatFormat(GLenum format)
+	{
+		return format == GL_R16F || format == GL_R32F || format == GL_RGB16F || format == GL_RGBA16F
+			|| format == GL_RGB32F || format == GL_RGBA32F || format == GL_R11F_G11F_B10F;
+	}
+
+	static bool hasStencil(GLenum format)
+	{
+		return format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8;
+	}
+};
+
+#endif
@@ -0,0 +1,24 @@
+#version 330 core
+out vec4 FragColor;
+
+flat in vec2 StartPixel;
+flat in vec2 EndPixel;
+
+uniform vec3 color;
+uniform float halfWidth;	// pixels
+
+void main()
+{
+	// pixels from the segment, a capsule once thresholded
+	vec2 along = EndPixel - StartPixel;
+	vec2 offset = gl_FragCoord.xy - StartPixel;
+	float t = clamp(dot(offset, along) / max(dot(along, along), 1e-8), 0.0, 1.0);
+	float distance = length(offset - along * t);
+
+	float coverage = clamp(halfWidth + 0.5 - distance, 0.0, 1.0);
+
+	if (coverage <= 0.0)
+		discard;
+
+	FragColor = vec4(color, coverage);
+}
@@ -0,0 +1,46 @@
+#ifndef ROUTE_LINE_H
+#define ROUTE_LINE_H
+
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "polyline.h"
+#include "star_store.h"
+#include "route_planner.h"
+
+// A planned route as a polyline through its systems, one segment per jump.
+class RouteLine
+{
+public:
+	RouteLine()
+	{
+		line.color = glm::vec3(0.2f, 0.8f, 1.0f);
+		line.width = 3.0f;
+	}
+
+	void SetRoute(const StarStore& store, const Route& route)
+	{
+		Clear();
+
+		for (size_t i = 1; i < route.systems.size(); i++)
+			line.Append(store.GetPosition(route.systems[i - 1]), store.GetPosition(route.systems[i]));
+	}
+
+	void Clear()
+	{
+		line.Clear();
+	}
+
+	// eye in light years, mapScale render units per light year, viewport in pixels
+	void Draw(Shader& shader, const glm::dvec3& eye, double mapScale, const glm::vec2& viewport)
+	{
+		line.Draw(shader, eye, mapScale, viewport);
+	}
+
+	Polyline& GetLine() { return line; }
+
+private:
+	Polyline line;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#version 330 core
+layout (location = 0) in vec3 aStart;	// light years from the polyline's origin
+layout (location = 1) in vec3 aEnd;
+
+flat out vec2 StartPixel;
+flat out vec2 EndPixel;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform vec3 origin;		// camera-relative, render units
+uniform float mapScale;		// render units per light year
+uniform vec2 viewport;		// pixels
+uniform float halfWidth;	// pixels
+uniform int lastSegment;	// drawn only lastProgress of the way
+uniform float lastProgress;
+
+const float NEAR_W = 0.001;	// ends behind the eye are moved up to here
+
+vec2 toPixels(vec4 clip)
+{
+	return (clip.xy / clip.w * 0.5 + 0.5) * viewport;
+}
+
+void main()
+{
+	vec3 end = gl_InstanceID == lastSegment ? mix(aStart, aEnd, lastProgress) : aEnd;
+	vec4 start = projection * view * vec4(origin + aStart * mapScale, 1.0);
+	vec4 stop = projection * view * vec4(origin + end * mapScale, 1.0);
+
+	// clipped against the eye plane here, after the divide it would be too late
+	if (start.w < NEAR_W && stop.w < NEAR_W)
+	{
+		gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+		return;
+	}
+
+	if (start.w < NEAR_W)
+		start = mix(start, stop, (NEAR_W - start.w) / (stop.w - start.w));
+	else if (stop.w < NEAR_W)
+		stop = mix(stop, start, (NEAR_W - stop.w) / (start.w - stop.w));
+
+	StartPixel = toPixels(start);
+	EndPixel = toPixels(stop);
+
+	vec2 along = EndPixel - StartPixel;
+	along = dot(along, along) > 1e-8 ? normalize(along) : vec2(1.0, 0.0);
+	vec2 across = vec2(-along.y, along.x);
+
+	// strip corners: start right, start left, end right, end left; one pixel more all round for
+	// the fade, half a width past either end for the round caps
+	bool atEnd = gl_VertexID >= 2;
+	float extent = halfWidth + 1.0;
+	vec4 clip = atEnd ? stop : start;
+	vec2 pixel = (atEnd ? EndPixel + along * extent : StartPixel - along * extent) + across * ((gl_VertexID & 1) == 0 ? -extent : extent);
+
+	gl_Position = vec4((pixel / viewport * 2.0 - 1.0) * clip.w, clip.z, clip.w);
+}
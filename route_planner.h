@@ -0,0 +1,239 @@
+#ifndef ROUTE_PLANNER_H
+#define ROUTE_PLANNER_H
+
+#include <glm/glm.hpp>
+
+#include "star_store.h"
+#include "star_grid.h"
+
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <cmath>
+#include <cstdint>
+
+const double ROUTE_NEUTRON_MULTIPLIER = 4.0;	// jump range from a neutron star, supercharged
+const size_t ROUTE_MAX_EXPANSIONS = 4000000;	// a search gives up after this many systems
+const size_t ROUTE_MAX_TAIL = 256;				// appended systems every expansion scans before a regrid
+
+struct RouteOptions {
+	double jumpRange = 50.0;	// light years
+	bool neutronBoost = false;	// jumps from STAR_NEUTRON systems reach ROUTE_NEUTRON_MULTIPLIER times as far
+	size_t maxExpansions = ROUTE_MAX_EXPANSIONS;
+	float heuristicWeight = 1.25f;	// 1 finds the fewest jumps, above trades at most that factor more for a far narrower search
+};
+
+struct Route {
+	std::vector<uint32_t> systems;	// store indices from start to goal, empty if there is none
+	double distance = 0.0;			// light years along the jumps
+	size_t expanded = 0;			// systems whose neighbours were searched
+	double milliseconds = 0.0;
+
+	bool Found() const { return !systems.empty(); }
+	size_t Jumps() const { return systems.empty() ? 0 : systems.size() - 1; }
+};
+
+// Plans the fewest jumps between two systems of a StarStore.
+//
+// There are no stored neighbour lists, at 10M systems they would not fit. Instead the systems
+// are bucketed into a StarGrid with cells one jump range wide, and each search finds the
+// neighbours of a system it expands by scanning the cells its range overlaps. The grid is
+// rebuilt when the jump range changes; systems added to the store go into the grid's tail
+// until it asks for a rebuild.
+//
+// The search is A* over jump counts. No path can beat the straight line, so the remaining
+// distance over the longest possible jump, rounded up, never overestimates: with a heuristic
+// weight of 1 the first route found is a shortest one. Jump counts are small integers though,
+// and wherever the straight line is blocked every system with the same estimate gets expanded,
+// hundreds of thousands at 10M systems. A weight above 1 (weighted A*) bounds the route to that
+// factor of the shortest and in practice cuts the search by orders of magnitude. With neutron
+// boost the longest jump is the supercharged one, which makes the estimate weaker and the
+// search wider. Ties go to the system closest to the goal.
+class RoutePlanner
+{
+public:
+	RoutePlanner(const StarStore& store) : store(store), search(0)
+	{
+	}
+
+	RoutePlanner(const RoutePlanner&) = delete;
+	RoutePlanner& operator=(const RoutePlanner&) = delete;
+
+	Route Plan(uint32_t start, uint32_t goal, const RouteOptions& options)
+	{
+		Route route;
+
+		if (start >= store.Size() || goal >= store.Size() || options.jumpRange <= 0.0)
+			return route;
+
+		auto begin = std::chrono::steady_clock::now();
+
+		Prepare(options.jumpRange);
+
+		// grown by appended systems, a stale search number marks the new ones unvisited
+		visits.resize(grid.Size());
+
+		// a new search number marks every earlier visit stale, nothing needs clearing
+		if (++search == 0)
+		{
+			std::fill(visits.begin(), visits.end(), Visit());
+			search = 1;
+		}
+
+		uint32_t startCell = grid.GetSlot(start);
+		uint32_t goalCell = grid.GetSlot(goal);
+		glm::vec3 goalPosition = grid.GetPosition(goalCell);
+		bool boost = options.neutronBoost && hasNeutrons;
+		float longestJump = (float)(options.jumpRange * (boost ? ROUTE_NEUTRON_MULTIPLIER : 1.0));
+		float range = (float)options.jumpRange;
+
+		open.clear();
+		weight = std::max(options.heuristicWeight, 1.0f);
+		visit(startCell, startCell, 0, goalPosition, longestJump);
+
+		while (!open.empty())
+		{
+			std::pop_heap(open.begin(), open.end());
+			Entry entry = open.back();
+			open.pop_back();
+
+			Visit& current = visits[entry.system];
+
+			// stale: reached with fewer jumps since it was queued
+			if (current.closed || entry.jumps != current.jumps)
+				continue;
+
+			current.closed = 1;
+
+			if (entry.system == goalCell)
+				break;
+
+			if (route.expanded++ >= options.maxExpansions)
+				break;
+
+			float reach = boost && (grid.GetFlags(entry.system) & STAR_NEUTRON) ? longestJump : range;
+			neighbours(entry.system, reach, [&](uint32_t next) {
+				const Visit& known = visits[next];
+
+				if (known.search != search || (!known.closed && known.jumps > entry.jumps + 1))
+					visit(next, entry.system, entry.jumps + 1, goalPosition, longestJump);
+			});
+		}
+
+		if (visits[goalCell].search == search && visits[goalCell].closed)
+		{
+			for (uint32_t system = goalCell; ; system = visits[system].parent)
+			{
+				route.systems.push_back(grid.GetId(system));
+
+				if (system == startCell)
+					break;
+			}
+
+			std::reverse(route.systems.begin(), route.systems.end());
+
+			for (size_t i = 1; i < route.systems.size(); i++)
+				route.distance += glm::length(store.GetPosition(route.systems[i]) - store.GetPosition(route.systems[i - 1]));
+		}
+
+		route.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		return route;
+	}
+
+	// builds the grid for jumpRange unless it is already, systems the store gained since go into
+	// its tail; Plan() calls it as needed
+	void Prepare(double jumpRange)
+	{
+		if (grid.GetCellSize() != jumpRange)
+		{
+			buildGrid(jumpRange);
+			return;
+		}
+
+		for (size_t id = grid.Size(); id < store.Size(); id++)
+		{
+			grid.Append(store, (uint32_t)id);
+			hasNeutrons = hasNeutrons || store.IsNeutron(id);
+		}
+
+		if (grid.GetTailSize() > ROUTE_MAX_TAIL)
+			buildGrid(jumpRange);
+	}
+
+	size_t GetCellCount() const { return grid.GetCellCount(); }
+
+private:
+	struct Visit {
+		uint32_t search = 0;	// which Plan() wrote the rest
+		uint32_t parent = 0;
+		uint16_t jumps = 0;
+		uint16_t closed = 0;
+	};
+
+	// a system waiting in the open list
+	struct Entry {
+		float estimate;		// jumps so far plus the least still needed
+		float remaining;	// light years to the goal, breaks ties
+		uint32_t system;
+		uint16_t jumps;
+
+		bool operator<(const Entry& other) const
+		{
+			// std::push_heap keeps the largest on top, the best has to compare largest
+			return estimate != other.estimate ? estimate > other.estimate : remaining > other.remaining;
+		}
+	};
+
+	const StarStore& store;
+	StarGrid grid;
+	bool hasNeutrons = false;
+
+	std::vector<Visit> visits;			// per grid slot
+	std::vector<Entry> open;
+	uint32_t search;
+	float weight = 1.0f;
+
+	void visit(uint32_t system, uint32_t parent, uint16_t jumps, const glm::vec3& goal, float longestJump)
+	{
+		Visit& v = visits[system];
+		v.search = search;
+		v.parent = parent;
+		v.jumps = jumps;
+		v.closed = 0;
+
+		Entry entry;
+		entry.remaining = glm::length(grid.GetPosition(system) - goal);
+		entry.estimate = jumps + weight * std::ceil(entry.remaining / longestJump - 1e-4f);
+		entry.system = system;
+		entry.jumps = jumps;
+		open.push_back(entry);
+		std::push_heap(open.begin(), open.end());
+	}
+
+	// every other system within reach of system
+	template <typename F>
+	void neighbours(uint32_t system, float reach, F callback) const
+	{
+		grid.ForEachWithin(grid.GetPosition(system), reach, [&](uint32_t slot) {
+			if (slot != system)
+				callback(slot);
+		});
+	}
+
+	void buildGrid(double size)
+	{
+		auto begin = std::chrono::steady_clock::now();
+
+		grid.Build(store, size);
+		hasNeutrons = false;
+
+		for (size_t i = 0; i < store.Size() && !hasNeutrons; i++)
+			hasNeutrons = store.IsNeutron(i);
+
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		std::cout << "Route grid: " << grid.Size() << " systems in " << grid.GetCellCount() << " cells of " << size << " ly, " << ms << " ms" << std::endl;
+	}
+};
+
+#endif
@@ -3,10 +3,26 @@ out vec4 FragColor;
 
 in vec2 TexCoords;
 
-uniform sampler2D screenTexture;
+uniform sampler2D screenTexture;	// HDR scene
+uniform sampler2D bloomTexture;
+uniform float bloomIntensity;
+uniform float exposure;
+
+// Linear up to SHOULDER so the unlit scene looks as before, above it an exponential shoulder
+// that meets 1.0 at infinity with matching slope.
+const float SHOULDER = 0.8;
+
+vec3 toneMap(vec3 color)
+{
+	vec3 over = max(color - SHOULDER, 0.0);
+	vec3 compressed = SHOULDER + (1.0 - SHOULDER) * (1.0 - exp(-over / (1.0 - SHOULDER)));
+
+	return mix(color, compressed, step(SHOULDER, color));
+}
 
 void main()
 {
     vec3 col = texture(screenTexture, TexCoords).rgb;
-    FragColor = vec4(col, 1.0);
+    col += texture(bloomTexture, TexCoords).rgb * bloomIntensity;
+    FragColor = vec4(toneMap(col * exposure), 1.0);
 } 
@@ -0,0 +1,273 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "gl_extensions.h"
+#include "shader.h"
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// File layout of one cached program: header followed by the driver's binary blob
+struct ProgramBinaryHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t key;
+	uint32_t format;
+	uint32_t length;
+};
+
+const char PROGRAM_BINARY_MAGIC[4] = { 'S', 'B', 'I', 'N' };
+const uint32_t PROGRAM_BINARY_VERSION = 1;
+
+// Builds shader programs in batches and keeps their linked binaries on disk.
+//
+// Request() only queues work: a cached binary is handed to glProgramBinary, anything else gets
+// glCompileShader/glLinkProgram without waiting for the result. Finish() then collects all of
+// them, so the driver compiles the whole batch in parallel (with GL_KHR_parallel_shader_compile
+// on its own thread pool). Cache files are keyed by a hash of the sources and the driver
+// (vendor, renderer, version); a binary the driver rejects after an update is recompiled from
+// source and replaced.
+class ShaderCache
+{
+public:
+	ShaderCache(const std::string& directory = "shader_cache") : directory(directory), loadedCount(0), batchStart(0.0)
+	{
+		useBinaries = false;
+
+		if (GLAD_GL_ARB_get_program_binary)
+		{
+			GLint formats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+			useBinaries = formats > 0;
+		}
+
+		if (GLAD_GL_KHR_parallel_shader_compile)
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+
+		driver = std::string((const char*)glGetString(GL_VENDOR)) + "|" + (const char*)glGetString(GL_RENDERER) + "|" + (const char*)glGetString(GL_VERSION);
+	}
+
+	Shader Request(const char* vertexPath, const char* fragmentPath)
+	{
+		Pending pending;
+		pending.name = std::string(vertexPath) + " + " + fragmentPath;
+		pending.stages.push_back(std::make_pair(GL_VERTEX_SHADER, Shader::ReadSource(vertexPath)));
+		pending.stages.push_back(std::make_pair(GL_FRAGMENT_SHADER, Shader::ReadSource(fragmentPath)));
+
+		return start(pending);
+	}
+
+	// needs GL_ARB_compute_shader
+	Shader Request(const char* computePath)
+	{
+		Pending pending;
+		pending.name = computePath;
+		pending.stages.push_back(std::make_pair(GL_COMPUTE_SHADER, Shader::ReadSource(computePath)));
+
+		return start(pending);
+	}
+
+	// Blocks until every requested program is linked and writes binaries for the new ones
+	void Finish()
+	{
+		for (Pending& pending : queue)
+		{
+			if (pending.fromBinary)
+			{
+				GLint linked = 0;
+				glGetProgramiv(pending.program, GL_LINK_STATUS, &linked);
+
+				if (linked)
+				{
+					loadedCount++;
+					continue;
+				}
+
+				// driver or GPU changed under the same key, build it from source after all
+				compile(pending);
+			}
+
+			bool ok = true;
+
+			for (size_t i = 0; i < pending.shaders.size(); i++)
+			{
+				ok = Shader::checkCompileErrors(pending.shaders[i], stageName(pending.stages[i].first)) && ok;
+				glDetachShader(pending.program, pending.shaders[i]);
+				glDeleteShader(pending.shaders[i]);
+			}
+
+			ok = Shader::checkCompileErrors(pending.program, "PROGRAM") && ok;
+
+			if (!ok)
+				std::cout << "ERROR::SHADER_CACHE:: " << pending.name << " failed to build" << std::endl;
+			else if (useBinaries)
+				store(pending);
+		}
+
+		if (!queue.empty())
+			std::cout << "Shaders: " << queue.size() << " programs, " << loadedCount << " from cache, " << (glfwGetTime() - batchStart) * 1000.0 << " ms" << std::endl;
+
+		queue.clear();
+		loadedCount = 0;
+	}
+
+private:
+	struct Pending {
+		std::string name;
+		std::vector<std::pair<GLenum, std::string>> stages;
+		std::vector<GLuint> shaders;
+		GLuint program;
+		uint64_t key;
+		bool fromBinary;
+	};
+
+	std::string directory;
+	std::string driver;
+	bool useBinaries;
+	std::vector<Pending> queue;
+	unsigned int loadedCount;
+	double batchStart;
+
+	Shader start(Pending& pending)
+	{
+		if (queue.empty())
+			batchStart = glfwGetTime();
+
+		std::string keySource = driver;
+
+		for (const auto& stage : pending.stages)
+			keySource += "\n#stage " + std::to_string(stage.first) + "\n" + stage.second;
+
+		pending.key = hash(keySource);
+		pending.program = glCreateProgram();
+		pending.fromBinary = useBinaries && load(pending);
+
+		if (!pending.fromBinary)
+			compile(pending);
+
+		queue.push_back(pending);
+
+		Shader shader;
+		shader.ID = pending.program;
+		return shader;
+	}
+
+	void compile(Pending& pending)
+	{
+		pending.shaders.clear();
+
+		for (const auto& stage : pending.stages)
+		{
+			const char* code = stage.second.c_str();
+
+			GLuint shader = glCreateShader(stage.first);
+			glShaderSource(shader, 1, &code, NULL);
+			glCompileShader(shader);
+			glAttachShader(pending.program, shader);
+			pending.shaders.push_back(shader);
+		}
+
+		if (useBinaries)
+			glProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+		glLinkProgram(pending.program);
+		pending.fromBinary = false;
+	}
+
+	bool load(Pending& pending)
+	{
+		std::ifstream file(path(pending.key), std::ios::in | std::ios::binary);
+
+		if (!file.is_open())
+			return false;
+
+		ProgramBinaryHeader header;
+
+		if (!file.read((char*)&header, sizeof(header)) || std::memcmp(header.magic, PROGRAM_BINARY_MAGIC, 4) != 0
+			|| header.version != PROGRAM_BINARY_VERSION || header.key != pending.key)
+			return false;
+
+		std::vector<char> binary(header.length);
+
+		if (!file.read(binary.data(), header.length))
+			return false;
+
+		glProgramBinary(pending.program, header.format, binary.data(), header.length);
+
+		return true;
+	}
+
+	void store(const Pending& pending)
+	{
+		GLint length = 0;
+		glGetProgramiv(pending.program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+		if (length <= 0)
+			return;
+
+		std::vector<char> binary(length);
+		GLenum format = 0;
+		glGetProgramBinary(pending.program, length, NULL, &format, binary.data());
+
+		std::error_code error;
+		std::filesystem::create_directories(directory, error);
+
+		std::ofstream file(path(pending.key), std::ios::out | std::ios::binary | std::ios::trunc);
+
+		if (!file.is_open())
+		{
+			std::cout << "ERROR::SHADER_CACHE:: Could not write " << path(pending.key) << std::endl;
+			return;
+		}
+
+		ProgramBinaryHeader header;
+		std::memcpy(header.magic, PROGRAM_BINARY_MAGIC, 4);
+		header.version = PROGRAM_BINARY_VERSION;
+		header.key = pending.key;
+		header.format = format;
+		header.length = (uint32_t)length;
+
+		file.write((const char*)&header, sizeof(header));
+		file.write(binary.data(), length);
+	}
+
+	std::string path(uint64_t key) const
+	{
+		char name[32];
+		std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+		return directory + "/" + name;
+	}
+
+	static uint64_t hash(const std::string& text)
+	{
+		uint64_t h = 14695981039346656037ull;
+
+		for (unsigned char c : text)
+			h = (h ^ c) * 1099511628211ull;
+
+		return h;
+	}
+
+	static const char* stageName(GLenum stage)
+	{
+		switch (stage)
+		{
+			case GL_VERTEX_SHADER: return "VERTEX";
+			case GL_FRAGMENT_SHADER: return "FRAGMENT";
+			case GL_COMPUTE_SHADER: return "COMPUTE";
+		}
+
+		return "SHADER";
+	}
+};
+
+#endif
@@ -0,0 +1,61 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+in vec3 FragPos;
+in vec3 Normal;
+in float ViewDepth;
+flat in uint Layer;
+flat in uint Highlight;
+
+uniform sampler2DArray starTextures;
+
+uniform int clusterLighting;			// 0 until ClusteredLights::Bind
+uniform samplerBuffer clusterLights;	// per light: position, radius / color
+uniform usamplerBuffer clusterRanges;	// per cluster: first index, light count
+uniform usamplerBuffer clusterIndices;
+uniform ivec3 clusterGrid;
+uniform vec2 clusterViewport;
+uniform vec2 clusterDepth;				// slice = log(depth) * x + y
+
+// diffuse light of the lights binned into this fragment's cluster
+vec3 clusteredLight(vec3 position, vec3 normal, float viewDepth)
+{
+	vec3 result = vec3(0.0);
+
+	if (clusterLighting == 0)
+		return result;
+
+	ivec2 tile = clamp(ivec2(gl_FragCoord.xy / clusterViewport * vec2(clusterGrid.xy)), ivec2(0), clusterGrid.xy - 1);
+	int slice = clamp(int(floor(log(max(viewDepth, 1e-6)) * clusterDepth.x + clusterDepth.y)), 0, clusterGrid.z - 1);
+	uvec2 range = texelFetch(clusterRanges, tile.x + tile.y * clusterGrid.x + slice * clusterGrid.x * clusterGrid.y).xy;
+
+	for (uint i = 0u; i < range.y; i++)
+	{
+		int light = int(texelFetch(clusterIndices, int(range.x + i)).x);
+		vec4 positionRadius = texelFetch(clusterLights, light * 2);
+		vec3 color = texelFetch(clusterLights, light * 2 + 1).rgb;
+
+		vec3 toLight = positionRadius.xyz - position;
+		float distance2 = max(dot(toLight, toLight), 1e-8);
+
+		// inverse square, windowed to reach 0 at the radius
+		float window = clamp(1.0 - pow(distance2 / (positionRadius.w * positionRadius.w), 2.0), 0.0, 1.0);
+		float attenuation = window * window / (distance2 + 1.0);
+
+		result += color * max(dot(normal, toLight * inversesqrt(distance2)), 0.0) * attenuation;
+	}
+
+	return result;
+}
+
+void main()
+{
+	FragColor = texture(starTextures, vec3(TexCoords, float(Layer)));
+
+	// stars glow on their own, neighbours add to it; a star's own light is behind its surface
+	FragColor.rgb += FragColor.rgb * clusteredLight(FragPos, normalize(Normal), ViewDepth);
+
+	if (Highlight != 0u)
+		FragColor.rgb = mix(FragColor.rgb, vec3(1.0), 0.5);
+}
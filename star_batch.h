@@ -0,0 +1,316 @@
+#ifndef STAR_BATCH_H
+#define STAR_BATCH_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "gl_extensions.h"
+#include "shader.h"
+#include "model.h"
+#include "mesh_pool.h"
+#include "gl_resources.h"
+#include "instance_ring.h"
+#include "clustered_lights.h"
+#include "journal_reader.h"
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+const int STAR_CLASS_COUNT = StarClass::GENERIC + 1;
+
+// O, B, A, F, G, K, L, M, T, Y, D, GENERIC, same palette as the star shaders
+const glm::vec3 STAR_CLASS_COLORS[STAR_CLASS_COUNT] = {
+	glm::vec3(0.61f, 0.69f, 1.00f), glm::vec3(0.67f, 0.75f, 1.00f), glm::vec3(0.79f, 0.84f, 1.00f), glm::vec3(0.97f, 0.97f, 1.00f),
+	glm::vec3(1.00f, 0.96f, 0.92f), glm::vec3(1.00f, 0.82f, 0.63f), glm::vec3(1.00f, 0.55f, 0.35f), glm::vec3(1.00f, 0.70f, 0.42f),
+	glm::vec3(0.80f, 0.35f, 0.30f), glm::vec3(0.55f, 0.25f, 0.30f), glm::vec3(0.90f, 0.93f, 1.00f), glm::vec3(1.00f, 1.00f, 1.00f)
+};
+
+// StarBatchInstance::packed, read back the same way in star_batch.vert
+const uint32_t STAR_BATCH_LAYER_MASK = 0xFF;
+const int STAR_BATCH_CLASS_SHIFT = 8;
+const uint32_t STAR_BATCH_HIGHLIGHT = 1u << 16;
+const int STAR_BATCH_SEED_SHIFT = 17;	// 15 bits, varies procedural surfaces per star
+
+// per-instance attributes, locations 5 to 7 in star_batch.vert
+struct StarBatchInstance {
+	float x, y, z;			// light years from Sol, rounded to float
+	float scale;			// 0 hides the star
+	float lowX, lowY, lowZ;	// what the rounding lost
+	uint32_t packed;		// texture array layer, StarClass, STAR_BATCH_HIGHLIGHT, seed
+};
+
+// Draws any number of stars of any class with one VAO, one texture binding and one draw call.
+// The star models are packed into a MeshPool and their surface textures into a TextureArray;
+// each frame the stars are bucketed by mesh, written to one instance buffer and submitted as a
+// single glMultiDrawElementsIndirect with one command per mesh in use. Without multi draw
+// indirect the same buffers are drawn with one glDrawElementsInstancedBaseVertex per mesh.
+//
+// The stars stay resident: SetStars() sorts them by mesh into an InstanceRing once, with
+// positions in light years split into float and rounding error, and the vertex shader makes
+// them camera-relative. Moving the camera uploads nothing; SetScale() / SetHighlight() rewrite
+// single records and only their blocks go out on the next Draw().
+class StarBatch
+{
+public:
+	StarBatch() : instances(sizeof(StarBatchInstance)), commandBuffer(0), drawCalls(0), uniformProgram(0)
+	{
+		for (int i = 0; i < STAR_CLASS_COUNT; i++)
+		{
+			classMesh[i] = -1;
+			classLayer[i] = 0;
+		}
+	}
+
+	~StarBatch()
+	{
+		glDeleteBuffers(1, &commandBuffer);
+	}
+
+	StarBatch(const StarBatch&) = delete;
+	StarBatch& operator=(const StarBatch&) = delete;
+
+	// Models shared by several classes are pooled once. The first diffuse texture of the model
+	// becomes its layer, fallbackColor fills the layer if that texture is missing.
+	void SetClassModel(StarClass starClass, const Model& model, glm::vec3 fallbackColor)
+	{
+		auto it = modelMesh.find(&model);
+
+		if (it == modelMesh.end())
+		{
+			std::string texturePath;
+
+			for (const Texture& texture : model.textures_loaded)
+			{
+				if (texture.type == "texture_diffuse")
+				{
+					texturePath = model.directory + '/' + texture.path;
+					break;
+				}
+			}
+
+			int mesh = pool.Add(model);
+			int layer = textures.AddLayer(texturePath, fallbackColor);
+			it = modelMesh.insert(std::make_pair(&model, std::make_pair(mesh, layer))).first;
+		}
+
+		classMesh[starClass] = it->second.first;
+		classLayer[starClass] = it->second.second;
+	}
+
+	// attributes read by the shader that will draw the batch, see ReflectVertexAttributes
+	void Upload(unsigned int attributes = VERTEX_ALL)
+	{
+		pool.Upload(attributes);
+		textures.Upload();
+
+		// at most one command per pooled mesh
+		commandBuffer = CreateBuffer(std::max(pool.GetMeshCount(), 1) * sizeof(DrawElementsIndirectCommand), NULL, GL_DYNAMIC_STORAGE_BIT);
+		instances.Resize(0);
+
+		VertexArrayBuilder builder(pool.GetVAO());
+		builder.Buffer(1, instances.ID, sizeof(StarBatchInstance), 1);
+		builder.Attribute(5, 1, 4, GL_FLOAT, GL_FALSE, 0);
+		builder.IntegerAttribute(6, 1, 1, GL_UNSIGNED_INT, offsetof(StarBatchInstance, packed));
+		builder.Attribute(7, 1, 3, GL_FLOAT, GL_FALSE, offsetof(StarBatchInstance, lowX));
+		builder.Finish();
+	}
+
+	// Replaces the whole set. Star i of coordinates keeps index i for SetScale / SetHighlight;
+	// stars of a class without a model are left out.
+	void SetStars(const std::vector<Coordinate>& coordinates, float scale)
+	{
+		std::vector<std::pair<int, uint32_t>> order;	// mesh, star
+
+		for (uint32_t i = 0; i < coordinates.size(); i++)
+			if (classMesh[coordinates[i].starClass] >= 0)
+				order.push_back(std::make_pair(classMesh[coordinates[i].starClass], i));
+
+		std::sort(order.begin(), order.end());
+
+		starRecord.assign(coordinates.size(), NO_RECORD);
+		instances.Resize(order.size());
+		commands.clear();
+
+		for (size_t record = 0; record < order.size(); record++)
+		{
+			const Coordinate& star = coordinates[order[record].second];
+			int mesh = order[record].first;
+
+			glm::vec3 high = glm::vec3(star.coords);
+			glm::vec3 low = glm::vec3(star.coords - glm::dvec3(high));
+
+			uint32_t packed = (uint32_t)classLayer[star.starClass] | ((uint32_t)star.starClass << STAR_BATCH_CLASS_SHIFT) | (seed(star.coords) << STAR_BATCH_SEED_SHIFT);
+
+			StarBatchInstance instance = { high.x, high.y, high.z, scale, low.x, low.y, low.z, packed };
+			std::memcpy(instances.Edit(record), &instance, sizeof(instance));
+			starRecord[order[record].second] = (uint32_t)record;
+
+			if (record == 0 || order[record - 1].first != mesh)
+			{
+				const MeshRange& range = pool.GetRange(mesh);
+
+				DrawElementsIndirectCommand command;
+				command.count = range.indexCount;
+				command.instanceCount = 0;
+				command.firstIndex = range.firstIndex;
+				command.baseVertex = range.baseVertex;
+				command.baseInstance = (GLuint)record;
+				commands.push_back(command);
+			}
+
+			commands.back().instanceCount++;
+		}
+
+		// the instance ranges never move, so the commands are written once per set
+		if (!commands.empty())
+			UpdateBuffer(commandBuffer, 0, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data());
+	}
+
+	// 0 hides the star
+	void SetScale(size_t star, float scale)
+	{
+		StarBatchInstance* instance = edit(star);
+
+		if (instance)
+			instance->scale = scale;
+	}
+
+	void SetHighlight(size_t star, bool highlight)
+	{
+		StarBatchInstance* instance = edit(star);
+
+		if (instance)
+			instance->packed = highlight ? (instance->packed | STAR_BATCH_HIGHLIGHT) : (instance->packed & ~STAR_BATCH_HIGHLIGHT);
+	}
+
+	// eye in light years, mapScale render units per light year; view / projection already set
+	void Draw(Shader& shader, const glm::dvec3& eye, double mapScale)
+	{
+		drawCalls = 0;
+
+		size_t instanceOffset = instances.Commit();
+
+		if (commands.empty())
+			return;
+
+		glm::vec3 eyeHigh = glm::vec3(eye);
+		glm::vec3 eyeLow = glm::vec3(eye - glm::dvec3(eyeHigh));
+
+		shader.use();
+		locate(shader.ID);
+
+		glState.Uniform1i(shader.ID, texturesLocation, 0);
+		ClusteredLights::SetTextureUnits(clusterUniforms);
+		glUniformMatrix4fv(dequantizeLocation, 1, GL_FALSE, &pool.GetDequantize()[0][0]);
+		glUniform3fv(eyeHighLocation, 1, &eyeHigh[0]);
+		glUniform3fv(eyeLowLocation, 1, &eyeLow[0]);
+		glUniform1f(mapScaleLocation, (float)mapScale);
+		glState.BindTexture(0, GL_TEXTURE_2D_ARRAY, textures.ID);
+
+		glState.BindVertexArray(pool.GetVAO());
+
+		if (GLAD_GL_ARB_multi_draw_indirect && GLAD_GL_ARB_base_instance)
+		{
+			setInstanceOffset(instanceOffset);
+
+			glState.BindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, (GLsizei)commands.size(), 0);
+			drawCalls = 1;
+		}
+		else
+		{
+			// no baseInstance on 3.3, the instance attributes are re-pointed per mesh instead
+			for (const DrawElementsIndirectCommand& command : commands)
+			{
+				setInstanceOffset(instanceOffset + command.baseInstance * sizeof(StarBatchInstance));
+				glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT, (void*)(command.firstIndex * sizeof(GLuint)), command.instanceCount, command.baseVertex);
+				drawCalls++;
+			}
+		}
+
+		instances.Fence();
+	}
+
+	// bytes of instance data the last Draw() uploaded
+	size_t GetUploadedBytes() const { return instances.GetCommittedBytes(); }
+
+	unsigned int GetDrawCalls() const { return drawCalls; }
+
+private:
+	MeshPool pool;
+	TextureArray textures;
+	std::map<const Model*, std::pair<int, int>> modelMesh;	// mesh, layer
+	int classMesh[STAR_CLASS_COUNT];
+	int classLayer[STAR_CLASS_COUNT];
+
+	static const uint32_t NO_RECORD = 0xFFFFFFFF;
+
+	std::vector<uint32_t> starRecord;	// star index -> record in instances
+	std::vector<DrawElementsIndirectCommand> commands;	// one per mesh in use, fixed by SetStars
+
+	InstanceRing instances;
+	unsigned int commandBuffer;
+	unsigned int drawCalls;
+
+	// uniform locations of the program last drawn with
+	GLuint uniformProgram;
+	GLint texturesLocation, dequantizeLocation, eyeHighLocation, eyeLowLocation, mapScaleLocation;
+	ClusterUniforms clusterUniforms;
+
+	// same star, same seed, every run
+	static uint32_t seed(const glm::dvec3& coords)
+	{
+		uint64_t h = 14695981039346656037ull;
+		unsigned char bytes[sizeof(coords)];
+		std::memcpy(bytes, &coords, sizeof(coords));
+
+		for (unsigned char c : bytes)
+			h = (h ^ c) * 1099511628211ull;
+
+		return (uint32_t)(h ^ (h >> 32)) & 0x7FFF;
+	}
+
+	void locate(GLuint program)
+	{
+		if (program == uniformProgram)
+			return;
+
+		uniformProgram = program;
+		texturesLocation = glGetUniformLocation(program, "starTextures");
+		dequantizeLocation = glGetUniformLocation(program, "meshDequantize");
+		eyeHighLocation = glGetUniformLocation(program, "eyeHigh");
+		eyeLowLocation = glGetUniformLocation(program, "eyeLow");
+		mapScaleLocation = glGetUniformLocation(program, "mapScale");
+		clusterUniforms.Locate(program);
+	}
+
+	StarBatchInstance* edit(size_t star)
+	{
+		if (star >= starRecord.size() || starRecord[star] == NO_RECORD)
+			return NULL;
+
+		return (StarBatchInstance*)instances.Edit(starRecord[star]);
+	}
+
+	// points instance binding 1 at a byte offset in instances, expects the pool VAO to be bound
+	void setInstanceOffset(size_t offset)
+	{
+		if (UseDirectStateAccess())
+		{
+			glVertexArrayVertexBuffer(pool.GetVAO(), 1, instances.ID, offset, sizeof(StarBatchInstance));
+		}
+		else
+		{
+			glState.BindBuffer(GL_ARRAY_BUFFER, instances.ID);
+			glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(StarBatchInstance), (void*)offset);
+			glVertexAttribIPointer(6, 1, GL_UNSIGNED_INT, sizeof(StarBatchInstance), (void*)(offset + offsetof(StarBatchInstance, packed)));
+			glVertexAttribPointer(7, 3, GL_FLOAT, GL_FALSE, sizeof(StarBatchInstance), (void*)(offset + offsetof(StarBatchInstance, lowX)));
+		}
+	}
+};
+
+#endif
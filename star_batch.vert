@@ -0,0 +1,41 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 5) in vec4 aPositionScale;	// per instance: light years from Sol as float, scale
+layout (location = 6) in uint aPacked;			// per instance: layer, class << 8, highlight << 16, seed << 17
+layout (location = 7) in vec3 aPositionLow;		// per instance: rounding error of aPositionScale.xyz
+
+out vec2 TexCoords;
+out vec3 FragPos;		// camera-relative render units
+out vec3 Normal;
+out float ViewDepth;
+flat out uint Layer;
+flat out uint StarClass;
+flat out uint Seed;
+flat out uint Highlight;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 meshDequantize;
+uniform vec3 eyeHigh;
+uniform vec3 eyeLow;
+uniform float mapScale;
+
+void main()
+{
+	TexCoords = aTexCoords;
+	Layer = aPacked & 0xFFu;
+	StarClass = (aPacked >> 8) & 0xFFu;
+	Highlight = (aPacked >> 16) & 1u;
+	Seed = aPacked >> 17;
+
+	// high parts first: close to the camera they cancel exactly and the low parts keep the detail
+	vec3 center = ((aPositionScale.xyz - eyeHigh) + (aPositionLow - eyeLow)) * mapScale;
+	FragPos = center + (meshDequantize * vec4(aPos, 1.0)).xyz * aPositionScale.w;
+	Normal = aNormal;
+
+	vec4 viewPosition = view * vec4(FragPos, 1.0);
+	ViewDepth = -viewPosition.z;
+	gl_Position = projection * viewPosition;
+}
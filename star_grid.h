@@ -0,0 +1,276 @@
+#ifndef STAR_GRID_H
+#define STAR_GRID_H
+
+#include <glm/glm.hpp>
+
+#include "star_store.h"
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+const int STAR_GRID_BITS = 21;				// per axis of a cell key
+const size_t STAR_GRID_MIN_TAIL = 4096;		// appended systems scanned linearly before a rebuild pays off
+const uint32_t STAR_GRID_NONE = UINT32_MAX;
+
+// Systems of a StarStore bucketed into a uniform grid of cubic cells, for the queries that only
+// care about what is near a point. Systems are kept in cell order, each cell one contiguous run
+// of slots, with their positions rounded to float side by side for the scans. Empty cells take
+// no memory, cells are looked up by key.
+//
+// Systems added to the store after Build() go into an unsorted tail of slots through Append(),
+// which every query also scans. NeedsRebuild() says when the tail has grown long enough that
+// sorting it in is cheaper than scanning it.
+class StarGrid
+{
+public:
+	StarGrid() : cellSize(0.0), sorted(0)
+	{
+	}
+
+	void Build(const StarStore& store, double size)
+	{
+		cellSize = size;
+
+		std::vector<std::pair<uint64_t, uint32_t>> keyed(store.Size());
+
+		for (size_t i = 0; i < store.Size(); i++)
+			keyed[i] = std::make_pair(key(cellOf(glm::vec3(store.GetPosition(i)))), (uint32_t)i);
+
+		std::sort(keyed.begin(), keyed.end());
+
+		positions.resize(keyed.size());
+		flags.resize(keyed.size());
+		ids.resize(keyed.size());
+		slots.assign(store.Size(), STAR_GRID_NONE);
+		cells.clear();
+		sorted = keyed.size();
+
+		for (size_t i = 0; i < keyed.size(); i++)
+			set((uint32_t)i, store, keyed[i].second);
+
+		// one cell per run of equal keys
+		for (size_t first = 0; first < keyed.size(); )
+		{
+			size_t end = first + 1;
+
+			while (end < keyed.size() && keyed[end].first == keyed[first].first)
+				end++;
+
+			cells[keyed[first].first] = Cell{ (uint32_t)first, (uint32_t)(end - first) };
+			first = end;
+		}
+	}
+
+	// a system the store gained since Build(), into the tail
+	void Append(const StarStore& store, uint32_t id)
+	{
+		uint32_t slot = (uint32_t)positions.size();
+
+		positions.push_back(glm::vec3());
+		flags.push_back(0);
+		ids.push_back(0);
+
+		if (slots.size() <= id)
+			slots.resize(id + 1, STAR_GRID_NONE);
+
+		set(slot, store, id);
+	}
+
+	bool NeedsRebuild() const
+	{
+		return GetTailSize() > std::max(STAR_GRID_MIN_TAIL, sorted / 64);
+	}
+
+	double GetCellSize() const { return cellSize; }
+	size_t Size() const { return positions.size(); }
+	size_t GetTailSize() const { return positions.size() - sorted; }
+	size_t GetCellCount() const { return cells.size(); }
+
+	// light years, rounded to float
+	const glm::vec3& GetPosition(uint32_t slot) const { return positions[slot]; }
+	uint8_t GetFlags(uint32_t slot) const { return flags[slot]; }
+	// store index of a slot and back, STAR_GRID_NONE for systems not in the grid
+	uint32_t GetId(uint32_t slot) const { return ids[slot]; }
+	uint32_t GetSlot(uint32_t id) const { return id < slots.size() ? slots[id] : STAR_GRID_NONE; }
+
+	// every slot within reach of center; cells wholly out of reach are skipped
+	template <typename F>
+	void ForEachWithin(const glm::vec3& center, float reach, F callback) const
+	{
+		glm::ivec3 low = cellOf(center - glm::vec3(reach));
+		glm::ivec3 high = cellOf(center + glm::vec3(reach));
+		float reach2 = reach * reach;
+		glm::dvec3 span = glm::dvec3(high - low) + 1.0;
+
+		// far reaching queries walk the occupied cells instead of every key in the box
+		if (span.x * span.y * span.z > (double)cells.size())
+		{
+			for (const auto& cell : cells)
+			{
+				glm::ivec3 c = cellFromKey(cell.first);
+
+				if (glm::all(glm::greaterThanEqual(c, low)) && glm::all(glm::lessThanEqual(c, high)) && reaches(c, center, reach2))
+					scanCell(cell.second, center, reach2, callback);
+			}
+		}
+		else
+		{
+			for (int z = low.z; z <= high.z; z++)
+			{
+				for (int y = low.y; y <= high.y; y++)
+				{
+					for (int x = low.x; x <= high.x; x++)
+					{
+						if (!reaches(glm::ivec3(x, y, z), center, reach2))
+							continue;
+
+						auto it = cells.find(key(glm::ivec3(x, y, z)));
+
+						if (it != cells.end())
+							scanCell(it->second, center, reach2, callback);
+					}
+				}
+			}
+		}
+
+		for (uint32_t i = (uint32_t)sorted; i < positions.size(); i++)
+		{
+			glm::vec3 d = positions[i] - center;
+
+			if (glm::dot(d, d) <= reach2)
+				callback(i);
+		}
+	}
+
+	// Store indices of the count systems nearest center, nearest first. The search radius
+	// doubles from one cell until it holds count systems or everything. Returns the distance to
+	// the farthest one returned, light years.
+	double Nearest(const glm::dvec3& center, size_t count, std::vector<uint32_t>& nearest) const
+	{
+		std::vector<std::pair<float, uint32_t>> found;
+		glm::vec3 origin = glm::vec3(center);
+		float reach = (float)cellSize;
+
+		nearest.clear();
+
+		if (positions.empty() || count == 0)
+			return 0.0;
+
+		while (true)
+		{
+			found.clear();
+
+			ForEachWithin(origin, reach, [&](uint32_t slot) {
+				glm::vec3 d = positions[slot] - origin;
+				found.push_back(std::make_pair(glm::dot(d, d), ids[slot]));
+			});
+
+			if (found.size() >= count || found.size() == positions.size())
+				break;
+
+			reach *= 2.0f;
+		}
+
+		if (found.size() > count)
+		{
+			std::nth_element(found.begin(), found.begin() + count, found.end());
+			found.resize(count);
+		}
+
+		std::sort(found.begin(), found.end());
+
+		nearest.reserve(found.size());
+
+		for (const auto& f : found)
+			nearest.push_back(f.second);
+
+		return std::sqrt((double)found.back().first);
+	}
+
+	// store index of the system called name at position, STAR_GRID_NONE if the grid has none
+	uint32_t Find(const StarStore& store, const glm::dvec3& position, const std::string& name) const
+	{
+		uint32_t match = STAR_GRID_NONE;
+
+		// float positions are good to a few thousandths of a light year across the galaxy
+		ForEachWithin(glm::vec3(position), 0.05f, [&](uint32_t slot) {
+			if (match == STAR_GRID_NONE && name == store.GetName(ids[slot]))
+				match = ids[slot];
+		});
+
+		return match;
+	}
+
+private:
+	struct Cell {
+		uint32_t first;
+		uint32_t count;
+	};
+
+	double cellSize;
+	size_t sorted;						// slots in cell order, the tail follows
+
+	std::vector<glm::vec3> positions;	// per slot
+	std::vector<uint8_t> flags;
+	std::vector<uint32_t> ids;
+	std::vector<uint32_t> slots;		// per store index
+	std::unordered_map<uint64_t, Cell> cells;
+
+	void set(uint32_t slot, const StarStore& store, uint32_t id)
+	{
+		positions[slot] = glm::vec3(store.GetPosition(id));
+		flags[slot] = store.stars[id].flags;
+		ids[slot] = id;
+		slots[id] = slot;
+	}
+
+	// whether any of cell c lies within reach
+	bool reaches(const glm::ivec3& c, const glm::vec3& center, float reach2) const
+	{
+		glm::vec3 cellLow = glm::vec3(glm::dvec3(c) * cellSize);
+		glm::vec3 nearestPoint = glm::clamp(center, cellLow, cellLow + glm::vec3((float)cellSize));
+		glm::vec3 offset = nearestPoint - center;
+
+		return glm::dot(offset, offset) <= reach2;
+	}
+
+	template <typename F>
+	void scanCell(const Cell& cell, const glm::vec3& center, float reach2, F& callback) const
+	{
+		for (uint32_t i = cell.first; i < cell.first + cell.count; i++)
+		{
+			glm::vec3 d = positions[i] - center;
+
+			if (glm::dot(d, d) <= reach2)
+				callback(i);
+		}
+	}
+
+	glm::ivec3 cellOf(const glm::vec3& position) const
+	{
+		return glm::ivec3(glm::floor(glm::dvec3(position) / cellSize));
+	}
+
+	static uint64_t key(const glm::ivec3& cell)
+	{
+		const int64_t bias = 1 << (STAR_GRID_BITS - 1);
+		const uint64_t mask = (1ull << STAR_GRID_BITS) - 1;
+
+		return ((uint64_t)(cell.x + bias) & mask) | (((uint64_t)(cell.y + bias) & mask) << STAR_GRID_BITS) | (((uint64_t)(cell.z + bias) & mask) << (2 * STAR_GRID_BITS));
+	}
+
+	static glm::ivec3 cellFromKey(uint64_t k)
+	{
+		const int64_t bias = 1 << (STAR_GRID_BITS - 1);
+		const uint64_t mask = (1ull << STAR_GRID_BITS) - 1;
+
+		return glm::ivec3((int)((int64_t)(k & mask) - bias), (int)((int64_t)((k >> STAR_GRID_BITS) & mask) - bias), (int)((int64_t)((k >> (2 * STAR_GRID_BITS)) & mask) - bias));
+	}
+};
+
+#endif
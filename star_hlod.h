@@ -0,0 +1,520 @@
+#ifndef STAR_HLOD_H
+#define STAR_HLOD_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_access.hpp>
+
+#include "shader.h"
+#include "camera.h"
+#include "gl_state.h"
+#include "gl_resources.h"
+#include "star_store.h"
+#include "star_batch.h"
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+#include <cstdint>
+
+const uint32_t STAR_HLOD_LEAF_SIZE = 64;		// stars per leaf cell at most
+const unsigned int STAR_HLOD_MAX_DEPTH = 24;	// cells below ~1e-3 ly of a 30000 ly galaxy stay leaves
+
+// rough luminosity per StarClass in solar units, only the ratios matter for the glow
+const float STAR_CLASS_LUMINOSITY[STAR_CLASS_COUNT] = {
+	30000.0f, 800.0f, 20.0f, 3.0f, 1.0f, 0.3f, 0.0003f, 0.04f, 0.00003f, 0.000003f, 100000.0f, 1.0f
+};
+
+// One cell of the hierarchy. Its members are the stars [firstStar, firstStar + starCount) of
+// StarHlodTree::GetStars(), so any cell can stand in for a contiguous range.
+struct StarHlodNode {
+	glm::dvec3 centroid;	// luminosity-weighted, light years
+	double radius;			// every member lies within, light years
+	float luminosity;		// sum over the members
+	uint32_t firstStar;
+	uint32_t starCount;
+	uint32_t firstChild;	// children are stored contiguously
+	uint8_t childCount;		// 0 for leaves
+	uint8_t dominantClass;	// StarClass with the largest share of the luminosity
+};
+
+// per vertex of the star buffer, locations 0 and 1 in star_hlod_points.vert
+struct StarHlodVertex {
+	float x, y, z;			// light years from Sol, rounded to float
+	uint32_t starClass;
+};
+
+// per cluster drawn, locations 0 to 2 in star_hlod_glow.vert
+struct StarHlodGlow {
+	glm::vec4 positionRadius;	// camera-relative render units
+	glm::vec4 colorLuminosity;	// dominant class colour, mean luminosity of the members
+	float starCount;
+};
+
+// Octree over a StarStore with aggregates per cell, built once on the CPU. Stars are reordered
+// so each cell's members are contiguous, a cell is then either one glow or one range of points.
+class StarHlodTree
+{
+public:
+	void Build(const StarStore& store)
+	{
+		nodes.clear();
+		stars.resize(store.Size());
+
+		for (size_t i = 0; i < store.Size(); i++)
+		{
+			stars[i].x = (float)store.stars[i].x;
+			stars[i].y = (float)store.stars[i].y;
+			stars[i].z = (float)store.stars[i].z;
+			stars[i].starClass = store.stars[i].starClass;
+		}
+
+		if (stars.empty())
+			return;
+
+		glm::dvec3 lo(1e30), hi(-1e30);
+
+		for (const StarHlodVertex& s : stars)
+		{
+			lo = glm::min(lo, position(s));
+			hi = glm::max(hi, position(s));
+		}
+
+		glm::dvec3 center = (lo + hi) * 0.5;
+		double halfSize = std::max(std::max(hi.x - lo.x, hi.y - lo.y), hi.z - lo.z) * 0.5 + 1.0;
+
+		nodes.push_back(StarHlodNode());
+		build(0, 0, (uint32_t)stars.size(), center, halfSize, 0);
+
+		std::cout << "Star HLOD: " << stars.size() << " stars in " << nodes.size() << " cells" << std::endl;
+	}
+
+	const std::vector<StarHlodNode>& GetNodes() const { return nodes; }
+	// the store's stars in tree order
+	const std::vector<StarHlodVertex>& GetStars() const { return stars; }
+
+	// the stars once they are on the GPU, only the nodes are needed to draw
+	void ReleaseStars()
+	{
+		std::vector<StarHlodVertex>().swap(stars);
+	}
+
+private:
+	std::vector<StarHlodNode> nodes;
+	std::vector<StarHlodVertex> stars;
+
+	static glm::dvec3 position(const StarHlodVertex& s)
+	{
+		return glm::dvec3(s.x, s.y, s.z);
+	}
+
+	// fills nodes[index] from stars [first, first + count), returns the luminosity per class
+	std::vector<double> build(uint32_t index, uint32_t first, uint32_t count, const glm::dvec3& center, double halfSize, unsigned int depth)
+	{
+		nodes[index].firstStar = first;
+		nodes[index].starCount = count;
+		nodes[index].firstChild = 0;
+		nodes[index].childCount = 0;
+
+		std::vector<double> classLuminosity(STAR_CLASS_COUNT, 0.0);
+		StarHlodVertex* begin = stars.data() + first;
+		StarHlodVertex* end = begin + count;
+
+		if (count <= STAR_HLOD_LEAF_SIZE || depth >= STAR_HLOD_MAX_DEPTH)
+		{
+			glm::dvec3 weighted(0.0);
+			double total = 0.0;
+
+			for (StarHlodVertex* s = begin; s != end; s++)
+			{
+				double luminosity = STAR_CLASS_LUMINOSITY[std::min(s->starClass, (uint32_t)STAR_CLASS_COUNT - 1)];
+				weighted += position(*s) * luminosity;
+				total += luminosity;
+				classLuminosity[std::min(s->starClass, (uint32_t)STAR_CLASS_COUNT - 1)] += luminosity;
+			}
+
+			nodes[index].centroid = weighted / total;
+			nodes[index].radius = 0.0;
+
+			for (StarHlodVertex* s = begin; s != end; s++)
+				nodes[index].radius = std::max(nodes[index].radius, glm::length(position(*s) - nodes[index].centroid));
+
+			finish(nodes[index], classLuminosity);
+			return classLuminosity;
+		}
+
+		// octants in order, x splits first, then y within each half, then z within each quarter
+		StarHlodVertex* bounds[9];
+		bounds[0] = begin;
+		bounds[8] = end;
+		bounds[4] = std::partition(begin, end, [&](const StarHlodVertex& s) { return s.x < center.x; });
+		bounds[2] = std::partition(begin, bounds[4], [&](const StarHlodVertex& s) { return s.y < center.y; });
+		bounds[6] = std::partition(bounds[4], end, [&](const StarHlodVertex& s) { return s.y < center.y; });
+
+		for (int i = 0; i < 8; i += 2)
+			bounds[i + 1] = std::partition(bounds[i], bounds[i + 2], [&](const StarHlodVertex& s) { return s.z < center.z; });
+
+		// bounds[i] .. bounds[i + 1] has x >= center for i & 4, y for i & 2, z for i & 1
+		uint32_t firstChild = (uint32_t)nodes.size();
+		uint8_t childCount = 0;
+
+		for (int i = 0; i < 8; i++)
+		{
+			if (bounds[i + 1] > bounds[i])
+			{
+				nodes.push_back(StarHlodNode());
+				childCount++;
+			}
+		}
+
+		nodes[index].firstChild = firstChild;
+		nodes[index].childCount = childCount;
+
+		uint32_t child = firstChild;
+		double q = halfSize * 0.5;
+
+		for (int i = 0; i < 8; i++)
+		{
+			if (bounds[i + 1] == bounds[i])
+				continue;
+
+			glm::dvec3 childCenter = center + glm::dvec3((i & 4) ? q : -q, (i & 2) ? q : -q, (i & 1) ? q : -q);
+			std::vector<double> childLuminosity = build(child++, (uint32_t)(bounds[i] - stars.data()), (uint32_t)(bounds[i + 1] - bounds[i]), childCenter, q, depth + 1);
+
+			for (int c = 0; c < STAR_CLASS_COUNT; c++)
+				classLuminosity[c] += childLuminosity[c];
+		}
+
+		// the children's aggregates are enough, no second pass over the members
+		glm::dvec3 weighted(0.0);
+		double total = 0.0;
+
+		for (uint32_t c = firstChild; c < firstChild + childCount; c++)
+		{
+			weighted += nodes[c].centroid * (double)nodes[c].luminosity;
+			total += nodes[c].luminosity;
+		}
+
+		StarHlodNode& node = nodes[index];
+		node.centroid = weighted / total;
+		node.radius = 0.0;
+
+		for (uint32_t c = firstChild; c < firstChild + childCount; c++)
+			node.radius = std::max(node.radius, glm::length(nodes[c].centroid - node.centroid) + nodes[c].radius);
+
+		finish(node, classLuminosity);
+		return classLuminosity;
+	}
+
+	static void finish(StarHlodNode& node, const std::vector<double>& classLuminosity)
+	{
+		double total = 0.0;
+		int dominant = 0;
+
+		for (int c = 0; c < STAR_CLASS_COUNT; c++)
+		{
+			total += classLuminosity[c];
+			if (classLuminosity[c] > classLuminosity[dominant])
+				dominant = c;
+		}
+
+		node.luminosity = (float)total;
+		node.dominantClass = (uint8_t)dominant;
+	}
+};
+
+// Draws a StarHlodTree as a cut through the hierarchy. Update() refines the largest cells on
+// screen first (bucketed by quarter octaves, a heap costs more than it sorts): a cell below
+// glowPixelRadius, or one whose refinement would exceed primitiveBudget, is drawn as a single
+// additive glow in its dominant class colour, as bright as its members' points would make that
+// patch of screen; a leaf that is refined draws its members as points. However many stars the
+// store holds, a frame draws at most primitiveBudget points and glows and issues one
+// glMultiDrawArrays for the points plus one draw for the glows.
+class StarHlodRenderer
+{
+public:
+	float glowPixelRadius = 6.0f;			// cells smaller than this on screen are merged
+	size_t primitiveBudget = 262144;		// points plus glows per frame
+	float pointSize = 2.0f;
+
+	StarHlodRenderer() : starVAO(0), starVBO(0), glowVAO(0), glowVBO(0), glowCapacity(0), pixelScale(0.0f), drawnStars(0), topBucket(-1), used(0)
+	{
+	}
+
+	~StarHlodRenderer()
+	{
+		glDeleteVertexArrays(1, &starVAO);
+		glDeleteBuffers(1, &starVBO);
+		glDeleteVertexArrays(1, &glowVAO);
+		glDeleteBuffers(1, &glowVBO);
+	}
+
+	StarHlodRenderer(const StarHlodRenderer&) = delete;
+	StarHlodRenderer& operator=(const StarHlodRenderer&) = delete;
+
+	// the tree is kept by reference and must outlive the renderer
+	void Upload(const StarHlodTree& hlodTree)
+	{
+		tree = &hlodTree;
+		const std::vector<StarHlodVertex>& stars = tree->GetStars();
+
+		glDeleteVertexArrays(1, &starVAO);
+		glDeleteBuffers(1, &starVBO);
+		starVBO = CreateBuffer(stars.size() * sizeof(StarHlodVertex), stars.data());
+
+		VertexArrayBuilder builder;
+		builder.Buffer(0, starVBO, sizeof(StarHlodVertex));
+		builder.Attribute(0, 0, 3, GL_FLOAT, GL_FALSE, offsetof(StarHlodVertex, x));
+		builder.IntegerAttribute(1, 0, 1, GL_UNSIGNED_INT, offsetof(StarHlodVertex, starClass));
+		starVAO = builder.Finish();
+	}
+
+	// eye in light years, view/projection as used for drawing, viewportHeight in pixels
+	void Update(const glm::dvec3& eye, double mapScale, const glm::mat4& view, const glm::mat4& projection, int viewportHeight)
+	{
+		firsts.clear();
+		counts.clear();
+		glows.clear();
+		drawnStars = 0;
+
+		if (!tree || tree->GetNodes().empty())
+			return;
+
+		this->eye = eye;
+		this->mapScale = mapScale;
+		pixelScale = projection[1][1] * viewportHeight * 0.5f;
+
+		// same planes as GpuStarCuller, the far plane is at infinity
+		glm::mat4 viewProjection = projection * view;
+		planes[0] = glm::row(viewProjection, 3) + glm::row(viewProjection, 0);
+		planes[1] = glm::row(viewProjection, 3) - glm::row(viewProjection, 0);
+		planes[2] = glm::row(viewProjection, 3) + glm::row(viewProjection, 1);
+		planes[3] = glm::row(viewProjection, 3) - glm::row(viewProjection, 1);
+		planes[4] = glm::vec4(-glm::vec3(glm::row(view, 2)), -NEAR_PLANE);
+
+		for (int i = 0; i < 4; i++)
+			planes[i] /= glm::length(glm::vec3(planes[i]));
+
+		const std::vector<StarHlodNode>& nodes = tree->GetNodes();
+
+		used = 0;
+		topBucket = -1;
+		consider(0, ALL_PLANES);
+
+		while (topBucket >= 0)
+		{
+			uint32_t entry = buckets[topBucket].back();
+			buckets[topBucket].pop_back();
+
+			while (topBucket >= 0 && buckets[topBucket].empty())
+				topBucket--;
+
+			const StarHlodNode& node = nodes[entry & INDEX_MASK];
+			size_t refined = node.childCount ? node.childCount : node.starCount;
+
+			// the cell is already counted, refining costs at most this much more
+			if (used - 1 + refined > primitiveBudget)
+			{
+				addGlow(node);
+				continue;
+			}
+
+			if (node.childCount == 0)
+			{
+				used += refined - 1;
+				addRange(node.firstStar, node.starCount);
+				continue;
+			}
+
+			used--;
+
+			for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; c++)
+				consider(c, entry >> PLANE_SHIFT);
+		}
+
+		if (glows.empty())
+			return;
+
+		// the glows are rewritten every frame, new storage only when they outgrow it
+		size_t bytes = glows.size() * sizeof(StarHlodGlow);
+
+		if (bytes > glowCapacity)
+		{
+			glDeleteBuffers(1, &glowVBO);
+			glowCapacity = bytes * 2;
+			glowVBO = CreateBuffer(glowCapacity, NULL, GL_DYNAMIC_STORAGE_BIT);
+
+			VertexArrayBuilder builder(glowVAO);
+			builder.Buffer(0, glowVBO, sizeof(StarHlodGlow));
+			builder.Attribute(0, 0, 4, GL_FLOAT, GL_FALSE, offsetof(StarHlodGlow, positionRadius));
+			builder.Attribute(1, 0, 4, GL_FLOAT, GL_FALSE, offsetof(StarHlodGlow, colorLuminosity));
+			builder.Attribute(2, 0, 1, GL_FLOAT, GL_FALSE, offsetof(StarHlodGlow, starCount));
+			glowVAO = builder.Finish();
+		}
+
+		UpdateBuffer(glowVBO, 0, bytes, glows.data());
+	}
+
+	// the cut of the last Update(); projection and view are set by the caller on both shaders
+	void Draw(Shader& pointShader, Shader& glowShader)
+	{
+		glState.Enable(GL_PROGRAM_POINT_SIZE);
+
+		if (!firsts.empty())
+		{
+			// the eye is split into a float and the float rounding error as in GpuStarCuller
+			glm::vec3 eyeHigh = glm::vec3(eye);
+			glm::vec3 eyeLow = glm::vec3(eye - glm::dvec3(eyeHigh));
+
+			pointShader.use();
+			pointShader.setVec3("eyeHigh", eyeHigh);
+			pointShader.setVec3("eyeLow", eyeLow);
+			pointShader.setFloat("mapScale", (float)mapScale);
+			pointShader.setFloat("pointSize", pointSize);
+
+			glState.BindVertexArray(starVAO);
+			glMultiDrawArrays(GL_POINTS, firsts.data(), counts.data(), (GLsizei)firsts.size());
+		}
+
+		if (!glows.empty())
+		{
+			// glows add up and never hide what is behind them
+			glState.Enable(GL_BLEND);
+			glBlendFunc(GL_ONE, GL_ONE);
+			glDepthMask(GL_FALSE);
+
+			glowShader.use();
+			glowShader.setFloat("pixelScale", pixelScale);
+			glowShader.setFloat("pointSize", pointSize);
+
+			glState.BindVertexArray(glowVAO);
+			glDrawArrays(GL_POINTS, 0, (GLsizei)glows.size());
+
+			glDepthMask(GL_TRUE);
+			glState.Disable(GL_BLEND);
+		}
+
+		glState.Disable(GL_PROGRAM_POINT_SIZE);
+	}
+
+	size_t GetDrawnStars() const { return drawnStars; }
+	size_t GetDrawnGlows() const { return glows.size(); }
+	size_t GetPointRanges() const { return firsts.size(); }
+
+private:
+	const StarHlodTree* tree = NULL;
+	unsigned int starVAO;
+	unsigned int starVBO;
+	unsigned int glowVAO;
+	unsigned int glowVBO;
+	size_t glowCapacity;
+
+	glm::dvec3 eye;
+	double mapScale = 1.0;
+	float pixelScale;
+	glm::vec4 planes[5];
+
+	std::vector<GLint> firsts;
+	std::vector<GLsizei> counts;
+	std::vector<StarHlodGlow> glows;
+	size_t drawnStars;
+
+	// refinement queue: one bucket per quarter octave of projected size above glowPixelRadius,
+	// entries are node index | planes still to test << PLANE_SHIFT
+	enum { BUCKETS = 96, PLANE_SHIFT = 27, ALL_PLANES = 31 };
+	static const uint32_t INDEX_MASK = (1u << PLANE_SHIFT) - 1u;
+	std::vector<uint32_t> buckets[BUCKETS];
+	int topBucket;
+	size_t used;	// points and glows of the cut so far, queued cells count as one
+
+	float projectedRadius(const StarHlodNode& node) const
+	{
+		double distance = glm::length(node.centroid - eye) - node.radius;
+
+		// the camera is inside: always refine
+		if (distance <= 0.0)
+			return 1e30f;
+
+		return (float)(node.radius * pixelScale / distance);
+	}
+
+	// planeMask: the planes the parent was not entirely inside of, cleared for those this cell is
+	bool visible(const StarHlodNode& node, uint32_t& planeMask) const
+	{
+		glm::vec3 center = glm::vec3((node.centroid - eye) * mapScale);
+		float radius = (float)(node.radius * mapScale);
+
+		for (int i = 0; i < 5; i++)
+		{
+			if (!(planeMask & (1u << i)))
+				continue;
+
+			float distance = glm::dot(glm::vec3(planes[i]), center) + planes[i].w;
+
+			if (distance < -radius)
+				return false;
+			if (distance > radius)
+				planeMask &= ~(1u << i);
+		}
+
+		return true;
+	}
+
+	// A visible cell becomes a glow right away when it is small enough, everything else is
+	// queued for refinement. Single stars are always drawn as themselves.
+	void consider(uint32_t index, uint32_t planeMask)
+	{
+		const StarHlodNode& node = tree->GetNodes()[index];
+
+		if (!visible(node, planeMask))
+			return;
+
+		used++;
+
+		if (node.starCount == 1)
+		{
+			addRange(node.firstStar, 1);
+			return;
+		}
+
+		float radius = projectedRadius(node);
+
+		if (radius <= glowPixelRadius)
+		{
+			addGlow(node);
+			return;
+		}
+
+		int bucket = std::min((int)(std::log2(radius / glowPixelRadius) * 4.0f), (int)BUCKETS - 1);
+		buckets[bucket].push_back(index | (planeMask << PLANE_SHIFT));
+		topBucket = std::max(topBucket, bucket);
+	}
+
+	void addGlow(const StarHlodNode& node)
+	{
+		StarHlodGlow glow;
+		glow.positionRadius = glm::vec4(glm::vec3((node.centroid - eye) * mapScale), (float)(node.radius * mapScale));
+		glow.colorLuminosity = glm::vec4(STAR_CLASS_COLORS[node.dominantClass], node.luminosity / node.starCount);
+		glow.starCount = (float)node.starCount;
+		glows.push_back(glow);
+	}
+
+	// siblings are adjacent in the star buffer, so a refined cell often continues the last range
+	void addRange(uint32_t first, uint32_t count)
+	{
+		drawnStars += count;
+
+		if (!firsts.empty() && (uint32_t)(firsts.back() + counts.back()) == first)
+		{
+			counts.back() += count;
+			return;
+		}
+
+		firsts.push_back((GLint)first);
+		counts.push_back((GLsizei)count);
+	}
+};
+
+#endif
@@ -0,0 +1,17 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 Color;
+in float Intensity;
+
+void main()
+{
+	vec2 d = gl_PointCoord * 2.0 - 1.0;
+	float r2 = dot(d, d);
+
+	if (r2 > 1.0)
+		discard;
+
+	// gaussian falloff with the same total as a flat disc of Intensity, added on top of what is behind
+	FragColor = vec4(Color * Intensity * 4.0 * exp(-4.0 * r2), 1.0);
+}
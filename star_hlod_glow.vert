@@ -0,0 +1,30 @@
+#version 330 core
+layout (location = 0) in vec4 aPositionRadius;		// camera-relative center and radius of the cell
+layout (location = 1) in vec4 aColorLuminosity;	// dominant class colour, mean luminosity
+layout (location = 2) in float aStarCount;
+
+out vec3 Color;
+out float Intensity;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform float pixelScale;	// pixels per render unit at distance 1
+uniform float pointSize;	// of a single star
+
+void main()
+{
+	vec4 viewPosition = view * vec4(aPositionRadius.xyz, 1.0);
+	gl_Position = projection * viewPosition;
+
+	// the cell's footprint, never smaller than a star point
+	gl_PointSize = max(2.0 * aPositionRadius.w * pixelScale / max(-viewPosition.z, 1e-6), pointSize);
+
+	// As bright as the member points would leave the footprint: full where they cover it, the
+	// covered share where they would not. Luminosity spans ten orders of magnitude and only
+	// tints that by its logarithm.
+	float coverage = min(aStarCount * pointSize * pointSize / (gl_PointSize * gl_PointSize), 1.0);
+	float brightness = clamp(0.7 + 0.05 * log2(aColorLuminosity.a), 0.3, 1.5);
+
+	Color = aColorLuminosity.rgb;
+	Intensity = brightness * coverage;
+}
@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;			// light years from Sol
+layout (location = 1) in uint aStarClass;
+
+out vec3 Color;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform vec3 eyeHigh;		// camera position in light years, float part
+uniform vec3 eyeLow;		// and what the float lost
+uniform float mapScale;		// render units per light year
+uniform float pointSize;
+
+// O, B, A, F, G, K, L, M, T, Y, D, GENERIC
+const vec3 classColors[12] = vec3[](
+	vec3(0.61, 0.69, 1.00), vec3(0.67, 0.75, 1.00), vec3(0.79, 0.84, 1.00), vec3(0.97, 0.97, 1.00),
+	vec3(1.00, 0.96, 0.92), vec3(1.00, 0.82, 0.63), vec3(1.00, 0.55, 0.35), vec3(1.00, 0.70, 0.42),
+	vec3(0.80, 0.35, 0.30), vec3(0.55, 0.25, 0.30), vec3(0.90, 0.93, 1.00), vec3(1.00, 1.00, 1.00));
+
+void main()
+{
+	Color = classColors[min(aStarClass, 11u)];
+	gl_Position = projection * view * vec4(((aPos - eyeHigh) - eyeLow) * mapScale, 1.0);
+	gl_PointSize = pointSize;
+}
@@ -0,0 +1,35 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 RayTarget;
+flat in vec3 Center;
+flat in float Radius;
+flat in vec3 Color;
+
+uniform mat4 projection;
+uniform int depthZeroToOne;		// glClipControl(GL_ZERO_TO_ONE) is in effect
+
+void main()
+{
+	// ray from the eye (the view space origin) through this pixel
+	vec3 direction = normalize(RayTarget);
+	float along = dot(direction, Center);
+
+	// distance of the ray from the center, taken perpendicular so it stays exact far away
+	vec3 miss = Center - direction * along;
+	float h = Radius * Radius - dot(miss, miss);
+
+	if (h < 0.0)
+		discard;
+
+	vec3 hit = direction * (along - sqrt(h));
+	vec3 normal = (hit - Center) / Radius;
+
+	vec4 clip = projection * vec4(hit, 1.0);
+	float depth = clip.z / clip.w;
+	gl_FragDepth = depthZeroToOne != 0 ? depth : depth * 0.5 + 0.5;
+
+	// same limb darkening as star_instanced.frag
+	float mu = clamp(normal.z, 0.0, 1.0);
+	FragColor = vec4(Color * (0.4 + 0.6 * mu), 1.0);
+}
@@ -0,0 +1,37 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;				// quad corner, x and y in [-1, 1]
+layout (location = 1) in vec4 aPositionScale;	// per instance: camera-relative center, radius
+layout (location = 2) in uint aStarClass;		// per instance
+
+out vec3 RayTarget;		// view space point on the quad
+flat out vec3 Center;	// view space
+flat out float Radius;
+flat out vec3 Color;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+// O, B, A, F, G, K, L, M, T, Y, D, GENERIC
+const vec3 classColors[12] = vec3[](
+	vec3(0.61, 0.69, 1.00), vec3(0.67, 0.75, 1.00), vec3(0.79, 0.84, 1.00), vec3(0.97, 0.97, 1.00),
+	vec3(1.00, 0.96, 0.92), vec3(1.00, 0.82, 0.63), vec3(1.00, 0.55, 0.35), vec3(1.00, 0.70, 0.42),
+	vec3(0.80, 0.35, 0.30), vec3(0.55, 0.25, 0.30), vec3(0.90, 0.93, 1.00), vec3(1.00, 1.00, 1.00));
+
+void main()
+{
+	Center = (view * vec4(aPositionScale.xyz, 1.0)).xyz;
+	Radius = aPositionScale.w;
+	Color = classColors[min(aStarClass, 11u)];
+
+	// The quad goes through the center, square to the line of sight. Rays touching the sphere
+	// form a cone that cuts this plane in a circle of radius r * d / sqrt(d^2 - r^2), the quad
+	// covers exactly that circle.
+	float distance = length(Center);
+	vec3 forward = Center / distance;
+	vec3 right = normalize(cross(forward, abs(forward.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0)));
+	vec3 up = cross(right, forward);
+	float halfSize = Radius * distance / sqrt(max(distance * distance - Radius * Radius, 1e-12));
+
+	RayTarget = Center + (right * aPos.x + up * aPos.y) * halfSize;
+	gl_Position = projection * vec4(RayTarget, 1.0);
+}
@@ -0,0 +1,12 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 Normal;
+in vec3 Color;
+
+void main()
+{
+	// limb darkening: the disc fades towards the edge as seen from the camera
+	float mu = clamp(normalize(Normal).z, 0.0, 1.0);
+	FragColor = vec4(Color * (0.4 + 0.6 * mu), 1.0);
+}
@@ -0,0 +1,23 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;				// unit sphere, doubles as the normal
+layout (location = 1) in vec4 aPositionScale;	// per instance: camera-relative center, radius
+layout (location = 2) in uint aStarClass;		// per instance
+
+out vec3 Normal;
+out vec3 Color;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+// O, B, A, F, G, K, L, M, T, Y, D, GENERIC
+const vec3 classColors[12] = vec3[](
+	vec3(0.61, 0.69, 1.00), vec3(0.67, 0.75, 1.00), vec3(0.79, 0.84, 1.00), vec3(0.97, 0.97, 1.00),
+	vec3(1.00, 0.96, 0.92), vec3(1.00, 0.82, 0.63), vec3(1.00, 0.55, 0.35), vec3(1.00, 0.70, 0.42),
+	vec3(0.80, 0.35, 0.30), vec3(0.55, 0.25, 0.30), vec3(0.90, 0.93, 1.00), vec3(1.00, 1.00, 1.00));
+
+void main()
+{
+	Normal = mat3(view) * aPos;
+	Color = classColors[min(aStarClass, 11u)];
+	gl_Position = projection * view * vec4(aPositionScale.xyz + aPos * aPositionScale.w, 1.0);
+}
@@ -0,0 +1,350 @@
+#ifndef STAR_PICKER_H
+#define STAR_PICKER_H
+
+#include <glm/glm.hpp>
+
+#include "star_store.h"
+
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+#include <cstdint>
+
+const size_t STAR_PICK_NONE = (size_t)-1;
+const uint32_t STAR_PICK_LEAF_SIZE = 4;		// stars per leaf at most
+const int STAR_PICK_STACK_SIZE = 64;		// a median split tree over 2^32 stars is 31 deep
+
+// one sphere of the bounding volume hierarchy, members are [first, first + count) in tree order
+struct StarPickNode {
+	glm::dvec3 center;	// light years
+	double radius;		// every member's sphere lies within, light years
+	uint32_t first;		// inner nodes: index of the first of two adjacent children
+	uint32_t count;		// 0 for inner nodes
+};
+
+// previous and current star index into the StarStore the picker was built from, either may be
+// STAR_PICK_NONE
+typedef std::function<void(size_t previous, size_t current)> StarPickListener;
+
+// Finds the star under the cursor by casting a ray through a bounding sphere hierarchy over the
+// store, or the part of it given to Build(). Every star is a sphere of starRadius; stars too small to aim at are
+// still hit within pixelTolerance of the ray, so the test is really a thin cone. A true hit
+// wins over a near miss, the nearest true hit or the smallest angular miss over the others.
+// Subtrees that cannot beat the best so far are skipped, which keeps a pick to a few hundred
+// nodes however many stars there are.
+//
+// UpdateHover() once per frame and Select() on a click keep the hovered and selected stars and
+// tell whoever subscribed through OnHover() / OnSelect() when either changes.
+class StarPicker
+{
+public:
+	double starRadius = 0.5;		// light years, as large as the drawn spheres
+	float pixelTolerance = 4.0f;	// a ray passing this close on screen still picks the star
+
+	StarPicker() : hovered(STAR_PICK_NONE), selected(STAR_PICK_NONE), visitedNodes(0)
+	{
+	}
+
+	void Build(const StarStore& store)
+	{
+		std::vector<uint32_t> members(store.Size());
+
+		for (size_t i = 0; i < members.size(); i++)
+			members[i] = (uint32_t)i;
+
+		Build(store, members);
+	}
+
+	// Only the members (store indices) can be picked. The hovered and selected stars are store
+	// indices too, they stay as they are when the picker is rebuilt over the same store.
+	void Build(const StarStore& store, const std::vector<uint32_t>& members)
+	{
+		nodes.clear();
+		stars.resize(members.size());
+
+		for (size_t i = 0; i < members.size(); i++)
+		{
+			stars[i].position = store.GetPosition(members[i]);
+			stars[i].id = members[i];
+		}
+
+		if (stars.empty())
+			return;
+
+		nodes.reserve(stars.size() / STAR_PICK_LEAF_SIZE * 2 + 1);
+		nodes.push_back(StarPickNode());
+		build(0, 0, (uint32_t)stars.size());
+
+		std::cout << "Star picker: " << stars.size() << " stars in " << nodes.size() << " nodes" << std::endl;
+	}
+
+	// One more member without building again. It goes into the leaf whose centre is nearest,
+	// filling it while the leaf is the last range of stars and splitting it in two otherwise,
+	// and the spheres on the way up are grown to fit. A tree that gets too deep for Pick()'s
+	// stack is built again.
+	void Append(const StarStore& store, uint32_t id)
+	{
+		Star star;
+		star.position = store.GetPosition(id);
+		star.id = id;
+
+		uint32_t path[STAR_PICK_STACK_SIZE];
+		int depth = 0;
+		uint32_t index = 0;
+
+		while (!nodes.empty() && nodes[index].count == 0)
+		{
+			path[depth++] = index;
+
+			const StarPickNode& node = nodes[index];
+			bool second = glm::length(nodes[node.first + 1].center - star.position) < glm::length(nodes[node.first].center - star.position);
+			index = node.first + (second ? 1 : 0);
+		}
+
+		// deep enough to overflow Pick() after a split
+		if (nodes.empty() || depth + 2 >= STAR_PICK_STACK_SIZE)
+		{
+			std::vector<uint32_t> members(stars.size() + 1);
+
+			for (size_t i = 0; i < stars.size(); i++)
+				members[i] = stars[i].id;
+
+			members.back() = id;
+			Build(store, members);
+			return;
+		}
+
+		StarPickNode& leaf = nodes[index];
+
+		if (leaf.count < STAR_PICK_LEAF_SIZE && leaf.first + leaf.count == stars.size())
+		{
+			leaf.count++;
+			leaf.radius = std::max(leaf.radius, glm::length(star.position - leaf.center) + starRadius);
+		}
+		else
+		{
+			// the leaf becomes the parent of itself and a leaf of the new star
+			StarPickNode single;
+			single.center = star.position;
+			single.radius = starRadius;
+			single.first = (uint32_t)stars.size();
+			single.count = 1;
+
+			uint32_t children = (uint32_t)nodes.size();
+			nodes.push_back(leaf);
+			nodes.push_back(single);
+
+			nodes[index].first = children;
+			nodes[index].count = 0;
+			path[depth++] = index;
+		}
+
+		stars.push_back(star);
+
+		for (int i = depth - 1; i >= 0; i--)
+		{
+			StarPickNode& node = nodes[path[i]];
+
+			for (uint32_t c = node.first; c < node.first + 2; c++)
+				node.radius = std::max(node.radius, glm::length(nodes[c].center - node.center) + nodes[c].radius);
+		}
+	}
+
+	// Origin in light years. coneSlope widens the hit radius by that much per light year along
+	// the ray. Returns the store index or STAR_PICK_NONE.
+	size_t Pick(const glm::dvec3& origin, const glm::dvec3& direction, double coneSlope)
+	{
+		visitedNodes = 0;
+
+		if (nodes.empty())
+			return STAR_PICK_NONE;
+
+		glm::dvec3 dir = glm::normalize(direction);
+		size_t best = STAR_PICK_NONE;
+		double bestMiss = coneSlope;	// angular, 0 for a true hit
+		double bestDistance = 1e300;	// along the ray, breaks ties between true hits
+
+		uint32_t stack[STAR_PICK_STACK_SIZE];
+		int top = 0;
+		stack[top++] = 0;
+
+		while (top > 0)
+		{
+			const StarPickNode& node = nodes[stack[--top]];
+			visitedNodes++;
+
+			// a lower bound on how well anything inside can do
+			glm::dvec3 toCenter = node.center - origin;
+			double along = glm::dot(toCenter, dir);
+
+			if (along + node.radius <= 0.0)
+				continue;
+
+			double across = glm::length(toCenter - dir * along);
+			double gap = across - node.radius;
+			double farthest = along + node.radius;
+
+			if (gap > coneSlope * farthest)
+				continue;
+
+			if (bestMiss == 0.0 && along - node.radius > bestDistance)
+				continue;
+
+			if (bestMiss > 0.0 && gap > bestMiss * farthest)
+				continue;
+
+			if (node.count == 0)
+			{
+				// nearer child on top, so it is searched first
+				glm::dvec3 toFirst = nodes[node.first].center - origin;
+				glm::dvec3 toSecond = nodes[node.first + 1].center - origin;
+				bool firstNearer = glm::dot(toFirst, dir) < glm::dot(toSecond, dir);
+
+				stack[top++] = node.first + (firstNearer ? 1 : 0);
+				stack[top++] = node.first + (firstNearer ? 0 : 1);
+				continue;
+			}
+
+			for (uint32_t i = node.first; i < node.first + node.count; i++)
+			{
+				glm::dvec3 toStar = stars[i].position - origin;
+				double distance = glm::dot(toStar, dir);
+
+				if (distance <= 0.0)
+					continue;
+
+				double miss = std::max(glm::length(toStar - dir * distance) - starRadius, 0.0) / distance;
+
+				if (miss < bestMiss || (miss == bestMiss && miss == 0.0 && distance < bestDistance))
+				{
+					best = stars[i].id;
+					bestMiss = miss;
+					bestDistance = distance;
+				}
+			}
+		}
+
+		return best;
+	}
+
+	// Ray from the eye (light years) through ndc, view / projection as used for drawing.
+	size_t Pick(const glm::dvec3& eye, const glm::mat4& view, const glm::mat4& projection, const glm::vec2& ndc, int viewportHeight)
+	{
+		glm::vec3 viewDirection = glm::vec3(ndc.x / projection[0][0], ndc.y / projection[1][1], -1.0f);
+		glm::vec3 direction = glm::transpose(glm::mat3(view)) * viewDirection;
+		double coneSlope = pixelTolerance * 2.0 / (viewportHeight * projection[1][1]);
+
+		return Pick(eye, glm::dvec3(direction), coneSlope);
+	}
+
+	void UpdateHover(const glm::dvec3& eye, const glm::mat4& view, const glm::mat4& projection, const glm::vec2& ndc, int viewportHeight)
+	{
+		size_t star = Pick(eye, view, projection, ndc, viewportHeight);
+
+		if (star == hovered)
+			return;
+
+		size_t previous = hovered;
+		hovered = star;
+
+		for (StarPickListener& listener : hoverListeners)
+			listener(previous, hovered);
+	}
+
+	// selects what is hovered, nothing hovered clears the selection
+	void Select()
+	{
+		if (hovered == selected)
+			return;
+
+		size_t previous = selected;
+		selected = hovered;
+
+		for (StarPickListener& listener : selectListeners)
+			listener(previous, selected);
+	}
+
+	void OnHover(const StarPickListener& listener) { hoverListeners.push_back(listener); }
+	void OnSelect(const StarPickListener& listener) { selectListeners.push_back(listener); }
+
+	size_t GetHovered() const { return hovered; }
+	size_t GetSelected() const { return selected; }
+	// nodes the last Pick() looked at
+	size_t GetVisitedNodes() const { return visitedNodes; }
+
+private:
+	struct Star {
+		glm::dvec3 position;	// light years
+		uint32_t id;			// store index
+	};
+
+	std::vector<StarPickNode> nodes;
+	std::vector<Star> stars;	// tree order
+
+	size_t hovered;
+	size_t selected;
+	size_t visitedNodes;
+
+	std::vector<StarPickListener> hoverListeners;
+	std::vector<StarPickListener> selectListeners;
+
+	// median split along the longest axis, children are allocated side by side before either is
+	// filled in
+	void build(uint32_t index, uint32_t first, uint32_t count)
+	{
+		glm::dvec3 lo = stars[first].position;
+		glm::dvec3 hi = lo;
+
+		for (uint32_t i = first + 1; i < first + count; i++)
+		{
+			lo = glm::min(lo, stars[i].position);
+			hi = glm::max(hi, stars[i].position);
+		}
+
+		glm::dvec3 center = (lo + hi) * 0.5;
+
+		if (count <= STAR_PICK_LEAF_SIZE)
+		{
+			double radius = 0.0;
+
+			for (uint32_t i = first; i < first + count; i++)
+				radius = std::max(radius, glm::length(stars[i].position - center));
+
+			nodes[index].center = center;
+			nodes[index].radius = radius + starRadius;
+			nodes[index].first = first;
+			nodes[index].count = count;
+			return;
+		}
+
+		glm::dvec3 extent = hi - lo;
+		int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+		uint32_t half = count / 2;
+
+		std::nth_element(stars.begin() + first, stars.begin() + first + half, stars.begin() + first + count, [axis](const Star& a, const Star& b) {
+			return a.position[axis] < b.position[axis];
+		});
+
+		uint32_t children = (uint32_t)nodes.size();
+		nodes.push_back(StarPickNode());
+		nodes.push_back(StarPickNode());
+
+		build(children, first, half);
+		build(children + 1, first + half, count - half);
+
+		// encloses both children's spheres
+		double radius = 0.0;
+
+		for (uint32_t c = children; c < children + 2; c++)
+			radius = std::max(radius, glm::length(nodes[c].center - center) + nodes[c].radius);
+
+		nodes[index].center = center;
+		nodes[index].radius = radius;
+		nodes[index].first = children;
+		nodes[index].count = 0;
+	}
+};
+
+#endif
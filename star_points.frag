@@ -0,0 +1,15 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 Color;
+
+void main()
+{
+	vec2 d = gl_PointCoord * 2.0 - 1.0;
+	float r2 = dot(d, d);
+
+	if (r2 > 1.0)
+		discard;
+
+	FragColor = vec4(Color * (1.0 - r2 * 0.5), 1.0);
+}
@@ -0,0 +1,103 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 FragPos;
+in vec3 Normal;			// unit sphere, doubles as the surface coordinate
+flat in uint StarClass;
+flat in uint Seed;
+flat in uint Highlight;
+
+uniform float time;		// seconds
+
+// per StarClass: O, B, A, F, G, K, L, M, T, Y, D (Wolf-Rayet), GENERIC
+const float TEMPERATURE[12] = float[12](40000.0, 20000.0, 8500.0, 6500.0, 5600.0, 4400.0, 1800.0, 3200.0, 1100.0, 600.0, 60000.0, 5800.0);
+const float SPOT_COVERAGE[12] = float[12](0.0, 0.0, 0.05, 0.1, 0.15, 0.25, 0.3, 0.35, 0.2, 0.1, 0.0, 0.15);
+
+// Tanner Helland's fit of the Planck locus, 1000 K to 40000 K
+vec3 blackbody(float kelvin)
+{
+	float t = clamp(kelvin, 1000.0, 40000.0) / 100.0;
+	vec3 color;
+
+	color.r = t <= 66.0 ? 1.0 : 1.292936 * pow(t - 60.0, -0.1332048);
+	color.g = t <= 66.0 ? 0.3900816 * log(t) - 0.6318414 : 1.1298909 * pow(t - 60.0, -0.0755148);
+	color.b = t >= 66.0 ? 1.0 : (t <= 19.0 ? 0.0 : 0.5432068 * log(t - 10.0) - 1.1962540);
+
+	return clamp(color, 0.0, 1.0);
+}
+
+float hash(vec3 p)
+{
+	p = fract(p * 0.3183099 + 0.1);
+	p *= 17.0;
+	return fract(p.x * p.y * p.z * (p.x + p.y + p.z));
+}
+
+// value noise, 0..1
+float noise(vec3 p)
+{
+	vec3 i = floor(p);
+	vec3 f = fract(p);
+	f = f * f * (3.0 - 2.0 * f);
+
+	return mix(mix(mix(hash(i), hash(i + vec3(1, 0, 0)), f.x), mix(hash(i + vec3(0, 1, 0)), hash(i + vec3(1, 1, 0)), f.x), f.y),
+		mix(mix(hash(i + vec3(0, 0, 1)), hash(i + vec3(1, 0, 1)), f.x), mix(hash(i + vec3(0, 1, 1)), hash(i + vec3(1, 1, 1)), f.x), f.y), f.z);
+}
+
+float fbm(vec3 p)
+{
+	float value = 0.0;
+	float amplitude = 0.5;
+
+	for (int i = 0; i < 4; i++)
+	{
+		value += amplitude * noise(p);
+		p = p * 2.03 + vec3(1.7, 9.2, 4.1);
+		amplitude *= 0.5;
+	}
+
+	return value;
+}
+
+void main()
+{
+	vec3 normal = normalize(Normal);
+	vec3 viewDir = normalize(-FragPos);
+	float mu = max(dot(normal, viewDir), 0.0);
+
+	float temperature = TEMPERATURE[min(StarClass, 11u)];
+	float spotCoverage = SPOT_COVERAGE[min(StarClass, 11u)];
+	vec3 offset = vec3(float(Seed & 31u), float((Seed >> 5) & 31u), float(Seed >> 10)) * 7.31;
+
+	// the surface turns slowly around y, each star at its own rate
+	float angle = time * (0.02 + 0.03 * hash(offset));
+	vec3 p = vec3(cos(angle) * normal.x - sin(angle) * normal.z, normal.y, sin(angle) * normal.x + cos(angle) * normal.z);
+
+	// granulation: bright cells with dark lanes, churning over time
+	float cells = 1.0 - abs(2.0 * noise(p * 24.0 + offset + vec3(0.0, time * 0.15, 0.0)) - 1.0);
+	float granulation = mix(0.85, 1.1, cells * fbm(p * 12.0 - offset));
+
+	// spots: cooler patches, kept away from the poles
+	float spotField = fbm(p * 3.0 + offset + vec3(time * 0.01));
+	float spots = smoothstep(0.72 - spotCoverage * 0.5, 0.76 - spotCoverage * 0.5, spotField) * (1.0 - abs(p.y)) * step(0.001, spotCoverage);
+
+	// limb darkening, linear law; cool stars darken more towards the edge
+	float u = mix(0.8, 0.4, smoothstep(3000.0, 20000.0, temperature));
+	float limb = 1.0 - u * (1.0 - mu);
+
+	vec3 photosphere = blackbody(temperature) * granulation * limb;
+	vec3 spotColor = blackbody(temperature * 0.7) * 0.35 * limb;
+	vec3 color = mix(photosphere, spotColor, spots);
+
+	// corona: a glow that rises at the silhouette, strongest for hot stars
+	float corona = pow(1.0 - mu, 4.0) * mix(0.3, 1.2, smoothstep(4000.0, 40000.0, temperature));
+	color += blackbody(temperature * 1.3) * corona;
+
+	// brown dwarfs barely glow
+	color *= mix(0.35, 1.0, smoothstep(500.0, 3000.0, temperature));
+
+	if (Highlight != 0u)
+		color = mix(color, vec3(1.0), 0.5);
+
+	FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,206 @@
+#ifndef STAR_STORE_H
+#define STAR_STORE_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+
+#include "journal_reader.h"
+
+enum StarFlags : uint8_t {
+	STAR_VISITED = 1,
+	STAR_NEUTRON = 2	// primary star is a neutron star, jumps from it are supercharged
+};
+
+// One system as it is kept in memory and on disk. Names live in a separate blob, nameOffset
+// points at the first character of a '\0' terminated name.
+struct StarRecord {
+	double x, y, z;			// light years from Sol
+	uint64_t nameOffset;
+	uint8_t starClass;
+	uint8_t flags;
+	uint8_t reserved[6];
+};
+
+static_assert(sizeof(StarRecord) == 40, "StarRecord is written to disk as is");
+
+// Snapshot layout: "<path>" holds a StarSnapshotHeader followed by count StarRecords,
+// "<path>.names" holds all names back to back, each terminated by '\0'.
+struct StarSnapshotHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t count;
+	uint64_t namesSize;
+};
+
+const char STAR_SNAPSHOT_MAGIC[4] = { 'S', 'M', 'A', 'P' };
+const uint32_t STAR_SNAPSHOT_VERSION = 1;
+
+// Appends records to a snapshot without keeping them in memory.
+class StarSnapshotWriter
+{
+public:
+	bool Open(const std::string& path)
+	{
+		records.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+		names.open(path + ".names", std::ios::out | std::ios::binary | std::ios::trunc);
+
+		if (!records.is_open() || !names.is_open())
+		{
+			std::cout << "ERROR::SNAPSHOT:: Could not open " << path << " for writing" << std::endl;
+			return false;
+		}
+
+		header = {};
+		std::memcpy(header.magic, STAR_SNAPSHOT_MAGIC, 4);
+		header.version = STAR_SNAPSHOT_VERSION;
+		records.write((const char*)&header, sizeof(header));
+
+		return true;
+	}
+
+	void Append(const glm::dvec3& position, const char* name, size_t nameLength, StarClass starClass, uint8_t flags)
+	{
+		StarRecord r = {};
+		r.x = position.x;
+		r.y = position.y;
+		r.z = position.z;
+		r.nameOffset = header.namesSize;
+		r.starClass = (uint8_t)starClass;
+		r.flags = flags;
+
+		records.write((const char*)&r, sizeof(r));
+		names.write(name, nameLength);
+		names.put('\0');
+
+		header.count++;
+		header.namesSize += nameLength + 1;
+	}
+
+	uint64_t GetCount() const { return header.count; }
+
+	void Close()
+	{
+		records.seekp(0);
+		records.write((const char*)&header, sizeof(header));
+		records.close();
+		names.close();
+	}
+
+private:
+	std::ofstream records;
+	std::ofstream names;
+	StarSnapshotHeader header;
+};
+
+// All systems the map knows about, in one flat array. Journal systems and imported dumps both
+// end up here; the visited flag tells them apart.
+class StarStore
+{
+public:
+	std::vector<StarRecord> stars;
+	std::string names;
+
+	size_t Size() const { return stars.size(); }
+
+	glm::dvec3 GetPosition(size_t i) const
+	{
+		return glm::dvec3(stars[i].x, stars[i].y, stars[i].z);
+	}
+
+	StarClass GetStarClass(size_t i) const
+	{
+		return (StarClass)stars[i].starClass;
+	}
+
+	const char* GetName(size_t i) const
+	{
+		return names.c_str() + stars[i].nameOffset;
+	}
+
+	bool IsVisited(size_t i) const
+	{
+		return (stars[i].flags & STAR_VISITED) != 0;
+	}
+
+	bool IsNeutron(size_t i) const
+	{
+		return (stars[i].flags & STAR_NEUTRON) != 0;
+	}
+
+	void Add(const glm::dvec3& position, const std::string& name, StarClass starClass, uint8_t flags)
+	{
+		StarRecord r = {};
+		r.x = position.x;
+		r.y = position.y;
+		r.z = position.z;
+		r.nameOffset = names.size();
+		r.starClass = (uint8_t)starClass;
+		r.flags = flags;
+
+		stars.push_back(r);
+		names.append(name);
+		names.push_back('\0');
+	}
+
+	void AddVisited(const std::vector<Coordinate>& coordinates)
+	{
+		for (const Coordinate& c : coordinates)
+			Add(c.coords, c.name, c.starClass, STAR_VISITED);
+	}
+
+	bool Load(const std::string& path)
+	{
+		std::ifstream records(path, std::ios::in | std::ios::binary);
+		std::ifstream nameFile(path + ".names", std::ios::in | std::ios::binary);
+
+		StarSnapshotHeader header;
+
+		if (!records.read((char*)&header, sizeof(header)) || std::memcmp(header.magic, STAR_SNAPSHOT_MAGIC, 4) != 0 || header.version != STAR_SNAPSHOT_VERSION)
+		{
+			std::cout << "ERROR::SNAPSHOT:: " << path << " is not a star snapshot" << std::endl;
+			return false;
+		}
+
+		stars.resize(header.count);
+		names.resize(header.namesSize);
+
+		records.read((char*)stars.data(), header.count * sizeof(StarRecord));
+		nameFile.read(&names[0], header.namesSize);
+
+		if (!records || !nameFile)
+		{
+			std::cout << "ERROR::SNAPSHOT:: " << path << " is truncated" << std::endl;
+			stars.clear();
+			names.clear();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool Save(const std::string& path) const
+	{
+		StarSnapshotWriter writer;
+
+		if (!writer.Open(path))
+			return false;
+
+		for (size_t i = 0; i < stars.size(); i++)
+		{
+			const char* name = GetName(i);
+			writer.Append(GetPosition(i), name, std::strlen(name), GetStarClass(i), stars[i].flags);
+		}
+
+		writer.Close();
+
+		return true;
+	}
+};
+
+#endif
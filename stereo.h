@@ -0,0 +1,136 @@
+#ifndef STEREO_H
+#define STEREO_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "gl_extensions.h"
+#include "shader.h"
+
+#include <iostream>
+
+enum StereoMode {
+	STEREO_MULTIVIEW,	// layered 2D array target, GL_OVR_multiview2 broadcasts each draw to both layers
+	STEREO_INSTANCED	// double-wide target, every draw is instanced twice and split by a clip plane
+};
+
+// Render target for single-pass stereo. Both eyes are filled by one traversal of the scene,
+// each draw call goes out once and the GPU duplicates it per eye.
+class StereoRenderTarget
+{
+public:
+	StereoMode mode;
+	unsigned int FBO;
+	unsigned int colorTexture;
+	unsigned int depthTexture;
+	int eyeWidth;
+	int eyeHeight;
+
+	StereoRenderTarget(int eyeWidth, int eyeHeight, bool allowMultiview = true) : FBO(0), colorTexture(0), depthTexture(0), eyeWidth(eyeWidth), eyeHeight(eyeHeight)
+	{
+		mode = (allowMultiview && GLAD_GL_OVR_multiview2) ? STEREO_MULTIVIEW : STEREO_INSTANCED;
+
+		glGenFramebuffers(1, &FBO);
+		glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+
+		if (mode == STEREO_MULTIVIEW)
+			setupMultiview();
+		else
+			setupInstanced();
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "ERROR::FRAMEBUFFER:: Stereo framebuffer is not complete!" << std::endl;
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		std::cout << "Stereo target " << eyeWidth << "x" << eyeHeight << " per eye, " << (mode == STEREO_MULTIVIEW ? "multiview" : "instanced") << std::endl;
+	}
+
+	~StereoRenderTarget()
+	{
+		glDeleteTextures(1, &colorTexture);
+		glDeleteTextures(1, &depthTexture);
+		glDeleteFramebuffers(1, &FBO);
+	}
+
+	StereoRenderTarget(const StereoRenderTarget&) = delete;
+	StereoRenderTarget& operator=(const StereoRenderTarget&) = delete;
+
+	const char* GetVertexShaderPath() const
+	{
+		return mode == STEREO_MULTIVIEW ? "stereo_multiview.vert" : "stereo_instanced.vert";
+	}
+
+	// instances per draw call needed to cover both eyes
+	unsigned int GetInstanceCount() const
+	{
+		return mode == STEREO_MULTIVIEW ? 1 : 2;
+	}
+
+	void Bind()
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+
+		if (mode == STEREO_MULTIVIEW)
+		{
+			glViewport(0, 0, eyeWidth, eyeHeight);
+		}
+		else
+		{
+			glViewport(0, 0, eyeWidth * 2, eyeHeight);
+			glEnable(GL_CLIP_DISTANCE0);
+		}
+	}
+
+	void Unbind()
+	{
+		if (mode == STEREO_INSTANCED)
+			glDisable(GL_CLIP_DISTANCE0);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	// per eye view * projection, eye 0 = left
+	void SetEyeMatrices(Shader& shader, const glm::mat4 viewProjection[2])
+	{
+		shader.setMat4("viewProjection[0]", viewProjection[0]);
+		shader.setMat4("viewProjection[1]", viewProjection[1]);
+		shader.setInt("firstEye", 0);
+	}
+
+private:
+	void setupMultiview()
+	{
+		glGenTextures(1, &colorTexture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, colorTexture);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, eyeWidth, eyeHeight, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		glGenTextures(1, &depthTexture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, depthTexture);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F, eyeWidth, eyeHeight, 2, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+
+		glFramebufferTextureMultiviewOVR(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorTexture, 0, 0, 2);
+		glFramebufferTextureMultiviewOVR(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0, 0, 2);
+	}
+
+	void setupInstanced()
+	{
+		glGenTextures(1, &colorTexture);
+		glBindTexture(GL_TEXTURE_2D, colorTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, eyeWidth * 2, eyeHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		glGenTextures(1, &depthTexture);
+		glBindTexture(GL_TEXTURE_2D, depthTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, eyeWidth * 2, eyeHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+	}
+};
+
+#endif
@@ -0,0 +1,27 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec2 TexCoords;
+
+uniform mat4 model;
+uniform mat4 viewProjection[2];
+uniform int firstEye;
+uniform mat4 meshDequantize;
+
+// Both eyes are drawn by one instanced call into a double-wide target: instance 0 is squeezed
+// into the left half, instance 1 into the right half, and the clip plane keeps each eye on its side.
+void main()
+{
+	int eye = (gl_InstanceID + firstEye) & 1;
+
+	TexCoords = aTexCoords;
+
+	vec4 clipPos = viewProjection[eye] * model * meshDequantize * vec4(aPos, 1.0);
+
+	gl_ClipDistance[0] = eye == 0 ? clipPos.w - clipPos.x : clipPos.w + clipPos.x;
+	clipPos.x = clipPos.x * 0.5 + (eye == 0 ? -0.5 : 0.5) * clipPos.w;
+
+	gl_Position = clipPos;
+}
@@ -0,0 +1,18 @@
+#version 330 core
+#extension GL_OVR_multiview2 : require
+layout (num_views = 2) in;
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec2 TexCoords;
+
+uniform mat4 model;
+uniform mat4 viewProjection[2];
+uniform mat4 meshDequantize;
+
+void main()
+{
+	TexCoords = aTexCoords;
+	gl_Position = viewProjection[gl_ViewID_OVR] * model * meshDequantize * vec4(aPos, 1.0);
+}
@@ -0,0 +1,27 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+in vec4 Color;
+
+uniform sampler2D atlas;	// signed distance, 0.5 on the outline
+
+const float HALO = 0.2;		// dark rim around the glyphs, in distance units
+
+void main()
+{
+	float distance = texture(atlas, TexCoords).r;
+
+	// about one pixel of antialiasing whatever the scale
+	float width = max(fwidth(distance) * 0.75, 1e-4);
+	float fill = smoothstep(0.5 - width, 0.5 + width, distance);
+	float halo = smoothstep(0.5 - HALO - width, 0.5 - HALO + width, distance);
+
+	// the glyph over its black halo
+	float coverage = fill + (1.0 - fill) * halo * 0.7;
+
+	if (coverage <= 0.0)
+		discard;
+
+	FragColor = vec4(Color.rgb * fill / coverage, coverage * Color.a);
+}
@@ -0,0 +1,24 @@
+#version 330 core
+layout (location = 0) in vec2 aPosition;	// top left of the glyph's atlas cell, pixels from the top left
+layout (location = 1) in uint aGlyph;
+layout (location = 2) in vec4 aColor;
+
+out vec2 TexCoords;
+out vec4 Color;
+
+uniform vec2 viewport;		// pixels
+uniform vec2 cellSize;		// pixels one atlas cell covers on screen
+uniform ivec2 atlasCells;	// columns, rows
+
+void main()
+{
+	// triangle strip over the cell, corners from the vertex index
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	vec2 pixel = aPosition + corner * cellSize;
+
+	ivec2 cell = ivec2(int(aGlyph) % atlasCells.x, int(aGlyph) / atlasCells.x);
+	TexCoords = (vec2(cell) + corner) / vec2(atlasCells);
+	Color = aColor;
+
+	gl_Position = vec4(pixel.x / viewport.x * 2.0 - 1.0, 1.0 - pixel.y / viewport.y * 2.0, 0.0, 1.0);
+}
@@ -0,0 +1,502 @@
+#ifndef TEXT_LABELS_H
+#define TEXT_LABELS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_access.hpp>
+
+#include "shader.h"
+#include "camera.h"
+#include "gl_state.h"
+#include "gl_resources.h"
+#include "glyph_font.h"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+const int LABEL_MAX_LENGTH = 32;		// characters, longer names are cut
+const int LABEL_TILE_SIZE = 8;			// pixels per cell of the occupancy grid
+const size_t LABEL_BLOCK_SIZE = 256;	// candidates culled together
+
+// per glyph drawn, locations 0 to 2 in text.vert
+struct LabelGlyph {
+	float x, y;			// top left of the atlas cell, pixels from the top left of the screen
+	uint32_t glyph;		// atlas cell
+	uint32_t color;		// RGBA8
+};
+
+inline uint32_t PackGlyphColor(const glm::vec4& c)
+{
+	glm::uvec4 bytes = glm::uvec4(glm::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+	return bytes.r | (bytes.g << 8) | (bytes.b << 16) | (bytes.a << 24);
+}
+
+// The glyph_font.h atlas as a texture, built once and drawn from by TextLabels and TextOverlay.
+class GlyphAtlas
+{
+public:
+	GlyphAtlas() : texture(0), program(0)
+	{
+	}
+
+	~GlyphAtlas()
+	{
+		glDeleteTextures(1, &texture);
+	}
+
+	GlyphAtlas(const GlyphAtlas&) = delete;
+	GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+	// needs a context
+	void Init()
+	{
+		std::vector<uint8_t> pixels = BuildGlyphAtlas();
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		texture = CreateTexture2D(GL_R8, GLYPH_ATLAS_WIDTH, GLYPH_ATLAS_HEIGHT, 1, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		SetTextureParameter(GL_TEXTURE_2D, texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		SetTextureParameter(GL_TEXTURE_2D, texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		SetTextureParameter(GL_TEXTURE_2D, texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		SetTextureParameter(GL_TEXTURE_2D, texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	// makes shader (text.vert / text.frag) current for glyphs of fontSize on a viewport in
+	// pixels, with the atlas on unit 0
+	void Bind(Shader& shader, const glm::vec2& viewport, float fontSize)
+	{
+		float pixel = fontSize / GLYPH_FONT_HEIGHT;
+		glm::vec2 cellSize = glm::vec2(GLYPH_ATLAS_CELL_WIDTH, GLYPH_ATLAS_CELL_HEIGHT) * (pixel / GLYPH_ATLAS_SCALE);
+
+		shader.use();
+
+		// locations only change with the program
+		if (shader.ID != program)
+		{
+			program = shader.ID;
+			viewportLocation = glGetUniformLocation(program, "viewport");
+			cellSizeLocation = glGetUniformLocation(program, "cellSize");
+			atlasCellsLocation = glGetUniformLocation(program, "atlasCells");
+			atlasLocation = glGetUniformLocation(program, "atlas");
+		}
+
+		glUniform2f(viewportLocation, viewport.x, viewport.y);
+		glUniform2f(cellSizeLocation, cellSize.x, cellSize.y);
+		glUniform2i(atlasCellsLocation, GLYPH_ATLAS_COLUMNS, GLYPH_ATLAS_ROWS);
+		glState.Uniform1i(program, atlasLocation, 0);
+		glState.BindTexture(0, GL_TEXTURE_2D, texture);
+	}
+
+private:
+	unsigned int texture;
+	GLuint program;
+	GLint viewportLocation, cellSizeLocation, atlasCellsLocation, atlasLocation;
+};
+
+// Names next to stars, drawn as screen-space text from the signed distance field atlas of
+// glyph_font.h. Labels are added once; every frame Layout() projects them, declutters and
+// writes the glyphs of the survivors into one instance buffer that Draw() submits in a single
+// instanced draw.
+//
+// Decluttering is two passes over screen grids. The first keeps, per coarse cell about one
+// label in size, only the most relevant label anchored in it (importance over distance), which
+// is O(n) and leaves at most a few thousand of any number of candidates. Those are sorted and
+// placed greedily into a fine occupancy grid, a label is dropped when its rectangle touches
+// one already placed.
+//
+// For the first pass the candidates are split into spatial blocks of LABEL_BLOCK_SIZE once,
+// after they change. Blocks outside the frustum are skipped whole; inside, members are float
+// offsets from the block's centre, so projecting one takes no double maths at all. Labels added
+// once the blocks are built go into blocks of their own at the end, only the one they join is
+// measured again.
+class TextLabels
+{
+public:
+	float fontSize = 14.0f;		// pixels from the top of a capital to the baseline
+	float anchorOffset = 8.0f;	// pixels between the star and its label
+	glm::vec4 color = glm::vec4(0.85f, 0.9f, 1.0f, 1.0f);
+
+	// the atlas must outlive the labels
+	TextLabels(GlyphAtlas& atlas) : splitCount(0), atlas(atlas), VAO(0), glyphBuffer(0), glyphCapacity(0), placedCount(0)
+	{
+	}
+
+	~TextLabels()
+	{
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &glyphBuffer);
+	}
+
+	TextLabels(const TextLabels&) = delete;
+	TextLabels& operator=(const TextLabels&) = delete;
+
+	void Clear()
+	{
+		positions.clear();
+		labels.clear();
+		text.clear();
+		blocks.clear();
+	}
+
+	// position in light years, importance scales how far away the label still wins
+	void Add(const glm::dvec3& position, const char* name, float importance = 1.0f)
+	{
+		Label label;
+		label.importance = importance;
+		label.textOffset = (uint32_t)text.size();
+		label.length = (uint32_t)strnlen(name, LABEL_MAX_LENGTH);
+
+		positions.push_back(position);
+		labels.push_back(label);
+		text.append(name, label.length);
+
+		if (blocks.empty())
+			return;
+
+		LabelBlock& last = blocks.back();
+
+		if (last.first >= splitCount && last.count < LABEL_BLOCK_SIZE)
+			last.count++;
+		else
+			blocks.push_back(LabelBlock{ glm::dvec3(0.0), 0.0f, (uint32_t)labels.size() - 1, 1 });
+
+		offsets.resize(positions.size());
+		measure(blocks.back());
+	}
+
+	size_t GetCandidateCount() const { return labels.size(); }
+	size_t GetPlacedCount() const { return placedCount; }
+
+	// eye in light years, view/projection as used for drawing, viewport in pixels
+	void Layout(const glm::dvec3& eye, double mapScale, const glm::mat4& view, const glm::mat4& projection, int width, int height)
+	{
+		glyphs.clear();
+		placedCount = 0;
+		viewport = glm::vec2((float)width, (float)height);
+
+		if (labels.empty() || width <= 0 || height <= 0)
+			return;
+
+		float pixel = fontSize / GLYPH_FONT_HEIGHT;
+		float advance = pixel * (GLYPH_FONT_WIDTH + 1);
+		float labelHeight = pixel * (GLYPH_FONT_HEIGHT + 2);
+
+		// coarse cells: about one short label each
+		int cellWidth = std::max((int)(advance * 6.0f), 1);
+		int cellHeight = std::max((int)labelHeight, 1);
+		int columns = (width + cellWidth - 1) / cellWidth;
+		int rows = (height + cellHeight - 1) / cellHeight;
+
+		cells.assign(columns * rows, Candidate());
+
+		if (blocks.empty())
+			buildBlocks();
+
+		// Positions are in light years, the map scale goes into the matrix. Only the x, y and w
+		// rows are needed, mapped straight to pixels.
+		glm::mat4 viewProjection = projection * view * glm::mat4((float)mapScale);
+		viewProjection[3][3] = 1.0f;
+
+		glm::vec4 rowX = glm::row(viewProjection, 0);
+		glm::vec4 rowY = glm::row(viewProjection, 1);
+		glm::vec4 rowW = glm::row(viewProjection, 3);
+
+		// as in StarHlodRenderer, distances come out in light years
+		glm::vec4 planes[5];
+		planes[0] = rowW + rowX;
+		planes[1] = rowW - rowX;
+		planes[2] = rowW + rowY;
+		planes[3] = rowW - rowY;
+		planes[4] = rowW - glm::vec4(0.0f, 0.0f, 0.0f, NEAR_PLANE);
+
+		for (int i = 0; i < 5; i++)
+			planes[i] /= glm::length(glm::vec3(planes[i]));
+
+		rowX = (rowX + rowW) * (viewport.x * 0.5f);	// (x / w + 1) * width / 2
+		rowY = (rowW - rowY) * (viewport.y * 0.5f);	// (1 - y / w) * height / 2
+
+		float invCellWidth = 1.0f / cellWidth;
+		float invCellHeight = 1.0f / cellHeight;
+
+		for (const LabelBlock& block : blocks)
+		{
+			// the camera-relative centre loses nothing that matters in float: anything far enough
+			// for the rounding to show is many pixels from whatever it could be confused with
+			glm::vec3 center = glm::vec3(block.center - eye);
+			bool visible = true;
+
+			for (int i = 0; i < 5 && visible; i++)
+				visible = glm::dot(glm::vec3(planes[i]), center) + planes[i].w >= -block.radius;
+
+			if (!visible)
+				continue;
+
+			glm::vec3 axisX = glm::vec3(rowX), axisY = glm::vec3(rowY), axisW = glm::vec3(rowW);
+			float baseX = glm::dot(axisX, center) + rowX.w;
+			float baseY = glm::dot(axisY, center) + rowY.w;
+			float baseW = glm::dot(axisW, center) + rowW.w;
+
+			for (uint32_t i = block.first; i < block.first + block.count; i++)
+			{
+				const glm::vec3& offset = offsets[i];
+				float w = baseW + axisW.x * offset.x + axisW.y * offset.y + axisW.z * offset.z;
+
+				if (w <= NEAR_PLANE)
+					continue;
+
+				float invW = 1.0f / w;
+				float x = (baseX + axisX.x * offset.x + axisX.y * offset.y + axisX.z * offset.z) * invW;
+				float y = (baseY + axisY.x * offset.x + axisY.y * offset.y + axisY.z * offset.z) * invW;
+
+				if (!(x >= 0.0f && x < viewport.x && y >= 0.0f && y < viewport.y))
+					continue;
+
+				float relevance = labels[i].importance * invW;
+				Candidate& cell = cells[(int)(y * invCellHeight) * columns + (int)(x * invCellWidth)];
+
+				if (relevance > cell.relevance)
+				{
+					cell.relevance = relevance;
+					cell.label = (int)i;
+					cell.screen = glm::vec2(x, y);
+				}
+			}
+		}
+
+		survivors.clear();
+
+		for (const Candidate& cell : cells)
+			if (cell.label >= 0)
+				survivors.push_back(cell);
+
+		std::sort(survivors.begin(), survivors.end(), [](const Candidate& a, const Candidate& b) {
+			return a.relevance > b.relevance;
+		});
+
+		int tileColumns = (width + LABEL_TILE_SIZE - 1) / LABEL_TILE_SIZE;
+		int tileRows = (height + LABEL_TILE_SIZE - 1) / LABEL_TILE_SIZE;
+		occupied.assign(tileColumns * tileRows, 0);
+
+		uint32_t packedColor = PackGlyphColor(color);
+
+		for (const Candidate& survivor : survivors)
+		{
+			const Label& label = labels[survivor.label];
+
+			if (label.length == 0)
+				continue;
+
+			// left edge at the star plus offset, vertically centred on it
+			float left = survivor.screen.x + anchorOffset;
+			float top = survivor.screen.y - labelHeight * 0.5f;
+			float right = left + advance * label.length;
+			float bottom = top + labelHeight;
+
+			int x0 = std::max((int)std::floor(left / LABEL_TILE_SIZE), 0);
+			int y0 = std::max((int)std::floor(top / LABEL_TILE_SIZE), 0);
+			int x1 = std::min((int)std::floor(right / LABEL_TILE_SIZE), tileColumns - 1);
+			int y1 = std::min((int)std::floor(bottom / LABEL_TILE_SIZE), tileRows - 1);
+
+			bool free = true;
+
+			for (int ty = y0; ty <= y1 && free; ty++)
+				for (int tx = x0; tx <= x1 && free; tx++)
+					free = !occupied[ty * tileColumns + tx];
+
+			if (!free)
+				continue;
+
+			for (int ty = y0; ty <= y1; ty++)
+				for (int tx = x0; tx <= x1; tx++)
+					occupied[ty * tileColumns + tx] = 1;
+
+			// the atlas cell reaches GLYPH_ATLAS_PADDING texels beyond the font pixels
+			float padding = pixel * GLYPH_ATLAS_PADDING / GLYPH_ATLAS_SCALE;
+
+			for (uint32_t c = 0; c < label.length; c++)
+			{
+				LabelGlyph glyph;
+				glyph.x = left + advance * c - padding;
+				glyph.y = top + pixel - padding;
+				glyph.glyph = (uint32_t)GlyphIndex((unsigned char)text[label.textOffset + c]);
+				glyph.color = packedColor;
+				glyphs.push_back(glyph);
+			}
+
+			placedCount++;
+		}
+
+		if (glyphs.empty())
+			return;
+
+		// rewritten every frame, new storage only when the glyphs outgrow it
+		size_t bytes = glyphs.size() * sizeof(LabelGlyph);
+
+		if (bytes > glyphCapacity)
+		{
+			glDeleteBuffers(1, &glyphBuffer);
+			glyphCapacity = bytes * 2;
+			glyphBuffer = CreateBuffer(glyphCapacity, NULL, GL_DYNAMIC_STORAGE_BIT);
+
+			VertexArrayBuilder builder(VAO);
+			builder.Buffer(0, glyphBuffer, sizeof(LabelGlyph), 1);
+			builder.Attribute(0, 0, 2, GL_FLOAT, GL_FALSE, offsetof(LabelGlyph, x));
+			builder.IntegerAttribute(1, 0, 1, GL_UNSIGNED_INT, offsetof(LabelGlyph, glyph));
+			builder.Attribute(2, 0, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(LabelGlyph, color));
+			VAO = builder.Finish();
+		}
+
+		UpdateBuffer(glyphBuffer, 0, bytes, glyphs.data());
+	}
+
+	// onto whatever is bound, after tone mapping so text is never bloomed
+	void Draw(Shader& shader)
+	{
+		if (glyphs.empty())
+			return;
+
+		atlas.Bind(shader, viewport, fontSize);
+
+		glState.Enable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		glState.BindVertexArray(VAO);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)glyphs.size());
+
+		glState.Disable(GL_BLEND);
+	}
+
+private:
+	struct Label {
+		float importance;
+		uint32_t textOffset;
+		uint32_t length;
+	};
+
+	struct LabelBlock {
+		glm::dvec3 center;	// light years
+		float radius;		// light years
+		uint32_t first;
+		uint32_t count;
+	};
+
+	// the most relevant label anchored in a coarse cell
+	struct Candidate {
+		float relevance;
+		int label;
+		glm::vec2 screen;
+
+		Candidate() : relevance(0.0f), label(-1), screen(0.0f) {}
+	};
+
+	std::vector<glm::dvec3> positions;	// light years, in block order once the blocks are built
+	std::vector<Label> labels;			// same order
+	std::vector<LabelBlock> blocks;		// empty until the next Layout() after a Clear()
+	std::vector<glm::vec3> offsets;		// of each position from its block's centre
+	std::string text;			// all names back to back
+	size_t splitCount;			// labels in the blocks buildBlocks() made, the ones added since follow
+
+	GlyphAtlas& atlas;
+	unsigned int VAO;
+	unsigned int glyphBuffer;
+	size_t glyphCapacity;
+	glm::vec2 viewport;
+
+	// per frame, kept to avoid allocations
+	std::vector<Candidate> cells;
+	std::vector<Candidate> survivors;
+	std::vector<uint8_t> occupied;
+	std::vector<LabelGlyph> glyphs;
+	size_t placedCount;
+
+	// median splits along the longest axis until every block holds LABEL_BLOCK_SIZE or fewer
+	void buildBlocks()
+	{
+		std::vector<uint32_t> order(positions.size());
+
+		for (size_t i = 0; i < order.size(); i++)
+			order[i] = (uint32_t)i;
+
+		split(order, 0, (uint32_t)order.size());
+
+		std::vector<glm::dvec3> sortedPositions(positions.size());
+		std::vector<Label> sortedLabels(labels.size());
+
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			sortedPositions[i] = positions[order[i]];
+			sortedLabels[i] = labels[order[i]];
+		}
+
+		positions.swap(sortedPositions);
+		labels.swap(sortedLabels);
+		offsets.resize(positions.size());
+		splitCount = positions.size();
+
+		for (LabelBlock& block : blocks)
+			measure(block);
+	}
+
+	// centre, radius and member offsets of a block
+	void measure(LabelBlock& block)
+	{
+		glm::dvec3 low = positions[block.first];
+		glm::dvec3 high = low;
+
+		for (uint32_t i = block.first + 1; i < block.first + block.count; i++)
+		{
+			low = glm::min(low, positions[i]);
+			high = glm::max(high, positions[i]);
+		}
+
+		block.center = (low + high) * 0.5;
+		double radius = 0.0;
+
+		for (uint32_t i = block.first; i < block.first + block.count; i++)
+		{
+			glm::dvec3 offset = positions[i] - block.center;
+			offsets[i] = glm::vec3(offset);
+			radius = std::max(radius, glm::length(offset));
+		}
+
+		// float offsets may round past the exact radius
+		block.radius = (float)radius * 1.0001f;
+	}
+
+	void split(std::vector<uint32_t>& order, uint32_t first, uint32_t count)
+	{
+		if (count <= LABEL_BLOCK_SIZE)
+		{
+			blocks.push_back(LabelBlock{ glm::dvec3(0.0), 0.0f, first, count });
+			return;
+		}
+
+		glm::dvec3 low = positions[order[first]];
+		glm::dvec3 high = low;
+
+		for (uint32_t i = first + 1; i < first + count; i++)
+		{
+			low = glm::min(low, positions[order[i]]);
+			high = glm::max(high, positions[order[i]]);
+		}
+
+		glm::dvec3 extent = high - low;
+		int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+		uint32_t half = count / 2;
+
+		std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count, [&](uint32_t a, uint32_t b) {
+			return positions[a][axis] < positions[b][axis];
+		});
+
+		split(order, first, half);
+		split(order, first + half, count - half);
+	}
+};
+
+#endif
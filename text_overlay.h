@@ -0,0 +1,130 @@
+#ifndef TEXT_OVERLAY_H
+#define TEXT_OVERLAY_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "gl_state.h"
+#include "gl_resources.h"
+#include "glyph_font.h"
+#include "text_labels.h"
+
+#include <vector>
+#include <string>
+
+// Lines of text in the top left corner of the screen, drawn with the same GlyphAtlas and shaders
+// (text.vert / text.frag) as TextLabels. The glyphs only change with the text, so drawing an
+// unchanged overlay uploads nothing.
+class TextOverlay
+{
+public:
+	float fontSize = 14.0f;		// pixels from the top of a capital to the baseline
+	float margin = 12.0f;		// pixels from the corner
+	glm::vec4 color = glm::vec4(1.0f, 0.85f, 0.6f, 1.0f);
+
+	// the atlas must outlive the overlay
+	TextOverlay(GlyphAtlas& atlas) : atlas(atlas), VAO(0), glyphBuffer(0), glyphCapacity(0)
+	{
+	}
+
+	~TextOverlay()
+	{
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &glyphBuffer);
+	}
+
+	TextOverlay(const TextOverlay&) = delete;
+	TextOverlay& operator=(const TextOverlay&) = delete;
+
+	// lines separated by '\n'
+	void SetText(const std::string& newText)
+	{
+		if (newText == text)
+			return;
+
+		text = newText;
+		glyphs.clear();
+
+		float pixel = fontSize / GLYPH_FONT_HEIGHT;
+		float advance = pixel * (GLYPH_FONT_WIDTH + 1);
+		float lineHeight = pixel * (GLYPH_FONT_HEIGHT + 3);
+		float padding = pixel * GLYPH_ATLAS_PADDING / GLYPH_ATLAS_SCALE;
+		uint32_t packedColor = PackGlyphColor(color);
+
+		int column = 0;
+		int line = 0;
+
+		for (char c : text)
+		{
+			if (c == '\n')
+			{
+				column = 0;
+				line++;
+				continue;
+			}
+
+			if (c != ' ')
+			{
+				LabelGlyph glyph;
+				glyph.x = margin + advance * column - padding;
+				glyph.y = margin + lineHeight * line - padding;
+				glyph.glyph = (uint32_t)GlyphIndex((unsigned char)c);
+				glyph.color = packedColor;
+				glyphs.push_back(glyph);
+			}
+
+			column++;
+		}
+
+		if (glyphs.empty())
+			return;
+
+		size_t bytes = glyphs.size() * sizeof(LabelGlyph);
+
+		if (bytes > glyphCapacity)
+		{
+			glDeleteBuffers(1, &glyphBuffer);
+			glyphCapacity = bytes * 2;
+			glyphBuffer = CreateBuffer(glyphCapacity, NULL, GL_DYNAMIC_STORAGE_BIT);
+
+			VertexArrayBuilder builder(VAO);
+			builder.Buffer(0, glyphBuffer, sizeof(LabelGlyph), 1);
+			builder.Attribute(0, 0, 2, GL_FLOAT, GL_FALSE, offsetof(LabelGlyph, x));
+			builder.IntegerAttribute(1, 0, 1, GL_UNSIGNED_INT, offsetof(LabelGlyph, glyph));
+			builder.Attribute(2, 0, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(LabelGlyph, color));
+			VAO = builder.Finish();
+		}
+
+		UpdateBuffer(glyphBuffer, 0, bytes, glyphs.data());
+	}
+
+	// onto whatever is bound, viewport in pixels
+	void Draw(Shader& shader, int width, int height)
+	{
+		if (glyphs.empty() || width <= 0 || height <= 0)
+			return;
+
+		atlas.Bind(shader, glm::vec2((float)width, (float)height), fontSize);
+
+		glState.Enable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		glState.BindVertexArray(VAO);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)glyphs.size());
+
+		glState.Disable(GL_BLEND);
+	}
+
+private:
+	std::string text;
+	std::vector<LabelGlyph> glyphs;
+
+	GlyphAtlas& atlas;
+	unsigned int VAO;
+	unsigned int glyphBuffer;
+	size_t glyphCapacity;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef TRAVEL_PATH_H
+#define TRAVEL_PATH_H
+
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "polyline.h"
+#include "jump_history.h"
+
+// The commander's path through a JumpHistory, one polyline segment per jump in history order so
+// that the path up to any moment is a prefix. Sync() appends only the jumps made since the last
+// one, a history of hundreds of thousands of jumps is uploaded once and then grows a few segments
+// at a time.
+class TravelPath
+{
+public:
+	TravelPath() : synced(0)
+	{
+		line.color = glm::vec3(1.0f, 0.6f, 0.2f);
+		line.width = 2.0f;
+	}
+
+	// jumps appended to history since the last call
+	size_t Sync(const JumpHistory& history)
+	{
+		size_t first = synced;
+
+		for (; synced < history.GetJumpCount(); synced++)
+		{
+			// a jump from nowhere known is a dot where it arrived
+			const JumpRecord& jump = history.GetJump(synced);
+			const glm::dvec3& to = history.GetPosition(jump.to);
+			line.Append(jump.from == JUMP_HISTORY_NONE ? to : history.GetPosition(jump.from), to);
+		}
+
+		line.Flush();
+		return synced - first;
+	}
+
+	// The first jumps of the history, the last of them only lastProgress of the way. eye in light
+	// years, mapScale render units per light year, viewport in pixels.
+	void Draw(Shader& shader, const glm::dvec3& eye, double mapScale, const glm::vec2& viewport, size_t jumps = (size_t)-1, float lastProgress = 1.0f)
+	{
+		line.Draw(shader, eye, mapScale, viewport, jumps, lastProgress);
+	}
+
+	Polyline& GetLine() { return line; }
+
+private:
+	Polyline line;
+	size_t synced;	// jumps in line
+};
+
+#endif
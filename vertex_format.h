@@ -0,0 +1,192 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "gl_resources.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+// Vertex as it comes out of the importer. Attribute locations in every shader that draws meshes
+// follow the member order: 0 position, 1 normal, 2 texcoords, 3 tangent, 4 bitangent.
+struct Vertex {
+	glm::vec3 Position;
+	glm::vec3 Normal;
+	glm::vec2 TexCoords;
+	glm::vec3 Tangent;
+	glm::vec3 Bitangent;
+};
+
+enum VertexAttributes : unsigned int {
+	VERTEX_POSITION		= 1 << 0,
+	VERTEX_NORMAL		= 1 << 1,
+	VERTEX_TEXCOORDS	= 1 << 2,
+	VERTEX_TANGENT		= 1 << 3,
+	VERTEX_BITANGENT	= 1 << 4,
+	VERTEX_ALL			= 0x1F
+};
+
+// Attributes the linked program actually reads, by location. Inputs the compiler dropped
+// because they do not reach an output are not active and not reported.
+inline unsigned int ReflectVertexAttributes(GLuint program)
+{
+	GLint count = 0;
+	glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+
+	unsigned int attributes = 0;
+
+	for (GLint i = 0; i < count; i++)
+	{
+		char name[256];
+		GLint size;
+		GLenum type;
+		glGetActiveAttrib(program, i, sizeof(name), NULL, &size, &type, name);
+
+		GLint location = glGetAttribLocation(program, name);
+
+		if (location >= 0 && location < 5)
+			attributes |= 1u << location;
+	}
+
+	return attributes | VERTEX_POSITION;
+}
+
+// Packed layout for a set of attributes. All conversions are done by the vertex fetch hardware,
+// shaders keep declaring vec3/vec2 inputs:
+//   position   4 x GL_SHORT normalized, relative to the mesh bounds (w unused)
+//   normal     GL_INT_2_10_10_10_REV normalized
+//   texcoords  2 x GL_HALF_FLOAT
+//   tangent    GL_INT_2_10_10_10_REV normalized
+//   bitangent  GL_INT_2_10_10_10_REV normalized
+// Positions come out in [-1, 1] and need dequantize (set as "meshDequantize") to get back to
+// model space.
+struct VertexFormat {
+	unsigned int attributes;
+	GLsizei stride;
+	size_t offsets[5];
+	glm::vec3 boundsCenter;
+	glm::vec3 boundsHalfExtent;
+	glm::mat4 dequantize;
+
+	static VertexFormat Compact(unsigned int attributes, const Vertex* vertices, size_t count)
+	{
+		VertexFormat format;
+		format.attributes = attributes | VERTEX_POSITION;
+
+		const size_t sizes[5] = { 4 * sizeof(int16_t), sizeof(uint32_t), 2 * sizeof(uint16_t), sizeof(uint32_t), sizeof(uint32_t) };
+		size_t offset = 0;
+
+		for (int i = 0; i < 5; i++)
+		{
+			format.offsets[i] = offset;
+
+			if (format.attributes & (1u << i))
+				offset += sizes[i];
+		}
+
+		format.stride = (GLsizei)offset;
+
+		glm::vec3 lo(0.0f), hi(0.0f);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			lo = i == 0 ? vertices[i].Position : glm::min(lo, vertices[i].Position);
+			hi = i == 0 ? vertices[i].Position : glm::max(hi, vertices[i].Position);
+		}
+
+		format.boundsCenter = (lo + hi) * 0.5f;
+		format.boundsHalfExtent = glm::max((hi - lo) * 0.5f, glm::vec3(1e-6f));
+		format.dequantize = glm::scale(glm::translate(glm::mat4(1.0f), format.boundsCenter), format.boundsHalfExtent);
+
+		return format;
+	}
+
+	void Pack(const Vertex* vertices, size_t count, std::vector<unsigned char>& out) const
+	{
+		size_t start = out.size();
+		out.resize(start + count * stride);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			unsigned char* dst = out.data() + start + i * stride;
+			const Vertex& v = vertices[i];
+
+			glm::vec3 p = (v.Position - boundsCenter) / boundsHalfExtent;
+			int16_t position[4] = { packSnorm16(p.x), packSnorm16(p.y), packSnorm16(p.z), 0 };
+			std::memcpy(dst + offsets[0], position, sizeof(position));
+
+			if (attributes & VERTEX_NORMAL)
+				storeU32(dst + offsets[1], packSnorm1010102(v.Normal));
+
+			if (attributes & VERTEX_TEXCOORDS)
+			{
+				uint16_t uv[2] = { glm::packHalf1x16(v.TexCoords.x), glm::packHalf1x16(v.TexCoords.y) };
+				std::memcpy(dst + offsets[2], uv, sizeof(uv));
+			}
+
+			if (attributes & VERTEX_TANGENT)
+				storeU32(dst + offsets[3], packSnorm1010102(v.Tangent));
+
+			if (attributes & VERTEX_BITANGENT)
+				storeU32(dst + offsets[4], packSnorm1010102(v.Bitangent));
+		}
+	}
+
+	// packed vertices in vertexBuffer, read through binding 0
+	void SetupAttributes(VertexArrayBuilder& builder, GLuint vertexBuffer) const
+	{
+		builder.Buffer(0, vertexBuffer, stride);
+		builder.Attribute(0, 0, 4, GL_SHORT, GL_TRUE, offsets[0]);
+
+		if (attributes & VERTEX_NORMAL)
+			builder.Attribute(1, 0, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsets[1]);
+
+		if (attributes & VERTEX_TEXCOORDS)
+			builder.Attribute(2, 0, 2, GL_HALF_FLOAT, GL_FALSE, offsets[2]);
+
+		if (attributes & VERTEX_TANGENT)
+			builder.Attribute(3, 0, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsets[3]);
+
+		if (attributes & VERTEX_BITANGENT)
+			builder.Attribute(4, 0, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsets[4]);
+	}
+
+	// plain Vertex structs in vertexBuffer, the layout before any packing
+	static void SetupFloatAttributes(VertexArrayBuilder& builder, GLuint vertexBuffer)
+	{
+		builder.Buffer(0, vertexBuffer, sizeof(Vertex));
+		builder.Attribute(0, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Position));
+		builder.Attribute(1, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Normal));
+		builder.Attribute(2, 0, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, TexCoords));
+		builder.Attribute(3, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Tangent));
+		builder.Attribute(4, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Bitangent));
+	}
+
+	static int16_t packSnorm16(float v)
+	{
+		return (int16_t)glm::round(glm::clamp(v, -1.0f, 1.0f) * 32767.0f);
+	}
+
+	static uint32_t packSnorm1010102(const glm::vec3& v)
+	{
+		glm::vec3 n = glm::clamp(v, -1.0f, 1.0f) * 511.0f;
+		uint32_t x = (uint32_t)(int32_t)glm::round(n.x) & 0x3FF;
+		uint32_t y = (uint32_t)(int32_t)glm::round(n.y) & 0x3FF;
+		uint32_t z = (uint32_t)(int32_t)glm::round(n.z) & 0x3FF;
+
+		return x | (y << 10) | (z << 20);
+	}
+
+	static void storeU32(unsigned char* dst, uint32_t value)
+	{
+		std::memcpy(dst, &value, sizeof(value));
+	}
+};
+
+#endif